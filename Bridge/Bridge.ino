@@ -1,11 +1,14 @@
 #include <NimBLEDevice.h>
 #include <WiFi.h>
-#include <Preferences.h>
 #include <ArduinoJson.h>
 #include <nvs_flash.h>  // Added for full NVS wipe
 #include "bme_sensor.h"
 #include "rtc_ds1307.h"
 #include "logger.h"
+#include "uart_link.h"
+#include "ble_notify.h"
+#include "config_store.h"
+#include "bridge_core.h"
 
 #define SD_CS 3
 #define SD_SCK 8
@@ -13,7 +16,8 @@
 #define SD_MISO 4
 
 // --- Configuration ---
-static const int UART_BAUD_RATE = 115200;
+static const int UART_BAUD_RATE = LINK_DEFAULT_BAUD;   // boot rate, both sides
+static const uint32_t UART_FAST_BAUD = 921600;         // negotiated after boot
 
 //***This pinout is for Bridge when target MCU is ESP32C6***
 
@@ -36,29 +40,37 @@ static const char *SERVICE_UUID = "4fafc201-1fb5-459e-8fcc-c5c9c331914b";
 static const char *CHAR_UUID = "beb5483e-36e1-4688-b7f5-ea07361b26a8";
 static const char *DEVICE_NAME = "ESP32C6-Thread-Bridge";
 
-static const size_t UART_MAX_LINE_LEN = 512;
-static const uint32_t ADD_RESULT_TIMEOUT_MS = 15000;  // Bridge-side failsafe
+static const uint32_t PROV_WIFI_TIMEOUT_MS = 10000;   // Wi-Fi association window for PROVISION
+static const uint32_t PROV_FORM_TIMEOUT_MS = 30000;   // FORM_NET -> NETWORK_FORMED window
+static const uint16_t BLE_PREFERRED_MTU = 247;        // requested on connect; notifications pack up to MTU-3
+static const uint64_t LOG_PREALLOC_BYTES = 8ULL * 1024 * 1024;  // contiguous space for new log files
+static const uint16_t BRIDGE_SENSOR_ID = 1;  // LogRecord.sensorId for the on-board BME680
 
 // --- Authentication Constants ---
-static const char *AUTH_NAMESPACE = "auth_config";
 static const char *DEFAULT_PIN = "123456";
 
 // --- Globals ---
 NimBLEServer *pServer = nullptr;
 NimBLEService *pService = nullptr;
 NimBLECharacteristic *pCharacteristic = nullptr;
-Preferences preferences;
 
-volatile bool bleClientConnected = false;
-volatile bool bleClientSecured = false;        // OS-Level Encryption (Just Works)
-volatile bool isSessionAuthenticated = false;  // App-Level Authentication
 bool isCommissionerMode = false;
 // State tracked via Switch
 
-// Pending command tracking
-static bool g_pendingAdd = false;
-static String g_pendingEui64;
-static uint32_t g_pendingDeadlineMs = 0;
+// Provisioning state machine: PROVISION returns from the BLE callback at
+// once; Wi-Fi events and loop() drive the rest.
+enum ProvState {
+  PROV_IDLE,
+  PROV_WIFI_CONNECTING,  // WiFi.begin() issued, waiting for an IP
+  PROV_FORMING,          // FORM_NET sent, waiting for NETWORK_FORMED
+};
+static ProvState g_provState = PROV_IDLE;
+static char g_provNetName[33];
+static uint32_t g_provStartMs = 0;
+static uint32_t g_provWifiMs = 0;               // time to IP, for the latency report
+static uint8_t g_provFormReqId = 0;             // link request id of FORM_NET
+static volatile bool g_provGotIp = false;       // set from the Wi-Fi event task
+static volatile uint8_t g_provAuthFailReason = 0;
 
 // --- Reset Button Tracking ---
 uint32_t resetBtnPressTime = 0;
@@ -68,22 +80,14 @@ Logger logger(SD_CS, SD_MISO, SD_MOSI, SD_SCK);
 
 // --- BLE Notification Helper ---
 static void bleNotifyLine(const String &line) {
-  if (!bleClientConnected || !bleClientSecured || pCharacteristic == nullptr) return;
-  std::string s(line.c_str());
-  pCharacteristic->setValue(s);
-  pCharacteristic->notify();
-}
-
-// --- Utils ---
-static bool isHexChar(char c) {
-  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+  bridgeCoreNotify(line.c_str());
 }
 
-static bool looksLikeEui64(const String &s) {
-  if (s.length() != 16) return false;
-  for (int i = 0; i < 16; i++)
-    if (!isHexChar(s[i])) return false;
-  return true;
+// Send hook for the notification queue; false asks it to retry later
+static bool bleSendNotification(const uint8_t *data, size_t len) {
+  if (!bridgeCoreIsConnected() || pCharacteristic == nullptr) return true;  // nobody to send to
+  pCharacteristic->setValue(data, len);
+  return pCharacteristic->notify();
 }
 
 // --- Provisioning Logic (JSON Parsing & Wi-Fi) ---
@@ -109,130 +113,166 @@ void handleProvisioning(const String &jsonPayload) {
 
   Serial.printf("[PROVISION] SSID: %s, Zone: %s, NetName: %s\n", ssid, zone, netName);
 
-  // 1. Save to NVS
-  preferences.begin("gateway_config", false);
-  preferences.putString("ssid", ssid);
-  preferences.putString("pass", pass);
-  preferences.putString("zone", zone ? zone : "Default");
-  preferences.end();
+  // 1. Save to config (written to NVS from loop)
+  if (!configSetWifi(ssid, pass, zone)) {
+    bleNotifyLine("ERR JSON_INVALID");
+    return;
+  }
 
-  // 2. Connect to Wi-Fi
+  // 2. Start Wi-Fi; the result arrives through onWifiEvent()/provisioningUpdate()
   Serial.printf("[WIFI] Connecting to %s...\n", ssid);
   bleNotifyLine("STATUS CONNECTING_WIFI");
 
-  WiFi.begin(ssid, pass);
-
-  int retries = 0;
-  while (WiFi.status() != WL_CONNECTED && retries < 20) {
-    delay(500);
-    retries++;
-  }
+  strlcpy(g_provNetName, netName, sizeof(g_provNetName));
+  g_provGotIp = false;
+  g_provAuthFailReason = 0;
+  g_provStartMs = millis();
+  g_provState = PROV_WIFI_CONNECTING;
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("[WIFI] Connected!");
-    bleNotifyLine("WIFI_CONNECTED");
+  WiFi.disconnect();
+  WiFi.begin(ssid, pass);
+}
 
-    // 3. Command Commissioner (Air-Gapped!)
-    Serial1.printf("FORM_NET %s\n", netName);
-    Serial1.flush();
-    Serial.println("[UART] Sent FORM_NET command");
-  } else {
-    Serial.println("[WIFI] Failed to connect.");
-    bleNotifyLine("ERR WIFI_AUTH");
+// Runs on the Arduino Wi-Fi event task: only record what happened.
+static void onWifiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      g_provGotIp = true;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED: {
+      uint8_t reason = info.wifi_sta_disconnected.reason;
+      // Wrong password shows up as one of these; other reasons (AP not
+      // found yet, beacon loss) are left to the auto-reconnect and timeout.
+      if (reason == WIFI_REASON_AUTH_FAIL || reason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT ||
+          reason == WIFI_REASON_HANDSHAKE_TIMEOUT) {
+        g_provAuthFailReason = reason;
+      }
+      break;
+    }
+    default:
+      break;
   }
 }
 
-// --- Parsing Pending Adds ---
-static void parsePendingFromCommand(const String &cmdLine) {
-  String line = cmdLine;
-  line.trim();
-  if (!line.startsWith("add ")) return;
-
-  int firstSpace = line.indexOf(' ');
-  int secondSpace = line.indexOf(' ', firstSpace + 1);
-  if (secondSpace < 0) return;  // "add <EUI64> <Key>|<Sig>"
-
-  String eui = line.substring(firstSpace + 1, secondSpace);
-  eui.trim();
-
-  if (!looksLikeEui64(eui)) return;
-
-  g_pendingAdd = true;
-  g_pendingEui64 = eui;
-  g_pendingDeadlineMs = millis() + ADD_RESULT_TIMEOUT_MS;
-
-  Serial.print("[STATE] Pending add set for EUI64=");
-  Serial.println(g_pendingEui64);
+static void provisioningFail(const char *err) {
+  Serial.printf("[PROVISION] Failed after %lums: %s\n", (unsigned long)(millis() - g_provStartMs), err);
+  bleNotifyLine(err);
+  g_provState = PROV_IDLE;
 }
 
-// --- UART Handlers (UPDATED V1.2 LOGIC) ---
-static void handleCommissionerLine(const String &line) {
-  // 0. FILTER: Ignore self-echoed commands
-  if (line.startsWith("CMD:")) return;
+// Advances provisioning from loop(); never blocks.
+static void provisioningUpdate() {
+  switch (g_provState) {
+    case PROV_WIFI_CONNECTING:
+      if (g_provGotIp) {
+        g_provWifiMs = millis() - g_provStartMs;
+        Serial.printf("[WIFI] Connected in %lums\n", (unsigned long)g_provWifiMs);
+        bleNotifyLine("WIFI_CONNECTED");
+
+        // 3. Command Commissioner (Air-Gapped!)
+        char cmd[64];
+        snprintf(cmd, sizeof(cmd), "FORM_NET %s", g_provNetName);
+        g_provFormReqId = uartLinkSendCommand(cmd);
+        if (g_provFormReqId == 0) {
+          provisioningFail("ERR FORM_NET LINK");
+          break;
+        }
+        Serial.printf("[UART] Sent FORM_NET command #%u\n", g_provFormReqId);
+        g_provState = PROV_FORMING;
+      } else if (g_provAuthFailReason != 0) {
+        Serial.printf("[WIFI] Auth failed (reason %u)\n", g_provAuthFailReason);
+        WiFi.disconnect();
+        provisioningFail("ERR WIFI_AUTH");
+      } else if (millis() - g_provStartMs >= PROV_WIFI_TIMEOUT_MS) {
+        Serial.println("[WIFI] Failed to connect.");
+        WiFi.disconnect();
+        provisioningFail("ERR WIFI_AUTH");
+      }
+      break;
 
-  // Forward raw logs for debug
-  bleNotifyLine(line);
+    case PROV_FORMING:
+      if (millis() - g_provStartMs >= g_provWifiMs + PROV_FORM_TIMEOUT_MS) {
+        provisioningFail("ERR PROVISION TIMEOUT");
+      }
+      break;
 
-  // 1. Check for Network Formation
-  if (line.indexOf("NETWORK_FORMED") >= 0) {
-    bleNotifyLine("ACK PROVISION SUCCESS");
-    return;
+    case PROV_IDLE:
+      break;
   }
+}
 
-  // If we aren't waiting for a specific joiner, we are done
-  if (!g_pendingAdd) return;
-
-  // 2. Check for Joiner Success (Standard OpenThread log or Custom)
-  if (line.indexOf("JOINER_ADDED") >= 0 || line.indexOf("JOINER_EVENT CONNECTED") >= 0) {
-    String ack = "ACK ADD " + g_pendingEui64;
-    Serial.print("[PROTO] ");
-    Serial.println(ack);
-    bleNotifyLine(ack);
-
-    g_pendingAdd = false;
-    g_pendingEui64 = "";
+// The Commissioner refused FORM_NET ("ERROR FORM_NET BUSY", "ERROR LOCK_TIMEOUT")
+// or accepted it and then failed to form ("FORM_FAILED <otError>" event):
+// fail now with its reason instead of waiting out PROV_FORM_TIMEOUT_MS.
+static void provisioningOnLinkFrame(uint8_t type, uint8_t id, const char *payload) {
+  if (g_provState != PROV_FORMING) return;
+  char err[64];
+  if (type == LINK_MSG_EVENT && strncmp(payload, "FORM_FAILED ", 12) == 0) {
+    snprintf(err, sizeof(err), "ERR FORM_NET FORM_FAILED %s", payload + 12);
+    provisioningFail(err);
     return;
   }
+  if (id != g_provFormReqId || type != LINK_MSG_RSP_ERR) return;
+  const char *reason = strrchr(payload, ' ');
+  snprintf(err, sizeof(err), "ERR FORM_NET %s", reason ? reason + 1 : "commissioner_error");
+  provisioningFail(err);
+}
 
-  // --- NEW: Check for Joiner Removal (Timeout) ---
-  // Matches the new "JOINER_EVENT REMOVED" log we added in commissioner.c
-  if (line.indexOf("JOINER_EVENT REMOVED") >= 0) {
-    String err = "ERR ADD " + g_pendingEui64 + " timeout";
-    Serial.print("[PROTO] ");
-    Serial.println(err);
-    bleNotifyLine(err);
+// Called when the Commissioner reports NETWORK_FORMED
+static void provisioningComplete() {
+  if (g_provState != PROV_FORMING) return;
+  uint32_t totalMs = millis() - g_provStartMs;
+  char buf[64];
+  snprintf(buf, sizeof(buf), "PROVISION_TIME wifi=%lums total=%lums",
+           (unsigned long)g_provWifiMs, (unsigned long)totalMs);
+  Serial.printf("[PROVISION] %s\n", buf);
+  bleNotifyLine(buf);
+  g_provState = PROV_IDLE;
+}
 
-    g_pendingAdd = false;
-    g_pendingEui64 = "";
+// --- Core Hooks ---
+static uint8_t coreSendCommand(const char *cmd) {
+  return uartLinkSendCommand(cmd);
+}
+
+static void coreProvision(const char *json) {
+  if (g_provState != PROV_IDLE) {
+    bleNotifyLine("ERR PROVISION BUSY");
     return;
   }
+  handleProvisioning(json);
+}
 
-  // 3. Check for Generic Errors
-  if (line.indexOf("ERROR") >= 0 || line.indexOf("FAILED") >= 0) {
-    String err = "ERR ADD " + g_pendingEui64 + " commissioner_error";
-    Serial.print("[PROTO] ");
-    Serial.println(err);
-    bleNotifyLine(err);
+static void coreFormatLinkStats(char *buf, size_t len) {
+  UartLinkStats us = uartLinkGetStats();
+  snprintf(buf, len,
+           "STATS UART baud=%lu frames=%lu crc=%lu lines=%lu ovf=%lu full=%lu drop=%lu long=%lu lat=%luus max=%luus",
+           (unsigned long)us.baud, (unsigned long)us.frames, (unsigned long)us.crcErrors,
+           (unsigned long)us.lines, (unsigned long)us.fifoOverflows,
+           (unsigned long)us.bufferFull, (unsigned long)us.ringDrops,
+           (unsigned long)us.tooLong, (unsigned long)us.lastLatencyUs,
+           (unsigned long)us.maxLatencyUs);
+}
 
-    g_pendingAdd = false;
-    g_pendingEui64 = "";
-    return;
-  }
+static void coreFormatLogStats(char *buf, size_t len) {
+  LoggerStats ls = logger.getStats();
+  snprintf(buf, len,
+           "STATS SD q=%lu/%lu written=%lu dropped=%lu err=%lu commits=%lu commit=%luus max=%luus",
+           (unsigned long)ls.queued, (unsigned long)ls.queueHighWater,
+           (unsigned long)ls.written, (unsigned long)ls.dropped,
+           (unsigned long)ls.writeErrors, (unsigned long)ls.commits,
+           (unsigned long)ls.lastCommitUs, (unsigned long)ls.maxCommitUs);
 }
 
 // --- BLE Callbacks ---
 class BridgeServerCallbacks : public NimBLEServerCallbacks {
   void onConnect(NimBLEServer *server, NimBLEConnInfo &connInfo) override {
-    bleClientConnected = true;
-    bleClientSecured = connInfo.isEncrypted();
-    isSessionAuthenticated = false;  // Reset app-level auth on new connection
+    bridgeCoreOnConnect(connInfo.isEncrypted());
     Serial.printf("[BLE] Connected: %s\n", connInfo.getAddress().toString().c_str());
   }
 
   void onDisconnect(NimBLEServer *server, NimBLEConnInfo &connInfo, int reason) override {
-    bleClientConnected = false;
-    bleClientSecured = false;
-    isSessionAuthenticated = false;  // Clear session state
+    bridgeCoreOnDisconnect();
     Serial.println("[BLE] Disconnected.");
 
     if (isCommissionerMode) {
@@ -241,138 +281,27 @@ class BridgeServerCallbacks : public NimBLEServerCallbacks {
     }
   }
 
+  void onMTUChange(uint16_t mtu, NimBLEConnInfo &connInfo) override {
+    bleNotifySetMtu(mtu);
+    Serial.printf("[BLE] MTU: %u\n", mtu);
+  }
+
   void onAuthenticationComplete(NimBLEConnInfo &connInfo) override {
     if (!connInfo.isEncrypted()) {
       Serial.println("[BLE] Auth failed/unencrypted. Disconnecting.");
       NimBLEDevice::getServer()->disconnect(connInfo.getConnHandle());
-      bleClientSecured = false;
+      bridgeCoreOnSecured(false);
       return;
     }
-    bleClientSecured = true;
     Serial.println("[BLE] Secured Link Established (OS-Level).");
-    bleNotifyLine("BRIDGE READY");
+    bridgeCoreOnSecured(true);
   }
 };
 
 class BridgeCharacteristicCallbacks : public NimBLECharacteristicCallbacks {
   void onWrite(NimBLECharacteristic *pChar, NimBLEConnInfo &connInfo) override {
-    // 1. OS-Level Security Check
-    if (!bleClientSecured) {
-      Serial.println("[BLE] Rejected write (Link Not Secured)");
-      return;
-    }
-
-    std::string value = pChar->getValue();
-    if (value.empty()) return;
-    String cmdLine(value.c_str());
-    cmdLine.trim();  // Sanitize input
-
-    // ==========================================
-    // 2. APP-LEVEL AUTHENTICATION LOGIC
-    // ==========================================
-
-    // Command: STATUS?
-    if (cmdLine == "STATUS?") {
-      preferences.begin(AUTH_NAMESPACE, true);
-      bool isSetup = preferences.getBool("is_setup", false);
-      preferences.end();
-
-      if (isSetup) {
-        bleNotifyLine("STATUS|SECURED");
-      } else {
-        bleNotifyLine("STATUS|SETUP_PENDING");
-      }
-      return;
-    }
-
-    // Command: AUTH|<Pin>
-    if (cmdLine.startsWith("AUTH|")) {
-      String attemptPin = cmdLine.substring(5);
-
-      preferences.begin(AUTH_NAMESPACE, true);
-      String savedPin = preferences.getString("pin", DEFAULT_PIN);
-      preferences.end();
-
-      if (attemptPin == savedPin) {
-        isSessionAuthenticated = true;
-        bleNotifyLine("ACK AUTH SUCCESS");
-        Serial.println("[AUTH] Session Unlocked");
-      } else {
-        bleNotifyLine("ERR AUTH FAILED");
-        Serial.println("[AUTH] Failed login attempt");
-      }
-      return;
-    }
-
-    // Command: SETPIN|<OldPin>|<NewPin>
-    if (cmdLine.startsWith("SETPIN|")) {
-      int firstPipe = cmdLine.indexOf('|');
-      int secondPipe = cmdLine.indexOf('|', firstPipe + 1);
-
-      if (firstPipe > 0 && secondPipe > firstPipe) {
-        String oldPin = cmdLine.substring(firstPipe + 1, secondPipe);
-        String newPin = cmdLine.substring(secondPipe + 1);
-
-        preferences.begin(AUTH_NAMESPACE, false);
-        String savedPin = preferences.getString("pin", DEFAULT_PIN);
-
-        if (oldPin == savedPin) {
-          preferences.putString("pin", newPin);
-          preferences.putBool("is_setup", true);
-          isSessionAuthenticated = true;  // Auto-login after setup
-          bleNotifyLine("ACK SETPIN SUCCESS");
-          Serial.println("[AUTH] PIN updated and session unlocked");
-        } else {
-          bleNotifyLine("ERR SETPIN FAILED");
-          Serial.println("[AUTH] SETPIN failed: Old PIN mismatch");
-        }
-        preferences.end();
-      } else {
-        bleNotifyLine("ERR SETPIN FORMAT");
-      }
-      return;
-    }
-
-    // ==========================================
-    // 3. THE GATEKEEPER
-    // ==========================================
-    // Any commands beyond this point require the session to be authenticated.
-    if (!isSessionAuthenticated) {
-      Serial.println("[BLE] Rejected write (App-Level Unauthenticated)");
-      bleNotifyLine("ERR UNAUTHENTICATED");
-      return;
-    }
-
-    // ==========================================
-    // 4. SECURED COMMANDS
-    // ==========================================
-
-    // A. PROVISION
-    if (cmdLine.startsWith("PROVISION|")) {
-      Serial.println("[BLE] Received Provisioning Payload");
-      String jsonPart = cmdLine.substring(10);
-      handleProvisioning(jsonPart);
-      return;
-    }
-
-    // B. ADD (Busy Check)
-    if (g_pendingAdd && cmdLine.startsWith("add ")) {
-      Serial.println("[BLE] Rejecting add: Busy");
-      bleNotifyLine("ERR BUSY");
-      return;
-    }
-
-    // C. Forward to UART
-    // Forward the FULL command (including the |hash) to the Commissioner
-    if (!cmdLine.endsWith("\n")) {
-      cmdLine += "\n";
-    }
-
-    parsePendingFromCommand(cmdLine);
-
-    Serial1.print(cmdLine);
-    Serial1.flush();
-    Serial.printf("[UART] Forwarded full command (%d bytes)\n", cmdLine.length());
+    NimBLEAttValue value = pChar->getValue();
+    bridgeCoreOnBleWrite((const char *)value.data(), value.length());
   }
 };
 
@@ -380,6 +309,7 @@ class BridgeCharacteristicCallbacks : public NimBLECharacteristicCallbacks {
 void configureBLE() {
   NimBLEDevice::init(DEVICE_NAME);
   NimBLEDevice::setPower(ESP_PWR_LVL_P9);
+  NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
   NimBLEDevice::setSecurityAuth(true, false, true);
   NimBLEDevice::setSecurityIOCap(BLE_HS_IO_NO_INPUT_OUTPUT);
 
@@ -419,38 +349,57 @@ void deinitBLE() {
 // --- Main ---
 void setup() {
   Serial.begin(115200);
-  Serial1.begin(UART_BAUD_RATE, SERIAL_8N1, UART_RX_PIN, UART_TX_PIN);
+  uartLinkBegin(UART_BAUD_RATE, UART_RX_PIN, UART_TX_PIN);
+  uartLinkNegotiateBaud(UART_FAST_BAUD, 500);
+  bleNotifyBegin(bleSendNotification);
+
+  BridgeCoreHooks coreHooks = {};
+  coreHooks.sendCommand       = coreSendCommand;
+  coreHooks.provision         = coreProvision;
+  coreHooks.networkFormed     = provisioningComplete;
+  coreHooks.setSampleInterval = bmeSetInterval;
+  coreHooks.formatLinkStats   = coreFormatLinkStats;
+  coreHooks.formatLogStats    = coreFormatLogStats;
+  bridgeCoreBegin(coreHooks);
+
+  configBegin(DEFAULT_PIN);
+  BridgeConfig cfg = configGet();
 
   bmeInit();
+  bmeSetInterval(cfg.sampleIntervalMs);
   rtcInit();
 
   logger.begin();
-  logger.setFilename("/env_log.csv");
-  logger.writeHeader("Date,Time,TempC,Humidity,Pressure,VOC");
+  logger.setFilename("/env_log.bin");
+  logger.setPreallocate(LOG_PREALLOC_BYTES);
+
+  // Binary records (see hvac_log_record.h); export with tools/log_export
+  LogFileHeader logHeader;
+  log_header_init(&logHeader, BRIDGE_SENSOR_ID, rtcGetEpoch());
+  log_header_add_channel(&logHeader, "TempC", 100);  // 0.01 C
+  log_header_add_channel(&logHeader, "Hum",   100);  // 0.01 %RH
+  log_header_add_channel(&logHeader, "hPa",   10);   // 0.1 hPa
+  log_header_add_channel(&logHeader, "VOCk",  10);   // 0.1 kOhm
+  logger.openBinary(logHeader);
+
+  // SD writes run on their own task so loop() never waits on the card
+  LoggerAsyncConfig logCfg;
+  logCfg.queueDepth    = 32;
+  logCfg.commitRecords = 12;     // ~1 min of BME samples per sync
+  logCfg.commitMs      = 30000;
+  logger.startAsync(logCfg);
 
   pinMode(SWITCH_PIN, INPUT_PULLUP);
   pinMode(RESET_BTN_PIN, INPUT_PULLUP);
 
   Serial.println("\n[BOOT] Bridge Starting...");
 
-  // Initialize Authentication Defaults if first boot
-  preferences.begin(AUTH_NAMESPACE, false);
-  if (!preferences.isKey("is_setup")) {
-    Serial.println("[BOOT] First boot detected. Initializing Auth NVS.");
-    preferences.putBool("is_setup", false);
-    preferences.putString("pin", DEFAULT_PIN);
-  }
-  preferences.end();
-
-  // Load Wi-Fi Gateway Config
-  preferences.begin("gateway_config", true);
-  String savedSSID = preferences.getString("ssid", "");
-  String savedPass = preferences.getString("pass", "");
-  preferences.end();
+  WiFi.onEvent(onWifiEvent);
 
-  if (savedSSID.length() > 0) {
-    Serial.printf("[BOOT] Auto-connecting to WiFi: %s\n", savedSSID.c_str());
-    WiFi.begin(savedSSID.c_str(), savedPass.c_str());
+  // Wi-Fi Gateway Config (loaded by configBegin)
+  if (cfg.ssid[0] != '\0') {
+    Serial.printf("[BOOT] Auto-connecting to WiFi: %s\n", cfg.ssid);
+    WiFi.begin(cfg.ssid, cfg.pass);
   }
 }
 
@@ -472,8 +421,8 @@ void loop() {
       nvs_flash_init();
 
       // 2. Wipe the Commissioner via UART
-      Serial1.println("factoryreset");
-      Serial1.flush();
+      uartLinkSendCommand("factory_reset");
+      uartLinkFlush();
 
       Serial.println("[SYSTEM] NVS Cleared and Commissioner Reset command sent.");
       Serial.println("[SYSTEM] Rebooting in 2 seconds...\n");
@@ -491,9 +440,6 @@ void loop() {
     }
   }
 
-  static char lineBuf[UART_MAX_LINE_LEN];
-  static size_t lineLen = 0;
-
   // 1. Switch Logic
 
   bool switchState = digitalRead(SWITCH_PIN);
@@ -503,78 +449,69 @@ void loop() {
 
     Serial.println("[MODE] Switch ON -> Enter SETUP/COMMISSIONER Mode");
     configureBLE();
-    Serial1.println("commissioner_start");
+    uartLinkSendCommand("commissioner_start");
   } else if (switchState == LOW && isCommissionerMode) {
     isCommissionerMode = false;
 
     Serial.println("[MODE] Switch OFF -> Enter SECURE Mode");
     deinitBLE();
-    Serial1.println("commissioner_stop");
+    uartLinkSendCommand("commissioner_stop");
   }
 
-  // 2. UART Reading
-  while (Serial1.available() > 0) {
-    int ch = Serial1.read();
-
-    if (ch < 0) break;
-    if (ch == '\r') continue;
-
-    if (ch == '\n') {
-      if (lineLen == 0) continue;
-
-      lineBuf[lineLen] = '\0';
-      String line(lineBuf);
-
-      Serial.printf("[UART Rx] %s\n", lineBuf);
-      handleCommissionerLine(line);
-
-      lineLen = 0;
-
+  // 2. UART Reading (frames and text lines are assembled by the uart_link task)
+  static UartLinkMsg linkMsg;
+  while (uartLinkRead(linkMsg)) {
+    if (linkMsg.isFrame) {
+      Serial.printf("[UART Rx] #%u type=0x%02X %s\n", linkMsg.id, linkMsg.type, linkMsg.data);
+      provisioningOnLinkFrame(linkMsg.type, linkMsg.id, linkMsg.data);
+      bridgeCoreOnLinkFrame(linkMsg.type, linkMsg.id, linkMsg.data);
     } else {
-      if (lineLen < UART_MAX_LINE_LEN - 1) {
-        lineBuf[lineLen++] = (char)ch;
-
-      } else {
-        Serial.println("[UART] Overflow dropped");
-        lineLen = 0;
-      }
+      Serial.printf("[UART Rx] %s\n", linkMsg.data);
+      bridgeCoreOnLinkText(linkMsg.data);
     }
   }
 
-  // 3. Pending Timeout Check (Bridge failsafe)
-  // Only fires if we never got a "REMOVED" or "ADDED" message from Comm.
+  // 3. Provisioning progress (Wi-Fi events -> FORM_NET)
+  provisioningUpdate();
 
-  if (g_pendingAdd && (int32_t)(millis() - g_pendingDeadlineMs) >= 0) {
-    bleNotifyLine("ERR ADD TIMEOUT");
+  // 4. Pending-add timeouts and coalesced batch progress
+  bridgeCoreTick();
 
-    Serial.println("[PROTO] Timed out waiting for JOINER_ADDED");
-    g_pendingAdd = false;
-  }
+  // 5. Send queued BLE notifications
+  bleNotifyPump();
 
+  // 6. Persist configuration changes
+  configUpdate();
 
   //Update BME and log
   if (bmeUpdate()) {
+    static uint16_t logSeq = 0;
     BMEData data        = bmeGetData();
     RTCDateTime dt      = rtcGetDateTime();
 
-    String dateStr = dt.valid
-        ? (String(dt.day)   + "-" + String(dt.month)  + "-" + String(dt.year))
-        : "N/A";
-
-    String timeStr = dt.valid
-        ? (String(dt.hour)  + ":" + String(dt.minute) + ":" + String(dt.second))
-        : String(millis() / 1000) + "s";
-
-    String dataLine = String(data.temperature, 2) + "," +
-                      String(data.humidity,    2) + "," +
-                      String(data.pressure,    2) + "," +
-                      String(data.gas,         2);
-
-    if (logger.log(dateStr + "," + timeStr + "," + dataLine)) {
-        Serial.println("Logged: " + dateStr + " " + timeStr);
+    // Stack buffers only: this runs every sample for months, so no String
+    // temporaries that would fragment the heap next to NimBLE and Wi-Fi.
+    char stamp[RTC_TIMESTAMP_LEN];
+    rtcFormatTimestamp(dt, stamp, sizeof(stamp));
+
+    LogRecord rec = {};
+    rec.epoch        = dt.valid ? dt.epoch : millis() / 1000;
+    rec.sensorId     = BRIDGE_SENSOR_ID;
+    rec.seq          = logSeq++;
+    rec.flags        = dt.valid ? 0 : LOG_FLAG_UPTIME;
+    if (!data.valid) rec.flags |= LOG_FLAG_INVALID;
+    rec.channelCount = 4;
+    rec.ch[0]        = log_quantize(data.temperature, 100);
+    rec.ch[1]        = log_quantize(data.humidity,    100);
+    rec.ch[2]        = log_quantize(data.pressure,    10);
+    rec.ch[3]        = log_quantize(data.gas,         10);
+
+    if (logger.log(rec)) {
+        Serial.printf("Logged: %s\n", stamp);
     } else {
         Serial.println("Log Failed");
     }
+
 }
 
   delay(5);
@@ -0,0 +1,188 @@
+#include "ble_notify.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define BLE_NOTIFY_ATT_OVERHEAD   3
+#define BLE_NOTIFY_PAYLOAD_MAX    509   // 512-byte MTU ceiling
+#define BLE_NOTIFY_BURST          4     // notifications per pump
+#define BLE_DEBUG_BYTES_PER_SEC   1024
+#define BLE_DEBUG_BURST_BYTES     512
+
+struct LineSlot {
+    uint8_t len;
+    char    data[BLE_NOTIFY_LINE_MAX];
+};
+
+struct LineQueue {
+    LineSlot* slots;
+    uint8_t   depth;
+    uint8_t   head;
+    uint8_t   count;
+};
+
+static LineSlot protoSlots[BLE_NOTIFY_PROTO_DEPTH];
+static LineSlot debugSlots[BLE_NOTIFY_DEBUG_DEPTH];
+static LineQueue protoQueue = { protoSlots, BLE_NOTIFY_PROTO_DEPTH, 0, 0 };
+static LineQueue debugQueue = { debugSlots, BLE_NOTIFY_DEBUG_DEPTH, 0, 0 };
+
+static SemaphoreHandle_t queueMutex = nullptr;
+static BleNotifySendFn sendFn = nullptr;
+static BleNotifyStats stats = {};
+
+// Line currently being streamed out (may span notifications)
+static LineSlot current;
+static uint8_t  currentOffset = 0;
+static bool     haveCurrent = false;
+
+// Packet that the stack refused; resent as-is before anything else
+static uint8_t packet[BLE_NOTIFY_PAYLOAD_MAX];
+static size_t  packetLen = 0;
+
+// Debug token bucket, in bytes
+static uint32_t debugTokens = BLE_DEBUG_BURST_BYTES;
+static uint32_t debugRefillMs = 0;
+
+static bool queuePush(LineQueue& q, const char* line) {
+    if (q.count == q.depth) return false;
+    LineSlot& slot = q.slots[(q.head + q.count) % q.depth];
+    size_t len = strnlen(line, BLE_NOTIFY_LINE_MAX - 1);
+    memcpy(slot.data, line, len);
+    slot.data[len] = '\n';
+    slot.len = (uint8_t)(len + 1);
+    q.count++;
+    return true;
+}
+
+static void queuePop(LineQueue& q, LineSlot& out) {
+    out = q.slots[q.head];
+    q.head = (q.head + 1) % q.depth;
+    q.count--;
+}
+
+static void refillDebugTokens() {
+    uint32_t now = millis();
+    uint32_t add = (now - debugRefillMs) * BLE_DEBUG_BYTES_PER_SEC / 1000;
+    if (add == 0) return;
+    debugTokens += add;
+    if (debugTokens > BLE_DEBUG_BURST_BYTES) debugTokens = BLE_DEBUG_BURST_BYTES;
+    debugRefillMs = now;
+}
+
+// Picks the next line to stream: protocol first, then debug if the rate
+// limit allows. Caller holds queueMutex.
+static bool takeNextLine() {
+    if (protoQueue.count > 0) {
+        queuePop(protoQueue, current);
+        return true;
+    }
+    if (debugQueue.count > 0) {
+        refillDebugTokens();
+        if (debugTokens < debugQueue.slots[debugQueue.head].len) {
+            stats.debugThrottled++;
+            return false;
+        }
+        queuePop(debugQueue, current);
+        debugTokens -= current.len;
+        return true;
+    }
+    return false;
+}
+
+// Fills `packet` from the queues; returns false if there was nothing to send.
+// Caller holds queueMutex.
+static bool buildPacket() {
+    size_t room = stats.mtu - BLE_NOTIFY_ATT_OVERHEAD;
+    if (room > sizeof(packet)) room = sizeof(packet);
+
+    packetLen = 0;
+    while (packetLen < room) {
+        if (!haveCurrent) {
+            if (!takeNextLine()) break;
+            haveCurrent = true;
+            currentOffset = 0;
+            if (packetLen > 0) stats.coalesced++;
+        }
+        size_t n = current.len - currentOffset;
+        if (n > room - packetLen) n = room - packetLen;
+        memcpy(packet + packetLen, current.data + currentOffset, n);
+        packetLen += n;
+        currentOffset += n;
+        if (currentOffset == current.len) haveCurrent = false;
+    }
+    return packetLen > 0;
+}
+
+void bleNotifyBegin(BleNotifySendFn send) {
+    if (!queueMutex) queueMutex = xSemaphoreCreateMutex();
+    sendFn = send;
+    stats.mtu = BLE_NOTIFY_DEFAULT_MTU;
+    debugRefillMs = millis();
+}
+
+void bleNotifySetMtu(uint16_t mtu) {
+    if (!queueMutex) return;
+    xSemaphoreTake(queueMutex, portMAX_DELAY);
+    stats.mtu = mtu < BLE_NOTIFY_DEFAULT_MTU ? BLE_NOTIFY_DEFAULT_MTU : mtu;
+    xSemaphoreGive(queueMutex);
+}
+
+void bleNotifyReset() {
+    if (!queueMutex) return;
+    xSemaphoreTake(queueMutex, portMAX_DELAY);
+    protoQueue.head = protoQueue.count = 0;
+    debugQueue.head = debugQueue.count = 0;
+    haveCurrent = false;
+    packetLen = 0;
+    stats.mtu = BLE_NOTIFY_DEFAULT_MTU;
+    xSemaphoreGive(queueMutex);
+}
+
+bool bleNotifyEnqueue(const char* line, BleNotifyClass cls) {
+    if (!queueMutex) return false;
+    xSemaphoreTake(queueMutex, portMAX_DELAY);
+    bool ok;
+    if (cls == BLE_NOTIFY_PROTOCOL) {
+        ok = queuePush(protoQueue, line);
+        if (!ok) stats.protocolDrops++;
+    } else {
+        ok = queuePush(debugQueue, line);
+        if (!ok) stats.debugDrops++;
+    }
+    if (ok) stats.lines++;
+    xSemaphoreGive(queueMutex);
+    return ok;
+}
+
+void bleNotifyPump() {
+    if (!sendFn || !queueMutex) return;
+
+    // The packet state is held across the send, so bleNotifyReset() from
+    // the BLE task (a new connection) either runs before the packet is
+    // built or clears it after it went out; nothing queued for the old
+    // connection reaches the new one. sendFn only queues the notification
+    // in the stack and does not wait on the BLE host task.
+    for (int i = 0; i < BLE_NOTIFY_BURST; i++) {
+        xSemaphoreTake(queueMutex, portMAX_DELAY);
+        bool sent = false;
+        if (packetLen > 0 || buildPacket()) {
+            sent = sendFn(packet, packetLen);
+            if (sent) {
+                stats.packets++;
+                packetLen = 0;
+            } else {
+                // Stack out of buffers: keep the packet and try again next loop
+                stats.sendRetries++;
+            }
+        }
+        xSemaphoreGive(queueMutex);
+        if (!sent) return;
+    }
+}
+
+BleNotifyStats bleNotifyGetStats() {
+    if (!queueMutex) return stats;
+    xSemaphoreTake(queueMutex, portMAX_DELAY);
+    BleNotifyStats copy = stats;
+    xSemaphoreGive(queueMutex);
+    return copy;
+}
@@ -0,0 +1,56 @@
+#ifndef BLE_NOTIFY_H
+#define BLE_NOTIFY_H
+
+#include <Arduino.h>
+
+// Outgoing BLE notification queue. Lines are '\n'-terminated and packed
+// back to back into notifications of up to (MTU - 3) bytes; a line that
+// does not fit continues in the next notification, so the app reassembles
+// on '\n'. Protocol lines (ACK/ERR/STATUS...) always go first; forwarded
+// debug output is rate-limited and dropped first when the link is busy.
+//
+// Not tied to NimBLE: the sketch supplies the function that sends one
+// notification, and calls bleNotifyPump() from loop().
+
+#define BLE_NOTIFY_LINE_MAX     200   // longer lines are truncated
+#define BLE_NOTIFY_PROTO_DEPTH  16
+#define BLE_NOTIFY_DEBUG_DEPTH  16
+#define BLE_NOTIFY_DEFAULT_MTU  23
+
+enum BleNotifyClass : uint8_t {
+    BLE_NOTIFY_PROTOCOL,
+    BLE_NOTIFY_DEBUG,
+};
+
+struct BleNotifyStats {
+    uint32_t lines;           // lines accepted into the queues
+    uint32_t packets;         // notifications sent
+    uint32_t coalesced;       // lines that shared a notification with another line
+    uint32_t protocolDrops;   // protocol lines lost to a full queue
+    uint32_t debugDrops;      // debug lines lost to a full queue
+    uint32_t debugThrottled;  // pumps where debug output waited on the rate limit
+    uint32_t sendRetries;     // notifications refused by the stack, retried
+    uint16_t mtu;
+};
+
+// Sends one notification; returns false if the stack could not take it.
+// Called with the queue locked, so it must not call back into ble_notify.
+typedef bool (*BleNotifySendFn)(const uint8_t* data, size_t len);
+
+void bleNotifyBegin(BleNotifySendFn send);
+
+// ATT MTU of the current connection (BLE_NOTIFY_DEFAULT_MTU until exchanged)
+void bleNotifySetMtu(uint16_t mtu);
+
+// Drops anything queued, e.g. when a connection ends.
+void bleNotifyReset();
+
+// Queue one line (without '\n'). Safe from any task. Returns false if dropped.
+bool bleNotifyEnqueue(const char* line, BleNotifyClass cls);
+
+// Sends queued data; call from loop().
+void bleNotifyPump();
+
+BleNotifyStats bleNotifyGetStats();
+
+#endif
@@ -6,12 +6,18 @@
 #define SDA_PIN 6
 #define SCL_PIN 7
 #define BME_ADDRESS 0x77
-#define BME_INTERVAL_MS 5000
 
 Adafruit_BME680 bme;
 static unsigned long lastReadTime = 0;
+static uint32_t intervalMs = BME_DEFAULT_INTERVAL_MS;
+static bool bmePresent = false;
 
-static BMEData currentData = {0, 0, 0, 0, false};
+// Acquisition runs as begin-conversion / poll-for-completion so loop()
+// never sits inside performReading() for the ~300 ms conversion+heater time.
+enum BmeState { BME_IDLE, BME_MEASURING };
+static BmeState state = BME_IDLE;
+
+static BMEData currentData = {0, 0, 0, 0, false, 0, 0};
 
 void bmeInit() {
     Wire.begin(SDA_PIN, SCL_PIN);
@@ -28,17 +34,46 @@ void bmeInit() {
     bme.setPressureOversampling(BME680_OS_4X);
     bme.setIIRFilterSize(BME680_FILTER_SIZE_3);
 
+    bmePresent = true;
     Serial.println("[BME] Initialized successfully");
 }
 
+void bmeSetInterval(uint32_t ms) {
+    intervalMs = ms;
+    Serial.printf("[BME] Sample interval set to %lu ms\n", (unsigned long)ms);
+}
+
+uint32_t bmeGetInterval() {
+    return intervalMs;
+}
+
 bool bmeUpdate() {
+    if (!bmePresent) return false;
+
+    if (state == BME_IDLE) {
+        if (millis() - lastReadTime < intervalMs)
+            return false;
 
-    if (millis() - lastReadTime < BME_INTERVAL_MS)
+        lastReadTime = millis();
+
+        // Only writes the config registers and triggers a forced-mode conversion
+        if (bme.beginReading() == 0) {
+            Serial.println("[BME] Reading failed");
+            currentData.valid = false;
+            return false;
+        }
+        state = BME_MEASURING;
         return false;
+    }
 
-    lastReadTime = millis();
+    // BME_MEASURING: poll until the expected conversion time has passed
+    if (bme.remainingReadingMillis() > 0)
+        return false;
 
-    if (!bme.performReading()) {
+    state = BME_IDLE;
+
+    // Conversion is complete, so this just reads the result registers
+    if (!bme.endReading()) {
         Serial.println("[BME] Reading failed");
         currentData.valid = false;
         return false;
@@ -49,12 +84,15 @@ bool bmeUpdate() {
     currentData.pressure    = bme.pressure / 100.0;
     currentData.gas         = bme.gas_resistance / 1000.0;
     currentData.valid       = true;
+    currentData.timestampMs = lastReadTime;
+    currentData.latencyMs   = millis() - lastReadTime;
 
     Serial.println("----- BME680 -----");
     Serial.print("Temp: "); Serial.print(currentData.temperature); Serial.println(" C");
     Serial.print("Humidity: "); Serial.print(currentData.humidity); Serial.println(" %");
     Serial.print("Pressure: "); Serial.print(currentData.pressure); Serial.println(" hPa");
     Serial.print("Gas: "); Serial.print(currentData.gas); Serial.println(" KOhm");
+    Serial.print("Latency: "); Serial.print(currentData.latencyMs); Serial.println(" ms");
     Serial.println("------------------");
 
     return true;
@@ -62,4 +100,4 @@ bool bmeUpdate() {
 
 BMEData bmeGetData() {
     return currentData;
-}
\ No newline at end of file
+}
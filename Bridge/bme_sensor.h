@@ -1,16 +1,27 @@
 #ifndef BME_SENSOR_H
 #define BME_SENSOR_H
 
+#include <stdint.h>
+
+#define BME_DEFAULT_INTERVAL_MS 5000
+
 struct BMEData {
     float temperature;
     float humidity;
     float pressure;
     float gas;
     bool valid;
+    uint32_t timestampMs;  // millis() when the conversion was triggered
+    uint32_t latencyMs;    // trigger -> data available (conversion + heater)
 };
 
 void bmeInit();
+// Non-blocking: starts a conversion when the interval elapses and returns
+// true once, on the call where the finished sample has been collected.
 bool bmeUpdate();
 BMEData bmeGetData();
 
-#endif
\ No newline at end of file
+void bmeSetInterval(uint32_t intervalMs);
+uint32_t bmeGetInterval();
+
+#endif
@@ -0,0 +1,533 @@
+#include "bridge_core.h"
+#include "ble_notify.h"
+#include "config_store.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <hvac_link_frame.h>
+
+// Pending command tracking: one slot per in-flight add, keyed by EUI64 and
+// matched to its result by link request id, so several devices can be
+// commissioned at once.
+struct PendingAdd {
+    bool     inUse;
+    char     eui64[17];
+    uint8_t  reqId;
+    uint32_t deadlineMs;
+};
+
+static BridgeCoreHooks hooks = {};
+
+static volatile bool clientConnected = false;
+static volatile bool clientSecured = false;         // OS-Level Encryption (Just Works)
+static volatile bool sessionAuthenticated = false;  // App-Level Authentication
+
+// Guards pendingAdds and the request ids: BLE writes record them on the
+// NimBLE host task, link frames and timeouts consume them on loopTask. A
+// request is recorded under the same hold as its send, so its response
+// always finds it.
+static SemaphoreHandle_t stateMutex = nullptr;
+
+static PendingAdd pendingAdds[BRIDGE_MAX_PENDING_ADDS];
+
+// ADD_BATCH tracking: the request id of the accepted batch, plus one
+// coalesced progress line ("BATCH JOINED eui,eui,...") being built up.
+static uint8_t  batchReqId = 0;
+static char     batchLine[BRIDGE_BATCH_NOTIFY_MAX];
+static size_t   batchLineLen = 0;
+static char     batchKind[8];
+static uint32_t batchLineStartMs = 0;
+
+static uint8_t  telemetryReqId = 0;  // TELEMETRY request in flight
+
+// SETPIN accepted; its ACK waits until configUpdate() has stored the PIN
+static volatile bool pinAckPending = false;
+
+static void lockState() {
+    xSemaphoreTake(stateMutex, portMAX_DELAY);
+}
+
+static void unlockState() {
+    xSemaphoreGive(stateMutex);
+}
+
+static bool startsWith(const char* s, const char* prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+// --- Notifications ---
+void bridgeCoreNotify(const char* line) {
+    if (!clientConnected || !clientSecured) return;
+    bleNotifyEnqueue(line, BLE_NOTIFY_PROTOCOL);
+}
+
+void bridgeCoreNotifyDebug(const char* line) {
+    if (!clientConnected || !clientSecured) return;
+    bleNotifyEnqueue(line, BLE_NOTIFY_DEBUG);
+}
+
+// --- Utils ---
+static bool isHexChar(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Extracts the EUI64 from "add <EUI64> <Key>|<Sig>". Returns false for
+// anything else.
+static bool parseAddEui64(const char* line, char eui[17]) {
+    if (!startsWith(line, "add ")) return false;
+    const char* start = line + 4;
+    while (*start == ' ') start++;
+    const char* end = strchr(start, ' ');
+    if (!end || end - start != 16) return false;
+    for (int i = 0; i < 16; i++) {
+        if (!isHexChar(start[i])) return false;
+    }
+    memcpy(eui, start, 16);
+    eui[16] = '\0';
+    return true;
+}
+
+// --- Pending Adds (stateMutex held) ---
+static PendingAdd* findPendingByEui(const char* eui) {
+    for (int i = 0; i < BRIDGE_MAX_PENDING_ADDS; i++) {
+        if (pendingAdds[i].inUse && strcasecmp(pendingAdds[i].eui64, eui) == 0) return &pendingAdds[i];
+    }
+    return nullptr;
+}
+
+static PendingAdd* findPendingByReqId(uint8_t reqId) {
+    for (int i = 0; i < BRIDGE_MAX_PENDING_ADDS; i++) {
+        if (pendingAdds[i].inUse && pendingAdds[i].reqId == reqId) return &pendingAdds[i];
+    }
+    return nullptr;
+}
+
+static PendingAdd* allocPendingAdd() {
+    for (int i = 0; i < BRIDGE_MAX_PENDING_ADDS; i++) {
+        if (!pendingAdds[i].inUse) return &pendingAdds[i];
+    }
+    return nullptr;
+}
+
+static void finishPendingAdd(PendingAdd* p, bool ok, const char* reason) {
+    char out[64];
+    if (ok) {
+        snprintf(out, sizeof(out), "ACK ADD %s", p->eui64);
+    } else {
+        snprintf(out, sizeof(out), "ERR ADD %s %s", p->eui64, reason);
+    }
+    Serial.printf("[PROTO] %s\n", out);
+    bridgeCoreNotify(out);
+    p->inUse = false;
+}
+
+// --- Batch Progress ---
+static void flushBatchProgress() {
+    if (batchLineLen == 0) return;
+    bridgeCoreNotify(batchLine);
+    batchLineLen = 0;
+}
+
+// Folds "BATCH <KIND> <eui> [reason]" events of the same kind into one
+// notification; a change of kind, a full line or BRIDGE_BATCH_COALESCE_MS flushes.
+static void queueBatchProgress(const char* event) {
+    const char* kind = event + 6;  // after "BATCH "
+    const char* item = strchr(kind, ' ');
+    if (!item) return;
+    size_t kindLen = item - kind;
+    item++;
+
+    if (kindLen >= sizeof(batchKind)) return;
+    bool sameKind = batchLineLen > 0 && strncmp(batchKind, kind, kindLen) == 0 && batchKind[kindLen] == '\0';
+    size_t itemLen = strlen(item);
+    if (!sameKind || batchLineLen + 1 + itemLen >= sizeof(batchLine)) {
+        flushBatchProgress();
+    }
+
+    if (batchLineLen == 0) {
+        memcpy(batchKind, kind, kindLen);
+        batchKind[kindLen] = '\0';
+        batchLineLen = snprintf(batchLine, sizeof(batchLine), "BATCH %s %s", batchKind, item);
+        batchLineStartMs = millis();
+    } else {
+        batchLineLen += snprintf(batchLine + batchLineLen, sizeof(batchLine) - batchLineLen, ",%s", item);
+    }
+    if (batchLineLen >= sizeof(batchLine)) batchLineLen = sizeof(batchLine) - 1;
+
+    // A failure reason follows the EUI64 after a space; keep it attached
+    for (size_t i = batchLineLen > itemLen ? batchLineLen - itemLen : 0; i < batchLineLen; i++) {
+        if (batchLine[i] == ' ') batchLine[i] = ':';
+    }
+}
+
+// --- Telemetry ---
+// "TELEMETRY v=.. n=.. more=..;<sensor>;<sensor>..." arrives as one frame;
+// the app gets the header line and one "TLM <sensor>" line per record.
+static void forwardTelemetry(const char* payload) {
+    char line[BLE_NOTIFY_LINE_MAX];
+    const char* p = payload;
+    bool first = true;
+
+    while (*p) {
+        size_t len = strcspn(p, ";");
+        if (first) {
+            size_t n = len < sizeof(line) - 1 ? len : sizeof(line) - 1;
+            memcpy(line, p, n);
+            line[n] = '\0';
+            first = false;
+        } else if (len > 0) {
+            snprintf(line, sizeof(line), "TLM %.*s", (int)len, p);
+        } else {
+            line[0] = '\0';
+        }
+        if (line[0]) bridgeCoreNotify(line);
+        p += len;
+        if (*p) p++;
+    }
+}
+
+// --- Lifecycle ---
+void bridgeCoreBegin(const BridgeCoreHooks& h) {
+    hooks = h;
+    if (!stateMutex) stateMutex = xSemaphoreCreateMutex();
+}
+
+void bridgeCoreOnConnect(bool encrypted) {
+    clientConnected = true;
+    clientSecured = encrypted;
+    sessionAuthenticated = false;  // Reset app-level auth on new connection
+    pinAckPending = false;
+    bleNotifyReset();
+}
+
+void bridgeCoreOnSecured(bool encrypted) {
+    clientSecured = encrypted;
+    if (encrypted) bridgeCoreNotify("BRIDGE READY");
+}
+
+void bridgeCoreOnDisconnect() {
+    clientConnected = false;
+    clientSecured = false;
+    sessionAuthenticated = false;  // Clear session state
+    pinAckPending = false;
+    bleNotifyReset();
+}
+
+bool bridgeCoreIsConnected() {
+    return clientConnected;
+}
+
+// --- Commissioner Link ---
+
+// Console text from the Commissioner is debug output only; results arrive
+// as frames, so nothing in here is ever interpreted.
+void bridgeCoreOnLinkText(const char* line) {
+    bridgeCoreNotifyDebug(line);
+}
+
+void bridgeCoreOnLinkFrame(uint8_t type, uint8_t id, const char* payload) {
+    // Batch progress is coalesced rather than forwarded line by line
+    if (type == LINK_MSG_EVENT && startsWith(payload, "BATCH ")) {
+        if (startsWith(payload, "BATCH DONE ")) {
+            flushBatchProgress();
+            bridgeCoreNotify(payload);
+            lockState();
+            batchReqId = 0;
+            unlockState();
+        } else {
+            queueBatchProgress(payload);
+        }
+        return;
+    }
+
+    // Telemetry snapshots are split per sensor rather than mirrored to debug
+    lockState();
+    bool isTelemetry = telemetryReqId != 0 && id == telemetryReqId;
+    if (isTelemetry) telemetryReqId = 0;
+    unlockState();
+    if (isTelemetry) {
+        if (type == LINK_MSG_RSP_OK) {
+            forwardTelemetry(payload);
+        } else {
+            char err[64];
+            const char* reason = strrchr(payload, ' ');
+            snprintf(err, sizeof(err), "ERR TELEMETRY %s", reason ? reason + 1 : "commissioner_error");
+            bridgeCoreNotify(err);
+        }
+        return;
+    }
+
+    // Forward for debug, as the raw lines were before
+    bridgeCoreNotifyDebug(payload);
+
+    if (type == LINK_MSG_EVENT) {
+        // 1. Network Formation
+        if (strcmp(payload, "NETWORK_FORMED") == 0) {
+            bridgeCoreNotify("ACK PROVISION SUCCESS");
+            if (hooks.networkFormed) hooks.networkFormed();
+            return;
+        }
+
+        // 2. Joiner entry expired on the Commissioner before we got a result
+        static const char REMOVED_PREFIX[] = "JOINER_EVENT REMOVED ";
+        if (startsWith(payload, REMOVED_PREFIX)) {
+            lockState();
+            PendingAdd* p = findPendingByEui(payload + sizeof(REMOVED_PREFIX) - 1);
+            if (p) finishPendingAdd(p, false, "timeout");
+            unlockState();
+        }
+        return;
+    }
+
+    // 3. Result of an ADD_BATCH
+    char out[64];
+    lockState();
+    bool isBatch = batchReqId != 0 && id == batchReqId;
+    unlockState();
+    if (isBatch) {
+        if (type == LINK_MSG_RSP_OK) {
+            // "BATCH_ACCEPTED <n>"
+            const char* n = strchr(payload, ' ');
+            snprintf(out, sizeof(out), "ACK ADD_BATCH %s", n ? n + 1 : "0");
+        } else {
+            const char* reason = strrchr(payload, ' ');
+            snprintf(out, sizeof(out), "ERR ADD_BATCH %s", reason ? reason + 1 : "commissioner_error");
+        }
+        bridgeCoreNotify(out);
+        return;
+    }
+
+    // 4. Result of an add, matched by request id
+    lockState();
+    PendingAdd* p = findPendingByReqId(id);
+    if (p) finishPendingAdd(p, type == LINK_MSG_RSP_OK, "commissioner_error");
+    unlockState();
+}
+
+void bridgeCoreTick() {
+    // Acknowledge SETPIN once the new PIN is in NVS
+    if (pinAckPending) {
+        ConfigPinState state = configPinState();
+        if (state == CONFIG_PIN_STORED) {
+            pinAckPending = false;
+            sessionAuthenticated = true;  // Auto-login after setup
+            bridgeCoreNotify("ACK SETPIN SUCCESS");
+            Serial.println("[AUTH] PIN updated and session unlocked");
+        } else if (state == CONFIG_PIN_FAILED) {
+            pinAckPending = false;
+            bridgeCoreNotify("ERR SETPIN STORE");
+            Serial.println("[AUTH] SETPIN failed: NVS write");
+        }
+    }
+
+    // Flush coalesced batch progress
+    if (batchLineLen > 0 && millis() - batchLineStartMs >= BRIDGE_BATCH_COALESCE_MS) {
+        flushBatchProgress();
+    }
+
+    // Pending Timeout Check (Bridge failsafe)
+    // Only fires if we never got a "REMOVED" or "ADDED" message from Comm.
+    lockState();
+    for (int i = 0; i < BRIDGE_MAX_PENDING_ADDS; i++) {
+        PendingAdd* p = &pendingAdds[i];
+        if (p->inUse && (int32_t)(millis() - p->deadlineMs) >= 0) {
+            Serial.printf("[PROTO] Timed out waiting for JOINER_ADDED (%s)\n", p->eui64);
+            finishPendingAdd(p, false, "timeout");
+        }
+    }
+    unlockState();
+}
+
+// --- BLE Commands ---
+void bridgeCoreOnBleWrite(const char* value, size_t len) {
+    // 1. OS-Level Security Check
+    if (!clientSecured) {
+        Serial.println("[BLE] Rejected write (Link Not Secured)");
+        return;
+    }
+
+    // Sanitize input: bounded copy, trimmed
+    char cmd[BRIDGE_CMD_MAX + 1];
+    if (len > BRIDGE_CMD_MAX) len = BRIDGE_CMD_MAX;
+    const char* start = value;
+    const char* end = value + len;
+    while (start < end && isspace((unsigned char)*start)) start++;
+    while (end > start && (isspace((unsigned char)end[-1]) || end[-1] == '\0')) end--;
+    if (start == end) return;
+    size_t cmdLen = end - start;
+    memcpy(cmd, start, cmdLen);
+    cmd[cmdLen] = '\0';
+
+    // ==========================================
+    // 2. APP-LEVEL AUTHENTICATION LOGIC
+    // ==========================================
+
+    // Command: STATUS?
+    if (strcmp(cmd, "STATUS?") == 0) {
+        bridgeCoreNotify(configIsSetup() ? "STATUS|SECURED" : "STATUS|SETUP_PENDING");
+        return;
+    }
+
+    // Command: AUTH|<Pin>
+    if (startsWith(cmd, "AUTH|")) {
+        if (configCheckPin(cmd + 5)) {
+            sessionAuthenticated = true;
+            bridgeCoreNotify("ACK AUTH SUCCESS");
+            Serial.println("[AUTH] Session Unlocked");
+        } else {
+            bridgeCoreNotify("ERR AUTH FAILED");
+            Serial.println("[AUTH] Failed login attempt");
+        }
+        return;
+    }
+
+    // Command: SETPIN|<OldPin>|<NewPin>
+    if (startsWith(cmd, "SETPIN|")) {
+        char* oldPin = cmd + 7;
+        char* secondPipe = strchr(oldPin, '|');
+        if (!secondPipe) {
+            bridgeCoreNotify("ERR SETPIN FORMAT");
+            return;
+        }
+        *secondPipe = '\0';
+        const char* newPin = secondPipe + 1;
+
+        if (!configCheckPin(oldPin)) {
+            bridgeCoreNotify("ERR SETPIN FAILED");
+            Serial.println(configPinLocked() ? "[AUTH] SETPIN failed: PIN locked, factory reset needed"
+                                             : "[AUTH] SETPIN failed: Old PIN mismatch");
+        } else if (!configSetPin(newPin)) {
+            bridgeCoreNotify("ERR SETPIN FORMAT");
+        } else {
+            pinAckPending = true;  // ACK from bridgeCoreTick() once stored
+        }
+        return;
+    }
+
+    // ==========================================
+    // 3. THE GATEKEEPER
+    // ==========================================
+    // Any commands beyond this point require the session to be authenticated.
+    if (!sessionAuthenticated) {
+        Serial.println("[BLE] Rejected write (App-Level Unauthenticated)");
+        bridgeCoreNotify("ERR UNAUTHENTICATED");
+        return;
+    }
+
+    // ==========================================
+    // 4. SECURED COMMANDS
+    // ==========================================
+    char out[200];
+
+    // A. PROVISION
+    if (startsWith(cmd, "PROVISION|")) {
+        Serial.println("[BLE] Received Provisioning Payload");
+        if (hooks.provision) hooks.provision(cmd + 10);
+        return;
+    }
+
+    // B. SAMPLE INTERVAL (BME680 schedule, milliseconds)
+    if (startsWith(cmd, "INTERVAL|")) {
+        long ms = atol(cmd + 9);
+        if (ms < 1000 || ms > 3600000) {
+            bridgeCoreNotify("ERR INTERVAL RANGE");
+            return;
+        }
+        configSetSampleInterval((uint32_t)ms);
+        if (hooks.setSampleInterval) hooks.setSampleInterval((uint32_t)ms);
+        snprintf(out, sizeof(out), "ACK INTERVAL %ld", ms);
+        bridgeCoreNotify(out);
+        return;
+    }
+
+    // C. LINK STATISTICS
+    if (strcmp(cmd, "STATS?") == 0) {
+        if (hooks.formatLinkStats) {
+            hooks.formatLinkStats(out, sizeof(out));
+            bridgeCoreNotify(out);
+        }
+        if (hooks.formatLogStats) {
+            hooks.formatLogStats(out, sizeof(out));
+            bridgeCoreNotify(out);
+        }
+
+        BleNotifyStats bs = bleNotifyGetStats();
+        snprintf(out, sizeof(out),
+                 "STATS BLE mtu=%u lines=%lu pkts=%lu coalesced=%lu pdrop=%lu ddrop=%lu throttled=%lu retry=%lu",
+                 bs.mtu, (unsigned long)bs.lines, (unsigned long)bs.packets,
+                 (unsigned long)bs.coalesced, (unsigned long)bs.protocolDrops,
+                 (unsigned long)bs.debugDrops, (unsigned long)bs.debugThrottled,
+                 (unsigned long)bs.sendRetries);
+        bridgeCoreNotify(out);
+        return;
+    }
+
+    if (!hooks.sendCommand) return;
+
+    // D. ADD_BATCH "ADD_BATCH EUI:PSKD,... [timeout]|<hmac>"
+    // Signed once over the whole list; the Commissioner verifies it and
+    // registers the devices in waves (and rejects a second running batch).
+    if (startsWith(cmd, "ADD_BATCH ")) {
+        lockState();
+        uint8_t reqId = hooks.sendCommand(cmd);
+        if (reqId != 0) batchReqId = reqId;
+        unlockState();
+        if (reqId == 0) {
+            bridgeCoreNotify("ERR ADD_BATCH link_error");
+            return;
+        }
+        Serial.printf("[UART] Forwarded ADD_BATCH (%u bytes, id %u)\n", (unsigned)cmdLen, reqId);
+        return;
+    }
+
+    // E. TELEMETRY [since] - live sensor table from the Commissioner
+    if (strcmp(cmd, "TELEMETRY") == 0 || startsWith(cmd, "TELEMETRY ")) {
+        lockState();
+        uint8_t reqId = hooks.sendCommand(cmd);
+        if (reqId != 0) telemetryReqId = reqId;
+        unlockState();
+        if (reqId == 0) bridgeCoreNotify("ERR TELEMETRY link_error");
+        return;
+    }
+
+    // F. ADD: reserve a pending slot, send and record the request id under
+    // one hold of stateMutex (busy only when every slot is in flight)
+    char eui[17];
+    if (parseAddEui64(cmd, eui)) {
+        lockState();
+        if (findPendingByEui(eui)) {
+            unlockState();
+            snprintf(out, sizeof(out), "ERR ADD %s duplicate", eui);
+            bridgeCoreNotify(out);
+            return;
+        }
+        PendingAdd* pending = allocPendingAdd();
+        if (!pending) {
+            unlockState();
+            Serial.println("[BLE] Rejecting add: all pending slots in use");
+            bridgeCoreNotify("ERR BUSY");
+            return;
+        }
+        pending->inUse = true;
+        memcpy(pending->eui64, eui, sizeof(pending->eui64));
+        pending->deadlineMs = millis() + BRIDGE_ADD_TIMEOUT_MS;
+
+        // Forward the FULL command (including the |hash) to the Commissioner
+        uint8_t reqId = hooks.sendCommand(cmd);
+        pending->reqId = reqId;
+        if (reqId == 0) pending->inUse = false;
+        unlockState();
+
+        if (reqId == 0) {
+            snprintf(out, sizeof(out), "ERR ADD %s link_error", eui);
+            bridgeCoreNotify(out);
+            return;
+        }
+        Serial.printf("[STATE] Pending add set for EUI64=%s\n", eui);
+        Serial.printf("[UART] Forwarded full command (%u bytes, id %u)\n", (unsigned)cmdLen, reqId);
+        return;
+    }
+
+    // G. Forward to UART
+    uint8_t reqId = hooks.sendCommand(cmd);
+    Serial.printf("[UART] Forwarded full command (%u bytes, id %u)\n", (unsigned)cmdLen, reqId);
+}
@@ -0,0 +1,61 @@
+#ifndef BRIDGE_CORE_H
+#define BRIDGE_CORE_H
+
+#include <Arduino.h>
+#include <hvac_link_frame.h>
+
+// Hardware-independent Bridge protocol logic: the BLE session and its
+// authentication gatekeeper, BLE command handling, pending-add and batch
+// tracking, and interpretation of Commissioner link frames.
+//
+// Everything the core needs from the board goes through BridgeCoreHooks
+// (UART link, provisioning, sensors). Notifications go to ble_notify and
+// settings to config_store, so the same code builds on the host against
+// the fakes in tools/bridge_host.
+
+#define BRIDGE_MAX_PENDING_ADDS   LINK_MAX_JOINERS  // the Commissioner's joiner table
+#define BRIDGE_ADD_TIMEOUT_MS     15000   // Bridge-side failsafe per add
+#define BRIDGE_BATCH_COALESCE_MS  250     // hold batch progress this long before notifying
+#define BRIDGE_BATCH_NOTIFY_MAX   160     // keep coalesced lines within one notification
+#define BRIDGE_CMD_MAX            512     // longest BLE command accepted
+
+struct BridgeCoreHooks {
+    // Send a command to the Commissioner; returns its link request id, 0 on failure.
+    uint8_t (*sendCommand)(const char* cmd);
+    // PROVISION|<json> from an authenticated client.
+    void    (*provision)(const char* json);
+    // Commissioner reported NETWORK_FORMED.
+    void    (*networkFormed)();
+    // INTERVAL|<ms> accepted (already range-checked and persisted).
+    void    (*setSampleInterval)(uint32_t ms);
+    // Formats the "STATS UART ..." line for STATS?; may be null.
+    void    (*formatLinkStats)(char* buf, size_t len);
+    // Formats the "STATS SD ..." line for STATS?; may be null.
+    void    (*formatLogStats)(char* buf, size_t len);
+};
+
+void bridgeCoreBegin(const BridgeCoreHooks& hooks);
+
+// --- BLE session ---
+void bridgeCoreOnConnect(bool encrypted);
+void bridgeCoreOnSecured(bool encrypted);
+void bridgeCoreOnDisconnect();
+bool bridgeCoreIsConnected();
+
+// One characteristic write. Safe to call from the BLE host task: request
+// ids are recorded under the core's mutex together with their send, and
+// link frames and bridgeCoreTick() (loopTask) read them under it.
+void bridgeCoreOnBleWrite(const char* value, size_t len);
+
+// --- Commissioner link ---
+void bridgeCoreOnLinkFrame(uint8_t type, uint8_t id, const char* payload);
+void bridgeCoreOnLinkText(const char* line);
+
+// Timeouts, coalescing deadlines and the SETPIN ACK; call from loop().
+void bridgeCoreTick();
+
+// Notify a secured client: protocol replies, or rate-limited debug output.
+void bridgeCoreNotify(const char* line);
+void bridgeCoreNotifyDebug(const char* line);
+
+#endif
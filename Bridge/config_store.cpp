@@ -0,0 +1,197 @@
+#include "config_store.h"
+#include "bme_sensor.h"
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define NS_AUTH     "auth_config"
+#define NS_GATEWAY  "gateway_config"
+#define NS_BRIDGE   "bridge_config"
+
+enum DirtyBits : uint8_t {
+    DIRTY_AUTH    = 1 << 0,
+    DIRTY_GATEWAY = 1 << 1,
+    DIRTY_BRIDGE  = 1 << 2,
+};
+
+static BridgeConfig config = {};
+static uint8_t dirty = 0;
+static uint32_t lastChangeMs = 0;
+static ConfigPinState pinState = CONFIG_PIN_STORED;
+static SemaphoreHandle_t configMutex = nullptr;
+
+static void lock()   { xSemaphoreTake(configMutex, portMAX_DELAY); }
+static void unlock() { xSemaphoreGive(configMutex); }
+
+static void markDirty(uint8_t bits) {
+    dirty |= bits;
+    lastChangeMs = millis();
+}
+
+// Returns false (and leaves out empty) if the stored value does not fit
+static bool loadString(Preferences& prefs, const char* key, char* out, size_t len, const char* def) {
+    String v = prefs.getString(key, def);
+    if (v.length() >= len) {
+        out[0] = '\0';
+        return false;
+    }
+    memcpy(out, v.c_str(), v.length() + 1);
+    return true;
+}
+
+void configBegin(const char* defaultPin) {
+    if (!configMutex) configMutex = xSemaphoreCreateMutex();
+
+    Preferences prefs;
+
+    prefs.begin(NS_AUTH, true);
+    bool firstBoot = !prefs.isKey("is_setup");
+    config.isSetup = prefs.getBool("is_setup", false);
+    config.pinLocked = !loadString(prefs, "pin", config.pin, sizeof(config.pin), defaultPin);
+    prefs.end();
+    if (config.pinLocked) {
+        Serial.printf("[CONFIG] Stored PIN is longer than %u chars; locked until factory reset\n",
+                      CONFIG_PIN_STORED_MAX);
+    }
+
+    prefs.begin(NS_GATEWAY, true);
+    if (!loadString(prefs, "ssid", config.ssid, sizeof(config.ssid), "") ||
+        !loadString(prefs, "pass", config.pass, sizeof(config.pass), "")) {
+        Serial.println("[CONFIG] Stored Wi-Fi credentials too long; ignored");
+        config.ssid[0] = config.pass[0] = '\0';
+    }
+    if (!loadString(prefs, "zone", config.zone, sizeof(config.zone), "Default")) {
+        strlcpy(config.zone, "Default", sizeof(config.zone));
+    }
+    prefs.end();
+
+    prefs.begin(NS_BRIDGE, true);
+    config.schema = prefs.getUShort("schema", 1);  // schema 1 predates this namespace
+    config.sampleIntervalMs = prefs.getULong("sample_ms", BME_DEFAULT_INTERVAL_MS);
+    prefs.end();
+
+    if (firstBoot && !config.pinLocked) {
+        Serial.println("[CONFIG] First boot detected. Initializing Auth NVS.");
+        markDirty(DIRTY_AUTH);
+    }
+    if (config.schema < CONFIG_SCHEMA_VERSION) {
+        Serial.printf("[CONFIG] Migrating schema %u -> %u\n", config.schema, CONFIG_SCHEMA_VERSION);
+        config.schema = CONFIG_SCHEMA_VERSION;
+        markDirty(DIRTY_BRIDGE);
+    }
+    if (dirty) configCommit();
+}
+
+BridgeConfig configGet() {
+    lock();
+    BridgeConfig copy = config;
+    unlock();
+    return copy;
+}
+
+bool configIsSetup() {
+    lock();
+    bool setup = config.isSetup;
+    unlock();
+    return setup;
+}
+
+bool configPinLocked() {
+    lock();
+    bool locked = config.pinLocked;
+    unlock();
+    return locked;
+}
+
+bool configCheckPin(const char* pin) {
+    lock();
+    bool match = !config.pinLocked && strcmp(pin, config.pin) == 0;
+    unlock();
+    return match;
+}
+
+bool configSetPin(const char* pin) {
+    if (strlen(pin) > CONFIG_PIN_MAX) return false;
+    lock();
+    if (config.pinLocked) {
+        unlock();
+        return false;
+    }
+    strlcpy(config.pin, pin, sizeof(config.pin));
+    config.isSetup = true;
+    pinState = CONFIG_PIN_PENDING;
+    markDirty(DIRTY_AUTH);
+    unlock();
+    return true;
+}
+
+bool configSetWifi(const char* ssid, const char* pass, const char* zone) {
+    if (strlen(ssid) > CONFIG_SSID_MAX || strlen(pass) > CONFIG_PASS_MAX) return false;
+    lock();
+    strlcpy(config.ssid, ssid, sizeof(config.ssid));
+    strlcpy(config.pass, pass, sizeof(config.pass));
+    strlcpy(config.zone, zone ? zone : "Default", sizeof(config.zone));
+    markDirty(DIRTY_GATEWAY);
+    unlock();
+    return true;
+}
+
+ConfigPinState configPinState() {
+    lock();
+    ConfigPinState state = pinState;
+    unlock();
+    return state;
+}
+
+void configSetSampleInterval(uint32_t ms) {
+    lock();
+    if (config.sampleIntervalMs != ms) {
+        config.sampleIntervalMs = ms;
+        markDirty(DIRTY_BRIDGE);
+    }
+    unlock();
+}
+
+void configCommit() {
+    lock();
+    uint8_t bits = dirty;
+    BridgeConfig snap = config;
+    dirty = 0;
+    unlock();
+    if (!bits) return;
+
+    Preferences prefs;
+    if (bits & DIRTY_AUTH) {
+        bool ok = prefs.begin(NS_AUTH, false);
+        ok = ok && prefs.putBool("is_setup", snap.isSetup) == 1;
+        ok = ok && prefs.putString("pin", snap.pin) == strlen(snap.pin);
+        prefs.end();
+        lock();
+        // A newer configSetPin() is still dirty and keeps its PENDING state
+        if (pinState == CONFIG_PIN_PENDING && !(dirty & DIRTY_AUTH)) {
+            pinState = ok ? CONFIG_PIN_STORED : CONFIG_PIN_FAILED;
+        }
+        unlock();
+    }
+    if (bits & DIRTY_GATEWAY) {
+        prefs.begin(NS_GATEWAY, false);
+        prefs.putString("ssid", snap.ssid);
+        prefs.putString("pass", snap.pass);
+        prefs.putString("zone", snap.zone);
+        prefs.end();
+    }
+    if (bits & DIRTY_BRIDGE) {
+        prefs.begin(NS_BRIDGE, false);
+        prefs.putUShort("schema", snap.schema);
+        prefs.putULong("sample_ms", snap.sampleIntervalMs);
+        prefs.end();
+    }
+    Serial.printf("[CONFIG] Committed (dirty=0x%02X)\n", bits);
+}
+
+void configUpdate() {
+    if (!dirty) return;
+    if (configPinState() == CONFIG_PIN_PENDING || millis() - lastChangeMs >= CONFIG_COMMIT_DELAY_MS) {
+        configCommit();
+    }
+}
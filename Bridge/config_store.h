@@ -0,0 +1,74 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+
+// Bridge configuration, loaded from NVS once at boot and served from RAM.
+// Setters update the RAM copy and mark it dirty; configUpdate() (called
+// from loop()) writes everything pending in one pass once changes have
+// settled, so BLE callbacks never touch flash. A PIN change skips the
+// settle delay and is confirmed through configPinState().
+//
+// NVS layout keeps the original namespaces so existing devices keep their
+// PIN and Wi-Fi settings:
+//   auth_config    is_setup, pin
+//   gateway_config ssid, pass, zone
+//   bridge_config  schema, sample_ms   (added in schema 2)
+
+#define CONFIG_SCHEMA_VERSION   2
+#define CONFIG_PIN_MAX          16     // longest PIN configSetPin() accepts
+#define CONFIG_PIN_STORED_MAX   504    // longest PIN earlier firmware could store (512-byte SETPIN write)
+#define CONFIG_SSID_MAX         32
+#define CONFIG_PASS_MAX         64
+#define CONFIG_ZONE_MAX         32
+#define CONFIG_COMMIT_DELAY_MS  1000   // quiet time before dirty fields are written
+
+struct BridgeConfig {
+    uint16_t schema;
+    bool     isSetup;                  // PIN has been changed from the default
+    bool     pinLocked;                // stored PIN unreadable; cleared only by a factory reset
+    char     pin[CONFIG_PIN_STORED_MAX + 1];
+    char     ssid[CONFIG_SSID_MAX + 1];
+    char     pass[CONFIG_PASS_MAX + 1];
+    char     zone[CONFIG_ZONE_MAX + 1];
+    uint32_t sampleIntervalMs;         // BME680 schedule
+};
+
+// Loads NVS into RAM, filling defaults and migrating older schemas. A
+// stored PIN is kept whole; one longer than CONFIG_PIN_STORED_MAX (which
+// no firmware writes) sets pinLocked instead of being truncated, and the
+// device stays locked until the BOOT button factory reset erases NVS.
+void configBegin(const char* defaultPin);
+
+// Consistent copy of the current configuration. Safe from any task, but
+// the struct is large and holds the Wi-Fi password: BLE callbacks use the
+// narrow queries below instead.
+BridgeConfig configGet();
+
+bool configIsSetup();
+bool configPinLocked();
+
+// True if pin matches the stored PIN. Compared under the lock, so the PIN
+// never leaves the store; always false while the PIN is locked.
+bool configCheckPin(const char* pin);
+
+bool configSetPin(const char* pin);    // also marks the device as set up
+
+enum ConfigPinState : uint8_t {
+    CONFIG_PIN_STORED,    // the last configSetPin() is in NVS
+    CONFIG_PIN_PENDING,   // written by the next configUpdate()
+    CONFIG_PIN_FAILED,    // the NVS write failed; the new PIN is lost at reboot
+};
+
+ConfigPinState configPinState();
+bool configSetWifi(const char* ssid, const char* pass, const char* zone);
+void configSetSampleInterval(uint32_t ms);
+
+// Writes dirty fields once CONFIG_COMMIT_DELAY_MS has passed since the
+// last change, or at once after a PIN change. Call from loop().
+void configUpdate();
+
+// Writes dirty fields now (e.g. before a restart).
+void configCommit();
+
+#endif
@@ -1,5 +1,15 @@
 #include "logger.h"
 
+// One queue entry of the async writer. Text lines and binary records share
+// the queue so ordering is preserved; a FLUSH entry forces a commit.
+enum : uint8_t { SLOT_TEXT, SLOT_RECORD, SLOT_FLUSH };
+
+struct LoggerSlot {
+  uint8_t kind;
+  uint8_t len;
+  char    data[LOGGER_MAX_LINE];
+};
+
 Logger::Logger(uint8_t csPin,
                uint8_t misoPin,
                uint8_t mosiPin,
@@ -43,12 +53,21 @@ void Logger::setFilename(const char* name) {
   _filename = name;
 }
 
+void Logger::setPreallocate(uint64_t bytes) {
+  _preallocBytes = bytes;
+}
+
 void Logger::writeHeader(const String& headerLine) {
   if (!_ready) return;
 
   if (!sd.exists(_filename)) {
     file = sd.open(_filename, O_WRITE | O_CREAT);
     if (file) {
+      // Reserve contiguous clusters up front so appends never walk the FAT.
+      // Only possible while the file is still empty.
+      if (_preallocBytes && !file.preAllocate(_preallocBytes)) {
+        Serial.println("[SD] Pre-allocation failed, continuing without it.");
+      }
       file.println(headerLine);
       file.close();
       Serial.println("[SD] Header written.");
@@ -61,9 +80,106 @@ void Logger::openAppend() {
   file = sd.open(_filename, O_WRITE | O_APPEND | O_CREAT);
 }
 
-bool Logger::log(const String& line) {
+bool Logger::openBinary(const LogFileHeader& header, uint32_t* recovered) {
   if (!_ready) return false;
 
+  uint32_t count = 0;
+
+  if (sd.exists(_filename)) {
+    file = sd.open(_filename, O_RDWR);
+    if (!file) {
+      Serial.println("[SD] Binary log open failed");
+      return false;
+    }
+
+    LogFileHeader existing;
+    bool headerOk = file.read(&existing, sizeof(existing)) == (int)sizeof(existing) &&
+                    log_header_valid(&existing);
+
+    if (!headerOk) {
+      // Never append to a file we can't parse: move it aside and start fresh.
+      file.close();
+      char aside[64];
+      snprintf(aside, sizeof(aside), "%s.bad", _filename);
+      sd.remove(aside);
+      sd.rename(_filename, aside);
+      Serial.printf("[SD] Bad log header, moved to %s\n", aside);
+    } else {
+      uint64_t before = file.fileSize();
+      count = log_recover_tail(file);
+      uint64_t after = file.fileSize();
+      file.close();
+      if (after != before) {
+        Serial.printf("[SD] Recovered %lu records, truncated %lu torn bytes\n",
+                      (unsigned long)count, (unsigned long)(before - after));
+      } else {
+        Serial.printf("[SD] Binary log OK (%lu records)\n", (unsigned long)count);
+      }
+    }
+  }
+
+  if (!sd.exists(_filename)) {
+    file = sd.open(_filename, O_WRITE | O_CREAT);
+    if (!file) {
+      Serial.println("[SD] Binary log create failed");
+      return false;
+    }
+    if (_preallocBytes && !file.preAllocate(_preallocBytes)) {
+      Serial.println("[SD] Pre-allocation failed, continuing without it.");
+    }
+    LogFileHeader h = header;
+    log_header_seal(&h);
+    file.write(&h, sizeof(h));
+    file.sync();
+    file.close();
+    Serial.println("[SD] Binary log header written.");
+  }
+
+  if (recovered) *recovered = count;
+  _binary = true;
+  return true;
+}
+
+bool Logger::log(const String& line) {
+  return log(line.c_str());
+}
+
+bool Logger::log(const char* line) {
+  if (!_ready || _binary) return false;
+  if (!_task) return writeSync(line);
+
+  size_t len = strnlen(line, LOGGER_MAX_LINE);
+  return enqueue(SLOT_TEXT, line, len);
+}
+
+bool Logger::log(const LogRecord& record) {
+  if (!_ready || !_binary) return false;
+
+  LogRecord sealed = record;
+  log_record_seal(&sealed);
+
+  if (!_task) return writeSync(sealed);
+  return enqueue(SLOT_RECORD, &sealed, sizeof(sealed));
+}
+
+bool Logger::enqueue(uint8_t kind, const void* data, size_t len) {
+  LoggerSlot slot;
+  slot.kind = kind;
+  slot.len  = (uint8_t)len;
+  if (len) memcpy(slot.data, data, len);
+
+  // Never block the caller: a full queue means the card can't keep up.
+  if (xQueueSend(_queue, &slot, 0) != pdTRUE) {
+    if (kind != SLOT_FLUSH) _dropped++;
+    return false;
+  }
+
+  uint32_t waiting = uxQueueMessagesWaiting(_queue);
+  if (waiting > _queueHighWater) _queueHighWater = waiting;
+  return true;
+}
+
+bool Logger::writeSync(const char* line) {
   openAppend();
 
   if (!file) {
@@ -74,8 +190,8 @@ bool Logger::log(const String& line) {
   // 1. Clear any lingering error flags from previous attempts
   file.clearWriteError();
 
-  // 2. Convert Arduino String to a C-string (just like your working code did)
-  file.println(line.c_str());
+  // 2. Write the line
+  file.println(line);
 
   // 3. Force the ExFat buffer to write to physical flash immediately
   file.sync(); 
@@ -91,8 +207,150 @@ bool Logger::log(const String& line) {
   return true;
 }
 
+bool Logger::writeSync(const LogRecord& record) {
+  openAppend();
+
+  if (!file) {
+    Serial.println("⚠ SD Open Failed during log attempt");
+    return false;
+  }
+
+  // No sync needed for crash consistency: a torn record fails its CRC and
+  // is cut by openBinary() on the next boot. close() still commits it.
+  file.clearWriteError();
+  bool ok = file.write(&record, sizeof(record)) == sizeof(record);
+  ok = file.close() && ok;
+
+  if (!ok) {
+    Serial.println("⚠ SD Write Error! (Possible power brownout)");
+  }
+  return ok;
+}
+
 void Logger::flush() {
+  if (_task) {
+    // The task owns the file; ask it to commit instead of touching it here.
+    enqueue(SLOT_FLUSH, nullptr, 0);
+    return;
+  }
   if (file) {
     file.flush();
   }
-}
\ No newline at end of file
+}
+
+// --- Async group-commit writer ---
+
+bool Logger::startAsync(const LoggerAsyncConfig& cfg) {
+  if (!_ready) return false;
+  if (_task) return true;
+
+  _cfg = cfg;
+  if (_cfg.queueDepth == 0) _cfg.queueDepth = 1;
+  if (_cfg.commitRecords == 0) _cfg.commitRecords = 1;
+
+  _queue = xQueueCreate(_cfg.queueDepth, sizeof(LoggerSlot));
+  if (!_queue) {
+    Serial.println("[SD] Async queue allocation failed");
+    return false;
+  }
+
+  if (xTaskCreate(taskEntry, "sd_logger", _cfg.taskStack, this,
+                  _cfg.taskPriority, &_task) != pdPASS) {
+    Serial.println("[SD] Async task creation failed");
+    vQueueDelete(_queue);
+    _queue = nullptr;
+    _task = nullptr;
+    return false;
+  }
+
+  Serial.printf("[SD] Async logger started (queue=%u, commit every %u rec / %lu ms)\n",
+                _cfg.queueDepth, _cfg.commitRecords, (unsigned long)_cfg.commitMs);
+  return true;
+}
+
+LoggerStats Logger::getStats() const {
+  LoggerStats s;
+  s.queued         = _queue ? uxQueueMessagesWaiting(_queue) : 0;
+  s.queueHighWater = _queueHighWater;
+  s.written        = _written;
+  s.dropped        = _dropped;
+  s.writeErrors    = _writeErrors;
+  s.commits        = _commits;
+  s.lastCommitUs   = _lastCommitUs;
+  s.maxCommitUs    = _maxCommitUs;
+  return s;
+}
+
+void Logger::taskEntry(void* arg) {
+  static_cast<Logger*>(arg)->taskLoop();
+}
+
+bool Logger::commit() {
+  uint32_t t0 = micros();
+  bool ok = file.sync() && !file.getWriteError();
+  uint32_t dt = micros() - t0;
+
+  _commits++;
+  _lastCommitUs = dt;
+  if (dt > _maxCommitUs) _maxCommitUs = dt;
+
+  if (!ok) {
+    Serial.println("⚠ SD Sync Error! Reopening file.");
+    _writeErrors++;
+    file.close();
+  }
+  return ok;
+}
+
+void Logger::taskLoop() {
+  LoggerSlot slot;
+  uint32_t pending = 0;          // records written but not yet synced
+  uint32_t oldestPendingMs = 0;  // when the first of them was written
+
+  for (;;) {
+    TickType_t wait = portMAX_DELAY;
+    if (pending) {
+      uint32_t age = millis() - oldestPendingMs;
+      wait = age >= _cfg.commitMs ? 0 : pdMS_TO_TICKS(_cfg.commitMs - age);
+    }
+
+    bool got = xQueueReceive(_queue, &slot, wait) == pdTRUE;
+    bool flushReq = got && slot.kind == SLOT_FLUSH;
+
+    if (got && !flushReq) {
+      if (!file) {
+        openAppend();
+        if (!file) {
+          Serial.println("⚠ SD Open Failed during log attempt");
+          _writeErrors++;
+          continue;
+        }
+        file.clearWriteError();
+      }
+
+      if (slot.kind == SLOT_TEXT) {
+        file.write(slot.data, slot.len);
+        file.println();
+      } else {
+        file.write(slot.data, slot.len);
+      }
+
+      if (file.getWriteError()) {
+        Serial.println("⚠ SD Write Error! (Possible power brownout)");
+        _writeErrors++;
+        file.close();
+        pending = 0;
+        continue;
+      }
+
+      _written++;
+      if (pending++ == 0) oldestPendingMs = millis();
+    }
+
+    if (pending && (flushReq || pending >= _cfg.commitRecords ||
+                    millis() - oldestPendingMs >= _cfg.commitMs)) {
+      commit();
+      pending = 0;
+    }
+  }
+}
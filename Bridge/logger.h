@@ -4,6 +4,34 @@
 #include <Arduino.h>
 #include <SdFat.h>
 #include <SPI.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <hvac_log_record.h>
+
+// Longest CSV line accepted by the async queue.
+#define LOGGER_MAX_LINE 128
+
+// Tunables for the background writer started by Logger::startAsync().
+struct LoggerAsyncConfig {
+    uint16_t    queueDepth    = 32;    // records buffered before log() drops
+    uint16_t    commitRecords = 16;    // sync() after this many records...
+    uint32_t    commitMs      = 5000;  // ...or once the oldest unsynced record is this old
+    uint32_t    taskStack     = 4096;
+    UBaseType_t taskPriority  = 1;
+};
+
+// Snapshot of the async writer, for sizing queueDepth / commit policy per site.
+struct LoggerStats {
+    uint32_t queued;         // records currently waiting in the queue
+    uint32_t queueHighWater; // max records ever waiting at once
+    uint32_t written;        // records handed to the file
+    uint32_t dropped;        // records rejected because the queue was full
+    uint32_t writeErrors;    // failed writes/syncs (file is reopened afterwards)
+    uint32_t commits;        // number of sync() calls
+    uint32_t lastCommitUs;   // duration of the most recent sync()
+    uint32_t maxCommitUs;    // worst sync() seen since boot
+};
 
 class Logger {
 public:
@@ -16,8 +44,24 @@ public:
     bool isReady();
 
     void setFilename(const char* name);
+    // Contiguous clusters reserved when writeHeader() creates a new file (0 = off).
+    void setPreallocate(uint64_t bytes);
     void writeHeader(const String& headerLine);
+
+    // Switch to the fixed-size binary format (hvac_log_record.h). Creates the
+    // file with `header`, or validates an existing one and truncates a torn
+    // tail left by a power loss. Returns the number of intact records via
+    // `recovered` when non-null.
+    bool openBinary(const LogFileHeader& header, uint32_t* recovered = nullptr);
+
+    // Hand the file over to a dedicated task. After this, log() only enqueues.
+    bool startAsync(const LoggerAsyncConfig& cfg = LoggerAsyncConfig());
+    bool isAsync() const { return _task != nullptr; }
+    LoggerStats getStats() const;
+
     bool log(const String& line);
+    bool log(const char* line);
+    bool log(const LogRecord& record);  // seals the CRC; binary mode only
     void flush();
 
 private:
@@ -27,8 +71,28 @@ private:
     uint8_t _cs, _miso, _mosi, _sck;
     const char* _filename = "/log.csv";
     bool _ready = false;
+    bool _binary = false;
+    uint64_t _preallocBytes = 0;
+
+    // --- Async writer state ---
+    LoggerAsyncConfig _cfg;
+    QueueHandle_t _queue = nullptr;
+    TaskHandle_t  _task  = nullptr;
+    volatile uint32_t _queueHighWater = 0;
+    volatile uint32_t _written = 0;
+    volatile uint32_t _dropped = 0;
+    volatile uint32_t _writeErrors = 0;
+    volatile uint32_t _commits = 0;
+    volatile uint32_t _lastCommitUs = 0;
+    volatile uint32_t _maxCommitUs = 0;
 
     void openAppend();
+    bool enqueue(uint8_t kind, const void* data, size_t len);
+    bool writeSync(const char* line);
+    bool writeSync(const LogRecord& record);
+    bool commit();
+    static void taskEntry(void* arg);
+    void taskLoop();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -31,7 +31,7 @@ bool rtcIsAvailable() {
 }
 
 RTCDateTime rtcGetDateTime() {
-    RTCDateTime result = {0, 0, 0, 0, 0, 0, false, ""};
+    RTCDateTime result = {0, 0, 0, 0, 0, 0, false, 0};
     if (!_rtcAvailable) return result;
 
     DateTime now = rtc.now();
@@ -42,26 +42,30 @@ RTCDateTime rtcGetDateTime() {
     result.hour    = now.hour();
     result.minute  = now.minute();
     result.second  = now.second();
+    result.epoch   = now.unixtime();
     result.valid   = true;
 
-    char buf[20];
-    snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u",
-        result.year, result.month, result.day,
-        result.hour, result.minute, result.second);
-    result.timestamp = String(buf);
-
     return result;
 }
 
-String rtcGetTimestamp() {
-    if (!_rtcAvailable) {
-        char buf[20];
-        snprintf(buf, sizeof(buf), "BOOT+%lus", millis() / 1000);
-        return String(buf);
+const char* rtcFormatTimestamp(const RTCDateTime& dt, char* buf, size_t len) {
+    if (!dt.valid) {
+        snprintf(buf, len, "BOOT+%lus", millis() / 1000);
+    } else {
+        snprintf(buf, len, "%04u-%02u-%02u %02u:%02u:%02u",
+            dt.year, dt.month, dt.day,
+            dt.hour, dt.minute, dt.second);
     }
+    return buf;
+}
+
+const char* rtcFormatTimestamp(char* buf, size_t len) {
+    return rtcFormatTimestamp(rtcGetDateTime(), buf, len);
+}
 
-    RTCDateTime dt = rtcGetDateTime();
-    return dt.valid ? dt.timestamp : "INVALID";
+uint32_t rtcGetEpoch() {
+    if (!_rtcAvailable) return 0;
+    return rtc.now().unixtime();
 }
 
 void rtcSetDateTime(uint16_t year, uint8_t month, uint8_t day,
@@ -15,13 +15,19 @@ struct RTCDateTime {
     uint8_t  minute;
     uint8_t  second;
     bool     valid;
-    String   timestamp;  // "YYYY-MM-DD HH:MM:SS"
+    uint32_t epoch;      // Unix seconds (0 when !valid)
 };
 
+// Fixed buffer sizes for the allocation-free formatters below
+#define RTC_TIMESTAMP_LEN 20   // "YYYY-MM-DD HH:MM:SS" + NUL
+
 void        rtcInit();
 bool        rtcIsAvailable();
 RTCDateTime rtcGetDateTime();
-String      rtcGetTimestamp();  // Returns "YYYY-MM-DD HH:MM:SS" or "BOOT+Xs" fallback
+// Writes "YYYY-MM-DD HH:MM:SS" (or "BOOT+Xs" fallback) into buf; returns buf
+const char* rtcFormatTimestamp(char* buf, size_t len);
+const char* rtcFormatTimestamp(const RTCDateTime& dt, char* buf, size_t len);
+uint32_t    rtcGetEpoch();      // Unix seconds, or 0 when the RTC is unavailable
 void        rtcSetDateTime(uint16_t year, uint8_t month, uint8_t day,
                             uint8_t hour, uint8_t minute, uint8_t second);
 
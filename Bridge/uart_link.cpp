@@ -0,0 +1,302 @@
+#include "uart_link.h"
+#include <driver/uart.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/ringbuf.h>
+#include <freertos/task.h>
+
+#define UART_LINK_PORT        UART_NUM_1
+#define UART_LINK_RX_BUF      2048
+#define UART_LINK_TX_BUF      1024
+#define UART_LINK_EVT_QUEUE   20
+#define UART_LINK_RING_BYTES  4096
+#define UART_LINK_TASK_STACK  4096
+#define UART_LINK_TASK_PRIO   5    // above loopTask so bursts are drained promptly
+#define UART_LINK_TICK_MS     100
+#define LINK_PING_IDLE_MS     10000
+#define LINK_PING_TIMEOUT_MS  1000
+#define LINK_PING_MAX_MISSES  3
+
+// Ring item header; followed by the NUL-terminated payload or line
+struct ItemHeader {
+    int64_t  rxUs;
+    uint8_t  isFrame;
+    uint8_t  type;
+    uint8_t  id;
+    uint16_t len;
+};
+
+static QueueHandle_t uartQueue = nullptr;
+static RingbufHandle_t msgRing = nullptr;
+static UartLinkStats stats = {};
+static link_decoder_t decoder;
+static portMUX_TYPE idMux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t nextId = 0;
+
+// Link supervision, owned by the link task
+static volatile uint32_t targetBaud = 0;       // 0 = stay at the current rate
+static volatile bool resyncRequested = false;
+static uint8_t  baudReqId = 0;
+static uint8_t  pingId = 0;
+static uint32_t pingSentMs = 0;
+static uint32_t lastFrameMs = 0;
+static uint32_t pingMisses = 0;
+
+static uint8_t allocId() {
+    portENTER_CRITICAL(&idMux);
+    if (++nextId == 0) nextId = 1;
+    uint8_t id = nextId;
+    portEXIT_CRITICAL(&idMux);
+    return id;
+}
+
+static bool sendFrame(uint8_t type, uint8_t id, const void* payload, uint16_t len) {
+    uint8_t frame[LINK_MAX_FRAME];
+    size_t n = link_frame_encode(frame, sizeof(frame), type, id, payload, len);
+    if (n == 0) return false;
+    return uart_write_bytes(UART_LINK_PORT, (const char*)frame, n) == (int)n;
+}
+
+static void pushItem(bool isFrame, uint8_t type, uint8_t id,
+                     const void* data, size_t len, int64_t rxUs) {
+    uint8_t item[sizeof(ItemHeader) + UART_LINK_MAX_LINE];
+    if (len > UART_LINK_MAX_LINE - 1) len = UART_LINK_MAX_LINE - 1;
+
+    ItemHeader hdr = { rxUs, isFrame, type, id, (uint16_t)len };
+    memcpy(item, &hdr, sizeof(hdr));
+    memcpy(item + sizeof(hdr), data, len);
+    item[sizeof(hdr) + len] = '\0';
+
+    if (xRingbufferSend(msgRing, item, sizeof(hdr) + len + 1, 0) != pdTRUE) {
+        stats.ringDrops++;
+        return;
+    }
+    if (isFrame) stats.frames++;
+    else stats.lines++;
+}
+
+static void setBaud(uint32_t baud) {
+    uart_wait_tx_done(UART_LINK_PORT, pdMS_TO_TICKS(50));
+    uart_set_baudrate(UART_LINK_PORT, baud);
+    link_decoder_reset(&decoder);
+    stats.baud = baud;
+}
+
+// Answers to our own SET_BAUD and PING never reach loop()
+static bool handleControlFrame(const link_frame_t& f) {
+    if (f.id == 0) return false;
+
+    if (f.id == baudReqId) {
+        baudReqId = 0;
+        if (f.type == LINK_MSG_RSP_OK) {
+            if (stats.baud != targetBaud) setBaud(targetBaud);
+        } else {
+            targetBaud = 0;  // peer can't do it; stay where we are
+        }
+        return true;
+    }
+
+    if (f.id == pingId) {
+        pingId = 0;
+        return true;
+    }
+    return false;
+}
+
+static void feedBytes(const uint8_t* data, size_t len, int64_t rxUs) {
+    static char line[UART_LINK_MAX_LINE];
+    static size_t lineLen = 0;
+    static bool lineOverflow = false;
+
+    for (size_t i = 0; i < len; i++) {
+        link_dec_result_t res = link_decoder_feed(&decoder, data[i]);
+
+        if (res == LINK_DEC_FRAME) {
+            lastFrameMs = millis();
+            pingMisses = 0;
+            if (!handleControlFrame(decoder.frame)) {
+                pushItem(true, decoder.frame.type, decoder.frame.id,
+                         decoder.frame.payload, decoder.frame.len, rxUs);
+            }
+            continue;
+        }
+        if (res == LINK_DEC_BUSY) continue;
+
+        // Console text: assemble lines, keep them for debug forwarding
+        char c = (char)data[i];
+        if (c == '\r') continue;
+        if (c == '\n') {
+            if (lineOverflow) stats.tooLong++;
+            else if (lineLen > 0) pushItem(false, 0, 0, line, lineLen, rxUs);
+            lineLen = 0;
+            lineOverflow = false;
+        } else if (lineLen < sizeof(line) - 1) {
+            line[lineLen++] = c;
+        } else {
+            lineOverflow = true;
+        }
+    }
+    stats.crcErrors = decoder.crc_errors + decoder.oversize;
+}
+
+static void superviseLink() {
+    uint32_t now = millis();
+
+    if (resyncRequested) {
+        resyncRequested = false;
+        pingMisses = 0;
+        if (targetBaud) {
+            uint32_t rate = targetBaud;
+            baudReqId = allocId();
+            sendFrame(LINK_MSG_SET_BAUD, baudReqId, &rate, sizeof(rate));
+        }
+    }
+
+    if (pingId && now - pingSentMs > LINK_PING_TIMEOUT_MS) {
+        pingId = 0;
+        stats.pingsMissed++;
+        if (++pingMisses >= LINK_PING_MAX_MISSES && targetBaud) {
+            // Peer probably rebooted at the default rate, or we missed its
+            // switch: flip our rate and ask again.
+            setBaud(stats.baud == LINK_DEFAULT_BAUD ? targetBaud : LINK_DEFAULT_BAUD);
+            resyncRequested = true;
+        }
+    }
+
+    if (!pingId && now - lastFrameMs > LINK_PING_IDLE_MS) {
+        pingId = allocId();
+        pingSentMs = now;
+        sendFrame(LINK_MSG_PING, pingId, nullptr, 0);
+    }
+}
+
+static void uartLinkTask(void* arg) {
+    uart_event_t event;
+    uint8_t chunk[256];
+
+    for (;;) {
+        if (xQueueReceive(uartQueue, &event, pdMS_TO_TICKS(UART_LINK_TICK_MS)) == pdTRUE) {
+            switch (event.type) {
+                case UART_DATA: {
+                    int64_t now = esp_timer_get_time();
+                    size_t remaining = event.size;
+                    while (remaining > 0) {
+                        size_t want = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+                        int n = uart_read_bytes(UART_LINK_PORT, chunk, want, 0);
+                        if (n <= 0) break;
+                        feedBytes(chunk, (size_t)n, now);
+                        remaining -= (size_t)n;
+                    }
+                    break;
+                }
+
+                case UART_FIFO_OVF:
+                    stats.fifoOverflows++;
+                    uart_flush_input(UART_LINK_PORT);
+                    xQueueReset(uartQueue);
+                    link_decoder_reset(&decoder);
+                    break;
+
+                case UART_BUFFER_FULL:
+                    stats.bufferFull++;
+                    uart_flush_input(UART_LINK_PORT);
+                    xQueueReset(uartQueue);
+                    link_decoder_reset(&decoder);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        superviseLink();
+    }
+}
+
+bool uartLinkBegin(uint32_t baud, int rxPin, int txPin) {
+    uart_config_t cfg = {};
+    cfg.baud_rate  = (int)baud;
+    cfg.data_bits  = UART_DATA_8_BITS;
+    cfg.parity     = UART_PARITY_DISABLE;
+    cfg.stop_bits  = UART_STOP_BITS_1;
+    cfg.flow_ctrl  = UART_HW_FLOWCTRL_DISABLE;
+    cfg.source_clk = UART_SCLK_DEFAULT;
+
+    if (uart_driver_install(UART_LINK_PORT, UART_LINK_RX_BUF, UART_LINK_TX_BUF,
+                            UART_LINK_EVT_QUEUE, &uartQueue, 0) != ESP_OK) {
+        Serial.println("[UART] Driver install failed");
+        return false;
+    }
+    uart_param_config(UART_LINK_PORT, &cfg);
+    uart_set_pin(UART_LINK_PORT, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+
+    link_decoder_reset(&decoder);
+    stats.baud = baud;
+
+    msgRing = xRingbufferCreate(UART_LINK_RING_BYTES, RINGBUF_TYPE_NOSPLIT);
+    if (!msgRing) {
+        Serial.println("[UART] Message ring allocation failed");
+        return false;
+    }
+
+    xTaskCreate(uartLinkTask, "uart_link", UART_LINK_TASK_STACK, nullptr,
+                UART_LINK_TASK_PRIO, nullptr);
+    return true;
+}
+
+bool uartLinkNegotiateBaud(uint32_t baud, uint32_t timeoutMs) {
+    targetBaud = baud;
+    resyncRequested = true;
+
+    uint32_t start = millis();
+    while (millis() - start < timeoutMs) {
+        if (stats.baud == baud) {
+            Serial.printf("[UART] Link running at %lu baud\n", (unsigned long)baud);
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    Serial.printf("[UART] Commissioner not answering, staying at %lu baud for now\n",
+                  (unsigned long)stats.baud);
+    return false;
+}
+
+bool uartLinkRead(UartLinkMsg& msg) {
+    if (!msgRing) return false;
+
+    size_t size = 0;
+    uint8_t* item = (uint8_t*)xRingbufferReceive(msgRing, &size, 0);
+    if (!item) return false;
+
+    ItemHeader hdr;
+    memcpy(&hdr, item, sizeof(hdr));
+    msg.isFrame = hdr.isFrame;
+    msg.type    = hdr.type;
+    msg.id      = hdr.id;
+    msg.len     = hdr.len;
+    memcpy(msg.data, item + sizeof(hdr), (size_t)hdr.len + 1);
+    vRingbufferReturnItem(msgRing, item);
+
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - hdr.rxUs);
+    stats.lastLatencyUs = latency;
+    if (latency > stats.maxLatencyUs) stats.maxLatencyUs = latency;
+    return true;
+}
+
+uint8_t uartLinkSendCommand(const char* cmd) {
+    size_t len = strlen(cmd);
+    while (len > 0 && (cmd[len - 1] == '\n' || cmd[len - 1] == '\r')) len--;
+    if (len > LINK_MAX_PAYLOAD) return 0;
+
+    uint8_t id = allocId();
+    return sendFrame(LINK_MSG_CMD, id, cmd, (uint16_t)len) ? id : 0;
+}
+
+void uartLinkFlush() {
+    uart_wait_tx_done(UART_LINK_PORT, pdMS_TO_TICKS(100));
+}
+
+UartLinkStats uartLinkGetStats() {
+    return stats;
+}
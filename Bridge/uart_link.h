@@ -0,0 +1,55 @@
+#ifndef UART_LINK_H
+#define UART_LINK_H
+
+#include <Arduino.h>
+#include <hvac_link_frame.h>
+
+// Bridge <-> Commissioner UART. Reception runs in its own task on the
+// ESP-IDF UART event queue. Incoming bytes are split into framed protocol
+// messages (hvac_link_frame.h) and plain console text lines; both are
+// parked in a ring buffer until loop() pops them with uartLinkRead().
+//
+// The task also keeps the link alive: it pings when idle and, after
+// repeated misses, re-synchronises the baud rate with the Commissioner.
+
+#define UART_LINK_MAX_LINE 512
+
+struct UartLinkMsg {
+    bool     isFrame;   // false: console text line (debug only)
+    uint8_t  type;      // link_msg_type_t when isFrame
+    uint8_t  id;        // request id echoed by the Commissioner (0 for events)
+    uint16_t len;
+    char     data[UART_LINK_MAX_LINE];  // NUL-terminated payload / line
+};
+
+struct UartLinkStats {
+    uint32_t lines;          // console text lines delivered to the ring
+    uint32_t frames;         // valid frames delivered to the ring
+    uint32_t crcErrors;      // frames dropped on CRC / length errors
+    uint32_t fifoOverflows;  // HW FIFO overflowed before the driver drained it
+    uint32_t bufferFull;     // driver RX buffer filled up
+    uint32_t ringDrops;      // messages lost because the consumer fell behind
+    uint32_t tooLong;        // text lines longer than UART_LINK_MAX_LINE, discarded
+    uint32_t pingsMissed;
+    uint32_t baud;           // current line rate
+    uint32_t lastLatencyUs;  // received -> popped by the consumer
+    uint32_t maxLatencyUs;
+};
+
+bool uartLinkBegin(uint32_t baud, int rxPin, int txPin);
+
+// Ask the Commissioner to move to `baud`. Waits up to timeoutMs for the
+// switch; if the peer isn't up yet the link task keeps retrying.
+bool uartLinkNegotiateBaud(uint32_t baud, uint32_t timeoutMs);
+
+// Pops the oldest message into msg. Non-blocking.
+bool uartLinkRead(UartLinkMsg& msg);
+
+// Sends a text command as a LINK_MSG_CMD frame. Returns its request id
+// (never 0), or 0 if it could not be sent.
+uint8_t uartLinkSendCommand(const char* cmd);
+void    uartLinkFlush();
+
+UartLinkStats uartLinkGetStats();
+
+#endif
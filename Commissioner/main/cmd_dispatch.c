@@ -0,0 +1,62 @@
+#include "cmd_dispatch.h"
+#include <string.h>
+
+static const char SPACES[] = " \t\r\n";
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Split on spaces in place; returns the number of tokens
+static int tokenize(char *s, char **argv, int max)
+{
+    int argc = 0;
+    while (*s && argc < max) {
+        s += strspn(s, SPACES);
+        if (!*s) break;
+        argv[argc++] = s;
+        s += strcspn(s, SPACES);
+        if (*s) *s++ = '\0';
+    }
+    return argc;
+}
+
+static const cmd_entry_t *lookup(const cmd_entry_t *table, size_t count, const char *word, size_t len)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (strncmp(table[i].name, word, len) == 0 && table[i].name[len] == '\0') {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+cmd_result_t cmd_dispatch(const cmd_entry_t *table, size_t count, char *line, cmd_verify_t verify)
+{
+    // Trim both ends in place
+    while (is_space(*line)) line++;
+    size_t len = strlen(line);
+    while (len > 0 && is_space(line[len - 1])) line[--len] = '\0';
+    if (len == 0) return CMD_EMPTY;
+
+    // Identify the command from its first word before anything is modified,
+    // so the signature is checked over the untouched text.
+    size_t word_len = 0;
+    while (line[word_len] && !is_space(line[word_len]) && line[word_len] != '|') word_len++;
+
+    const cmd_entry_t *entry = lookup(table, count, line, word_len);
+    if (!entry) return CMD_UNKNOWN;
+
+    char *cmd_part = line;
+    if (entry->needs_signature && !(verify && verify(line, &cmd_part))) {
+        return CMD_BAD_SIGNATURE;
+    }
+
+    char *argv[CMD_MAX_ARGS];
+    int argc = tokenize(cmd_part, argv, CMD_MAX_ARGS);
+    if (argc - 1 < entry->min_args) return CMD_TOO_FEW_ARGS;
+
+    entry->handler(argc, argv);
+    return CMD_OK;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Table-driven UART command dispatcher.
+ *
+ * Parses a command line in place (no copies, no heap) and calls the
+ * handler registered for its first word. Has no ESP-IDF dependencies so
+ * it also builds on the host.
+ */
+
+#define CMD_MAX_ARGS 8   // including the command word itself
+
+/**
+ * @brief Command handler. argv[0] is the command word; argv[1..argc-1] are
+ *        the space-separated arguments, all pointing into the input line.
+ */
+typedef void (*cmd_handler_t)(int argc, char **argv);
+
+/**
+ * @brief Signature check applied before tokenising signed commands.
+ *
+ * Same contract as verify_command_signature(): may split the line at the
+ * signature separator and returns the command part through cmd_part.
+ */
+typedef bool (*cmd_verify_t)(char *line, char **cmd_part);
+
+typedef struct {
+    const char   *name;
+    uint8_t       min_args;         // arguments required after the command word
+    bool          needs_signature;  // "CMD ...|<hmac>" form
+    cmd_handler_t handler;
+} cmd_entry_t;
+
+typedef enum {
+    CMD_OK,
+    CMD_EMPTY,
+    CMD_UNKNOWN,
+    CMD_TOO_FEW_ARGS,
+    CMD_BAD_SIGNATURE,
+} cmd_result_t;
+
+/**
+ * @brief Trim, look up, verify (if required), tokenise and run one command.
+ *
+ * @param line   Mutable NUL-terminated command line; modified in place.
+ * @param verify Signature checker for entries with needs_signature.
+ */
+cmd_result_t cmd_dispatch(const cmd_entry_t *table, size_t count, char *line, cmd_verify_t verify);
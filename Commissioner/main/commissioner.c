@@ -1,4 +1,6 @@
 #include "commissioner.h"
+#include "uart_rx.h"
+#include "joiner_manager.h"
 #include "esp_log.h"
 #include "esp_openthread.h"
 #include "esp_openthread_lock.h"
@@ -41,8 +43,10 @@ static void commissioner_joiner_cb(otCommissionerJoinerEvent event,
                                    const otExtAddress *joiner_id,
                                    void *context)
 {
-    char id_str[17] = {0};
-    if (joiner_id) {
+    // Report against the EUI64 the joiner was added with; fall back to the
+    // Joiner ID for wildcard joiners, which have no EUI64 on record.
+    char id_str[JOINER_EUI64_STR_LEN] = {0};
+    if (!joiner_manager_on_event(event, info, joiner_id, id_str) && joiner_id) {
         for (int i = 0; i < 8; i++) sprintf(id_str + (i * 2), "%02X", joiner_id->m8[i]);
     }
 
@@ -52,15 +56,18 @@ static void commissioner_joiner_cb(otCommissionerJoinerEvent event,
             break;
         case OT_COMMISSIONER_JOINER_CONNECTED:
             ESP_LOGI(TAG, "[+] JOIN_CONN: Child %s connected (DTLS Up)", id_str);
+            uart_link_event("JOINER_EVENT CONNECTED %s", id_str);
             break;
         case OT_COMMISSIONER_JOINER_FINALIZE:
             ESP_LOGI(TAG, "[#] JOIN_FIN: Dataset sent to %s", id_str);
             break;
         case OT_COMMISSIONER_JOINER_END:
             ESP_LOGW(TAG, "[*] JOIN_END: Session closed for %s", id_str);
+            uart_link_event("JOINER_EVENT END %s", id_str);
             break;
         case OT_COMMISSIONER_JOINER_REMOVED:
-            ESP_LOGE(TAG, "[-] JOIN_REMOVED: Joiner entry cleared/timed out");
+            ESP_LOGE(TAG, "[-] JOIN_REMOVED: Joiner entry %s cleared/timed out", id_str);
+            uart_link_event("JOINER_EVENT REMOVED %s", id_str);
             break;
         default:
             ESP_LOGD(TAG, "Unknown Joiner Event: %d", event);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "hvac_link_frame.h"
+
 // --- Security Configuration ---
 #define SECURE_HMAC_KEY "PROD_SECRET_KEY_CHANGE_ME" // Shared with Bridge ESP32
 #define SECURE_COMMAND_TIMEOUT_MS 5000              // Max time to acquire lock
@@ -14,3 +16,40 @@
 // --- Thread Configuration ---
 #define THREAD_TASK_STACK_SIZE      8192
 #define THREAD_TASK_PRIORITY        5
+
+// --- Network Formation ---
+// FORM_NET energy-scans, then active-scans these channels before forming on
+// the quietest one (common/hvac_channel_select.h). Both scans together must
+// fit the Bridge's FORM_NET -> NETWORK_FORMED window (30 s).
+#define FORM_CHANNEL_MASK           0x07FFF800u  // channels 11-26
+#define FORM_ENERGY_SCAN_MS         200  // per channel
+#define FORM_ACTIVE_SCAN_MS         0    // per channel; 0 = OpenThread's default (~300 ms)
+
+// --- Joiner Management ---
+// Per-EUI64 joiners tracked in parallel. OpenThread keeps its own table
+// (OPENTHREAD_CONFIG_COMMISSIONER_MAX_JOINER_ENTRIES, 2 by default), which
+// also holds the wildcard joiner: ../CMakeLists.txt sets it to
+// JOINER_OT_ENTRIES, and joiner_manager.c refuses to build with fewer.
+#define JOINER_TABLE_SIZE           LINK_MAX_JOINERS
+#define JOINER_OT_ENTRIES           (JOINER_TABLE_SIZE + 1)
+#define JOINER_DEFAULT_TIMEOUT_SEC  120
+#define JOINER_MAX_TIMEOUT_SEC      900
+#define JOINER_BATCH_MAX            16   // devices per ADD_BATCH (one link frame)
+
+// --- Telemetry Ingestion ---
+// The UDP callback only copies datagrams into a ring; a worker task decodes
+// and forwards them off the OpenThread task.
+#define UDP_TELEMETRY_MAX_PAYLOAD   128  // bytes kept per datagram; longer ones are truncated
+#define UDP_TELEMETRY_QUEUE_LEN     32   // ring slots, power of two
+#define UDP_TELEMETRY_TASK_STACK    4096
+#define UDP_TELEMETRY_TASK_PRIORITY 4    // below the OpenThread task
+
+// --- Telemetry Table ---
+// Latest reading per sensor, keyed by the source address IID.
+#define TELEMETRY_TABLE_SLOTS       64   // open-addressing slots, power of two
+#define TELEMETRY_MAX_SENSORS       48   // keep load <= 3/4; the stalest sensor is evicted beyond this
+#define TELEMETRY_MAX_CHANNELS      6    // values kept per sensor
+#define TELEMETRY_MISSING_GRACE_MS  90000  // slack before a silent sensor is "missing";
+                                           // covers SED batching (BATCH_MAX_AGE_MS) and retries
+#define TELEMETRY_CONFIG_RETRY_MS   60000  // min time between config pushes to one sensor
+#define TELEMETRY_CONFIG_GREET_MS   600000 // ... when only answering a multicast report
@@ -1,14 +1,72 @@
 #include "joiner_manager.h"
+#include "config.h"
+#include "uart_rx.h"
 #include "esp_log.h"
 #include "esp_openthread.h"
 #include "esp_openthread_lock.h"
 #include "openthread/commissioner.h"
+#include "mbedtls/sha256.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+#if !defined(OPENTHREAD_CONFIG_COMMISSIONER_MAX_JOINER_ENTRIES) || \
+    OPENTHREAD_CONFIG_COMMISSIONER_MAX_JOINER_ENTRIES < JOINER_OT_ENTRIES
+#error "OPENTHREAD_CONFIG_COMMISSIONER_MAX_JOINER_ENTRIES must hold JOINER_TABLE_SIZE plus the wildcard joiner"
+#endif
+
 static const char *TAG = "JOINER_MGR";
 
+// --- Pending Joiner Table ---
+// Only touched with the OpenThread lock held (UART add path and the
+// commissioner callbacks, which run on the OT task).
+typedef struct {
+    bool         in_use;
+    otExtAddress eui64;
+    otExtAddress joiner_id;   // what the commissioner callbacks report
+    char         eui64_str[JOINER_EUI64_STR_LEN];
+    uint32_t     deadline_ms;
+    bool         finalized;   // commissioning dataset delivered
+    int16_t      batch_idx;   // index into s_batch, -1 for single adds
+} joiner_entry_t;
+
+static joiner_entry_t s_joiners[JOINER_TABLE_SIZE];
+
+// --- Batch Queue ---
+// Devices from one ADD_BATCH command, registered in waves as joiner table
+// slots (ours and OpenThread's) become free.
+typedef enum {
+    BATCH_QUEUED,
+    BATCH_ADDED,
+    BATCH_JOINED,
+    BATCH_FAILED,
+} batch_state_t;
+
+typedef struct {
+    otExtAddress  eui64;
+    char          eui64_str[JOINER_EUI64_STR_LEN];
+    char          pskd[JOINER_PSKD_MAX_LEN + 1];
+    batch_state_t state;
+} batch_item_t;
+
+static batch_item_t s_batch[JOINER_BATCH_MAX];
+static uint32_t     s_batch_count;
+static uint32_t     s_batch_timeout;
+static uint32_t     s_batch_start_ms;
+static uint32_t     s_batch_deadline_ms;  // pushed out on every registration
+static bool         s_batch_active;
+
+// Grace period before a stale entry is reclaimed without a REMOVED event
+#define JOINER_EXPIRY_GRACE_MS 10000
+#define JOINER_POLL_MS         1000
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
 // --- Private Helper: Hex String to Byte Array ---
 static bool hex_to_bytes(const char *hex_str, uint8_t *bytes, size_t len) {
     if (strlen(hex_str) != len * 2) return false;
@@ -21,12 +79,167 @@ static bool hex_to_bytes(const char *hex_str, uint8_t *bytes, size_t len) {
     return true;
 }
 
+// Joiner ID = first 8 bytes of SHA-256(EUI64) with the local bit set,
+// as computed by OpenThread (Thread spec 8.4.1.2.2).
+static void compute_joiner_id(const otExtAddress *eui64, otExtAddress *joiner_id)
+{
+    uint8_t hash[32];
+    mbedtls_sha256(eui64->m8, sizeof(eui64->m8), hash, 0);
+    memcpy(joiner_id->m8, hash, sizeof(joiner_id->m8));
+    joiner_id->m8[0] |= 0x02;
+}
+
+static joiner_entry_t *find_by_eui(const otExtAddress *eui64)
+{
+    for (int i = 0; i < JOINER_TABLE_SIZE; i++) {
+        if (s_joiners[i].in_use && memcmp(&s_joiners[i].eui64, eui64, sizeof(*eui64)) == 0) {
+            return &s_joiners[i];
+        }
+    }
+    return NULL;
+}
+
+static joiner_entry_t *find_by_joiner_id(const otExtAddress *joiner_id)
+{
+    for (int i = 0; i < JOINER_TABLE_SIZE; i++) {
+        if (s_joiners[i].in_use && memcmp(&s_joiners[i].joiner_id, joiner_id, sizeof(*joiner_id)) == 0) {
+            return &s_joiners[i];
+        }
+    }
+    return NULL;
+}
+
+// Free an entry and settle the batch device it was registered for
+static void release_entry(joiner_entry_t *e, bool joined, const char *reason)
+{
+    e->in_use = false;
+    if (e->batch_idx < 0 || !s_batch_active) return;
+
+    batch_item_t *item = &s_batch[e->batch_idx];
+    if (item->state != BATCH_ADDED) return;
+    item->state = joined ? BATCH_JOINED : BATCH_FAILED;
+    if (joined) {
+        uart_link_event("BATCH JOINED %s", item->eui64_str);
+    } else {
+        uart_link_event("BATCH FAILED %s %s", item->eui64_str, reason);
+    }
+}
+
+// Reclaim entries whose REMOVED event never arrived
+static void expire_entries(void)
+{
+    uint32_t now = now_ms();
+    for (int i = 0; i < JOINER_TABLE_SIZE; i++) {
+        joiner_entry_t *e = &s_joiners[i];
+        if (e->in_use && (int32_t)(now - (e->deadline_ms + JOINER_EXPIRY_GRACE_MS)) >= 0) {
+            ESP_LOGW(TAG, "Reclaiming stale joiner %s", e->eui64_str);
+            release_entry(e, e->finalized, "expired");
+        }
+    }
+}
+
+static joiner_entry_t *alloc_entry(void)
+{
+    expire_entries();
+    for (int i = 0; i < JOINER_TABLE_SIZE; i++) {
+        if (!s_joiners[i].in_use) return &s_joiners[i];
+    }
+    return NULL;
+}
+
+// Register one joiner; caller holds the OpenThread lock.
+static otError add_joiner_locked(const otExtAddress *p_id, const char *eui64_str,
+                                 const char *pskd, uint32_t timeout, int16_t batch_idx)
+{
+    // Reserve a table slot for EUI64-specific joiners
+    joiner_entry_t *entry = NULL;
+    if (p_id) {
+        if (find_by_eui(p_id)) {
+            ESP_LOGW(TAG, "Joiner already pending: %s", eui64_str);
+            return OT_ERROR_ALREADY;
+        }
+        entry = alloc_entry();
+        if (!entry) {
+            ESP_LOGW(TAG, "Joiner table full (%d)", JOINER_TABLE_SIZE);
+            return OT_ERROR_NO_BUFS;
+        }
+    }
+
+    otInstance *instance = esp_openthread_get_instance();
+    otError err = otCommissionerAddJoiner(instance, p_id, pskd, timeout);
+
+    if (err == OT_ERROR_NONE && entry) {
+        entry->in_use = true;
+        entry->eui64 = *p_id;
+        compute_joiner_id(p_id, &entry->joiner_id);
+        snprintf(entry->eui64_str, sizeof(entry->eui64_str), "%s", eui64_str);
+        entry->deadline_ms = now_ms() + timeout * 1000;
+        entry->finalized = false;
+        entry->batch_idx = batch_idx;
+    }
+
+    if (err == OT_ERROR_NONE) {
+        ESP_LOGI(TAG, "Joiner added successfully: %s (%lus)", eui64_str, (unsigned long)timeout);
+    } else {
+        ESP_LOGW(TAG, "Failed to add joiner: %s (%d)", eui64_str, err);
+    }
+    return err;
+}
+
+// Emit the summary once every batch device has an outcome
+static void batch_check_done(void)
+{
+    uint32_t joined = 0, failed = 0;
+    for (uint32_t i = 0; i < s_batch_count; i++) {
+        if (s_batch[i].state == BATCH_JOINED) joined++;
+        else if (s_batch[i].state == BATCH_FAILED) failed++;
+        else return;
+    }
+
+    // Entries outliving the batch must not settle items of the next one
+    for (int i = 0; i < JOINER_TABLE_SIZE; i++) s_joiners[i].batch_idx = -1;
+
+    uint32_t elapsed = now_ms() - s_batch_start_ms;
+    uint32_t per_min = elapsed ? (uint32_t)((uint64_t)joined * 60000 / elapsed) : 0;
+    ESP_LOGI(TAG, "Batch done: %lu joined, %lu failed in %lums",
+             (unsigned long)joined, (unsigned long)failed, (unsigned long)elapsed);
+    uart_link_event("BATCH DONE joined=%lu failed=%lu ms=%lu rate=%lu/min",
+                    (unsigned long)joined, (unsigned long)failed,
+                    (unsigned long)elapsed, (unsigned long)per_min);
+    s_batch_active = false;
+}
+
+// Register queued batch devices until a table runs out of room; the next
+// wave goes out as END/REMOVED events free slots. Caller holds the lock.
+static void batch_pump_locked(void)
+{
+    if (!s_batch_active) return;
+
+    for (uint32_t i = 0; i < s_batch_count; i++) {
+        batch_item_t *item = &s_batch[i];
+        if (item->state != BATCH_QUEUED) continue;
+
+        otError err = add_joiner_locked(&item->eui64, item->eui64_str, item->pskd,
+                                        s_batch_timeout, (int16_t)i);
+        if (err == OT_ERROR_NO_BUFS) break;  // wait for the next wave
+
+        if (err == OT_ERROR_NONE) {
+            item->state = BATCH_ADDED;
+            s_batch_deadline_ms = now_ms() + s_batch_timeout * 1000 + 2 * JOINER_EXPIRY_GRACE_MS;
+            uart_link_event("BATCH ADDED %s", item->eui64_str);
+        } else {
+            item->state = BATCH_FAILED;
+            uart_link_event("BATCH FAILED %s add_error_%d", item->eui64_str, err);
+        }
+    }
+    batch_check_done();
+}
+
 // --- Public API ---
 otError joiner_add_request(const char *eui64_str, const char *pskd, uint32_t timeout)
 {
     otExtAddress id;
     otExtAddress *p_id = NULL;
-    otError err = OT_ERROR_NONE;
 
     // 1. Parse EUI64 (if not wildcard)
     if (eui64_str && strcmp(eui64_str, "*") != 0) {
@@ -43,19 +256,147 @@ otError joiner_add_request(const char *eui64_str, const char *pskd, uint32_t tim
         return OT_ERROR_BUSY;
     }
 
-    // 3. Call OpenThread API
-    otInstance *instance = esp_openthread_get_instance();
-    err = otCommissionerAddJoiner(instance, p_id, pskd, timeout);
+    // 3. Register with OpenThread and the pending table
+    otError err = add_joiner_locked(p_id, eui64_str, pskd, timeout, -1);
 
     // 4. Release Lock
     esp_openthread_lock_release();
 
-    // 5. Log Result (Internal Log)
-    if (err == OT_ERROR_NONE) {
-        ESP_LOGI(TAG, "Joiner added successfully: %s", eui64_str);
-    } else {
-        ESP_LOGW(TAG, "Failed to add joiner: %s (%d)", eui64_str, err);
+    return err;
+}
+
+otError joiner_batch_start(char *pairs, uint32_t timeout, uint32_t *count)
+{
+    uint32_t n = 0;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(1000))) {
+        ESP_LOGE(TAG, "Failed to acquire OpenThread lock");
+        return OT_ERROR_BUSY;
+    }
+    if (s_batch_active) {
+        esp_openthread_lock_release();
+        return OT_ERROR_BUSY;
     }
 
-    return err;
-}
\ No newline at end of file
+    // Validate the whole list before registering anything: "EUI:PSKD,EUI:PSKD"
+    char *save = NULL;
+    for (char *tok = strtok_r(pairs, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *colon = strchr(tok, ':');
+        if (!colon || n >= JOINER_BATCH_MAX) {
+            esp_openthread_lock_release();
+            return colon ? OT_ERROR_NO_BUFS : OT_ERROR_INVALID_ARGS;
+        }
+        *colon = '\0';
+        const char *pskd = colon + 1;
+        size_t pskd_len = strlen(pskd);
+
+        batch_item_t *item = &s_batch[n];
+        if (!hex_to_bytes(tok, item->eui64.m8, 8) ||
+            pskd_len < JOINER_PSKD_MIN_LEN || pskd_len > JOINER_PSKD_MAX_LEN) {
+            ESP_LOGE(TAG, "Invalid batch entry %lu", (unsigned long)n);
+            esp_openthread_lock_release();
+            return OT_ERROR_INVALID_ARGS;
+        }
+        snprintf(item->eui64_str, sizeof(item->eui64_str), "%s", tok);
+        memcpy(item->pskd, pskd, pskd_len + 1);
+        item->state = BATCH_QUEUED;
+        n++;
+    }
+    if (n == 0) {
+        esp_openthread_lock_release();
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    s_batch_count = n;
+    s_batch_timeout = timeout;
+    s_batch_start_ms = now_ms();
+    s_batch_deadline_ms = s_batch_start_ms + timeout * 1000 + 2 * JOINER_EXPIRY_GRACE_MS;
+    s_batch_active = true;
+    if (count) *count = n;
+    ESP_LOGI(TAG, "Batch of %lu joiners queued", (unsigned long)n);
+
+    batch_pump_locked();
+
+    esp_openthread_lock_release();
+    return OT_ERROR_NONE;
+}
+
+bool joiner_manager_on_event(otCommissionerJoinerEvent event,
+                             const otJoinerInfo *info,
+                             const otExtAddress *joiner_id,
+                             char eui64_out[JOINER_EUI64_STR_LEN])
+{
+    joiner_entry_t *entry = NULL;
+
+    if (info && info->mType == OT_JOINER_INFO_TYPE_EUI64) {
+        entry = find_by_eui(&info->mSharedId.mEui64);
+    }
+    if (!entry && joiner_id) {
+        entry = find_by_joiner_id(joiner_id);
+    }
+
+    bool slot_freed = (event == OT_COMMISSIONER_JOINER_END || event == OT_COMMISSIONER_JOINER_REMOVED);
+    if (!entry) {
+        // A wildcard entry may have released an OpenThread slot
+        if (slot_freed) batch_pump_locked();
+        return false;
+    }
+
+    memcpy(eui64_out, entry->eui64_str, JOINER_EUI64_STR_LEN);
+
+    // A joiner may retry after a failed DTLS session, so END only completes
+    // the entry once the dataset was delivered; REMOVED always does.
+    bool done = false;
+    bool joined = false;
+    if (event == OT_COMMISSIONER_JOINER_FINALIZE) {
+        entry->finalized = true;
+    } else if (event == OT_COMMISSIONER_JOINER_END) {
+        done = joined = entry->finalized;
+    } else if (event == OT_COMMISSIONER_JOINER_REMOVED) {
+        done = true;
+        joined = entry->finalized;
+    }
+
+    if (done) release_entry(entry, joined, "expired");
+    if (slot_freed) batch_pump_locked();
+    return true;
+}
+
+void joiner_manager_poll(void)
+{
+    static uint32_t last_ms;
+    uint32_t now = now_ms();
+    if (now - last_ms < JOINER_POLL_MS) return;
+    last_ms = now;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) return;
+
+    expire_entries();
+
+    // No device registered for a whole joining window: whatever is still
+    // open (queued behind a full table, or never settled) fails
+    if (s_batch_active && (int32_t)(now - s_batch_deadline_ms) >= 0) {
+        ESP_LOGW(TAG, "Batch stalled, closing it");
+        for (uint32_t i = 0; i < s_batch_count; i++) {
+            batch_item_t *item = &s_batch[i];
+            if (item->state == BATCH_QUEUED || item->state == BATCH_ADDED) {
+                item->state = BATCH_FAILED;
+                uart_link_event("BATCH FAILED %s batch_timeout", item->eui64_str);
+            }
+        }
+    }
+
+    // Refills slots freed above, and closes the batch once all have settled
+    batch_pump_locked();
+
+    esp_openthread_lock_release();
+}
+
+uint32_t joiner_manager_pending_count(void)
+{
+    uint32_t n = 0;
+    for (int i = 0; i < JOINER_TABLE_SIZE; i++) {
+        if (s_joiners[i].in_use) n++;
+    }
+    return n;
+}
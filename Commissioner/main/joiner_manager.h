@@ -3,14 +3,77 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "openthread/error.h" // Needed for otError return type
+#include "openthread/commissioner.h"
+
+#define JOINER_EUI64_STR_LEN 17  // 16 hex chars + NUL
+#define JOINER_PSKD_MIN_LEN  6
+#define JOINER_PSKD_MAX_LEN  32
 
 /**
  * @brief Thread-safe request to add a joiner to the network.
  * * Handles parsing of the EUI64 string, locking the OpenThread stack,
- * and calling the commissioner API.
+ * and calling the commissioner API. EUI64-specific joiners are also
+ * recorded in the pending-joiner table so that commissioner events can be
+ * reported against the right device.
  * * @param eui64_str Hex string of the device EUI64 (e.g., "0011223344556677") or "*" for any.
  * @param pskd The Pre-Shared Key for Device (commissioning credential).
  * @param timeout Seconds to keep the joining window open (usually 120).
- * * @return OT_ERROR_NONE on success, or an error code on failure.
+ * * @return OT_ERROR_NONE on success, OT_ERROR_NO_BUFS if the joiner table is
+ *         full, OT_ERROR_ALREADY if the EUI64 is already pending, or another
+ *         error code on failure.
+ */
+otError joiner_add_request(const char *eui64_str, const char *pskd, uint32_t timeout);
+
+/**
+ * @brief Queue a batch of joiners and start registering them in waves.
+ *
+ * The list is validated as a whole before anything is registered. As many
+ * devices as the joiner tables allow are added immediately; the rest follow
+ * as earlier joiners finish or expire. Progress is reported through
+ * uart_link_event() as "BATCH ADDED|JOINED|FAILED <eui64>", ending with
+ * "BATCH DONE joined=.. failed=.. ms=.. rate=../min".
+ *
+ * @param pairs   Mutable "EUI64:PSKD,EUI64:PSKD,..." list; modified in place.
+ * @param timeout Joining window per device in seconds, from registration.
+ * @param count   Receives the number of devices queued.
+ *
+ * @return OT_ERROR_NONE on success, OT_ERROR_BUSY if a batch is already
+ *         running, OT_ERROR_NO_BUFS if the list exceeds JOINER_BATCH_MAX,
+ *         or OT_ERROR_INVALID_ARGS for a malformed list.
+ */
+otError joiner_batch_start(char *pairs, uint32_t timeout, uint32_t *count);
+
+/**
+ * @brief Correlate a commissioner joiner event with a pending EUI64.
+ *
+ * Call from the commissioner joiner callback (OT lock held). Matches by
+ * the joiner info when OpenThread supplies it, otherwise by the Joiner ID
+ * (SHA-256 of the EUI64). Entries are released on REMOVED, or on END
+ * once the joiner was finalized; freed slots are refilled from a running
+ * batch.
+ *
+ * @param eui64_out Receives the EUI64 hex string on a match.
+ * @return true if the event belongs to a pending EUI64-specific joiner.
+ */
+bool joiner_manager_on_event(otCommissionerJoinerEvent event,
+                             const otJoinerInfo *info,
+                             const otExtAddress *joiner_id,
+                             char eui64_out[JOINER_EUI64_STR_LEN]);
+
+/**
+ * @brief Expire joiners whose REMOVED event never arrived and close a
+ *        stalled batch.
+ *
+ * Call often (e.g. from the UART task loop); it works at most once per
+ * second and takes the OpenThread lock itself. An entry is reclaimed
+ * JOINER_EXPIRY_GRACE_MS after its joining window, failing its batch
+ * device. A batch that registers no device for a whole joining window plus
+ * twice that grace fails its remaining devices, so BATCH DONE always
+ * follows.
+ */
+void joiner_manager_poll(void);
+
+/**
+ * @brief Number of EUI64-specific joiners currently pending.
  */
-otError joiner_add_request(const char *eui64_str, const char *pskd, uint32_t timeout);
\ No newline at end of file
+uint32_t joiner_manager_pending_count(void);
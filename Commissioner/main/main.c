@@ -18,6 +18,7 @@
 #include "commissioner.h" // CRITICAL: This header must include your wrapper prototype
 #include "uart_rx.h"
 #include "udp_listener.h"
+#include "security.h"
 
 static const char *TAG = "MAIN";
 
@@ -87,7 +88,9 @@ void app_main(void)
                                                ESP_EVENT_ANY_ID, 
                                                on_thread_state_changed, NULL));
 
-    // 5. Start UART Task (MUST be before thread_init blocks)
+    // 5. Derive the command-signing key state once, then start UART Task
+    //    (MUST be before thread_init blocks)
+    security_init();
     uart_rx_init();
 
     // 6. Start Thread
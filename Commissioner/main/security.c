@@ -1,60 +1,147 @@
-#include "mbedtls/md.h"
+#include "security.h"
+#include "mbedtls/sha256.h"
 #include "config.h"
 #include "esp_log.h"
 #include <string.h>
-#include <ctype.h>
 #include <stdio.h>
 
 static const char *TAG = "SECURITY";
 
-/**
- * @brief Verified Command Parser (Bypass Mode for Testing)
- * * In production, this requires "COMMAND|SIGNATURE".
- * For current testing, it accepts "COMMAND" directly.
- */
-bool verify_command_signature(char *input_buffer, char **cmd_part)
+#define HMAC_BLOCK_SIZE  64
+#define HMAC_DIGEST_SIZE 32
+
+// SHA-256 state after absorbing (key ^ ipad) and (key ^ opad). Each message
+// starts from a copy of these, so the key schedule is paid once per key
+// instead of once per command.
+static mbedtls_sha256_context s_inner_base;
+static mbedtls_sha256_context s_outer_base;
+static bool s_key_ready = false;
+
+bool security_set_key(const uint8_t *key, size_t key_len)
 {
-    // --- BYPASS LOGIC START ---
-    // We check if a separator exists. If it does, we process the signature.
-    // If it doesn't, we treat the whole buffer as the command for easy testing.
-    
-    char *separator = strrchr(input_buffer, '|');
-    
-    if (!separator) {
-        // No signature provided, but we allow it for commercial bench testing
-        ESP_LOGW(TAG, "Bypassing security: No signature found, processing as raw command");
-        *cmd_part = input_buffer;
-        return true; 
+    uint8_t block[HMAC_BLOCK_SIZE] = {0};
+    uint8_t pad[HMAC_BLOCK_SIZE];
+
+    // Keys longer than the block are hashed first (RFC 2104)
+    if (key_len > HMAC_BLOCK_SIZE) {
+        if (mbedtls_sha256(key, key_len, block, 0) != 0) return false;
+    } else {
+        memcpy(block, key, key_len);
     }
-    
-    // If a separator IS found, we still perform the check to test your signature logic
-    *separator = '\0'; 
-    char *received_sig_hex = separator + 1;
-    *cmd_part = input_buffer;
 
-    uint8_t hmac_output[32];
+    if (s_key_ready) {
+        mbedtls_sha256_free(&s_inner_base);
+        mbedtls_sha256_free(&s_outer_base);
+    }
+    mbedtls_sha256_init(&s_inner_base);
+    mbedtls_sha256_init(&s_outer_base);
+
+    for (int i = 0; i < HMAC_BLOCK_SIZE; i++) pad[i] = block[i] ^ 0x36;
+    int rc = mbedtls_sha256_starts(&s_inner_base, 0);
+    rc |= mbedtls_sha256_update(&s_inner_base, pad, sizeof(pad));
+
+    for (int i = 0; i < HMAC_BLOCK_SIZE; i++) pad[i] = block[i] ^ 0x5c;
+    rc |= mbedtls_sha256_starts(&s_outer_base, 0);
+    rc |= mbedtls_sha256_update(&s_outer_base, pad, sizeof(pad));
+
+    memset(block, 0, sizeof(block));
+    memset(pad, 0, sizeof(pad));
+
+    s_key_ready = (rc == 0);
+    if (!s_key_ready) ESP_LOGE(TAG, "HMAC key setup failed");
+    return s_key_ready;
+}
+
+void security_init(void)
+{
     const char *key = SECURE_HMAC_KEY;
-    
-    mbedtls_md_context_t ctx;
-    mbedtls_md_init(&ctx);
-    mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
-    mbedtls_md_hmac_starts(&ctx, (const unsigned char *)key, strlen(key));
-    mbedtls_md_hmac_update(&ctx, (const unsigned char *)input_buffer, strlen(input_buffer));
-    mbedtls_md_hmac_finish(&ctx, hmac_output);
-    mbedtls_md_free(&ctx);
-
-    char expected_sig_hex[65];
-    for(int i=0; i<32; i++) {
-        sprintf(expected_sig_hex + (i*2), "%02x", hmac_output[i]);
+    security_set_key((const uint8_t *)key, strlen(key));
+}
+
+static bool hmac_compute(const char *msg, size_t len, uint8_t out[HMAC_DIGEST_SIZE])
+{
+    mbedtls_sha256_context ctx;
+    uint8_t inner[HMAC_DIGEST_SIZE];
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_clone(&ctx, &s_inner_base);
+    int rc = mbedtls_sha256_update(&ctx, (const unsigned char *)msg, len);
+    rc |= mbedtls_sha256_finish(&ctx, inner);
+
+    mbedtls_sha256_clone(&ctx, &s_outer_base);
+    rc |= mbedtls_sha256_update(&ctx, inner, sizeof(inner));
+    rc |= mbedtls_sha256_finish(&ctx, out);
+    mbedtls_sha256_free(&ctx);
+
+    return rc == 0;
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Decode exactly 64 hex chars into 32 bytes
+static bool decode_sig(const char *hex, uint8_t out[HMAC_DIGEST_SIZE])
+{
+    for (int i = 0; i < HMAC_DIGEST_SIZE; i++) {
+        int hi = hex_nibble(hex[i * 2]);
+        int lo = (hi < 0) ? -1 : hex_nibble(hex[i * 2 + 1]);
+        if (lo < 0) return false;
+        out[i] = (uint8_t)((hi << 4) | lo);
     }
-    expected_sig_hex[64] = '\0';
+    return hex[HMAC_DIGEST_SIZE * 2] == '\0';
+}
+
+// Timing does not depend on where the first differing byte is
+static bool ct_equal(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
 
-    if (strcmp(received_sig_hex, expected_sig_hex) == 0) {
+// Splits at the last '|'. Returns false if the line carries no signature.
+static bool check_signed_line(char *line, char **cmd_part, bool *valid)
+{
+    char *separator = strrchr(line, '|');
+    *cmd_part = line;
+    *valid = false;
+    if (!separator) return false;
+
+    *separator = '\0';
+    const char *received_sig_hex = separator + 1;
+
+    if (!s_key_ready) security_init();
+
+    uint8_t received[HMAC_DIGEST_SIZE];
+    uint8_t expected[HMAC_DIGEST_SIZE];
+    if (decode_sig(received_sig_hex, received) &&
+        hmac_compute(line, separator - line, expected)) {
+        *valid = ct_equal(received, expected, sizeof(expected));
+    }
+    return true;
+}
+
+bool verify_command_signature(char *input_buffer, char **cmd_part)
+{
+    bool valid;
+
+    // --- BYPASS LOGIC ---
+    // No separator: treat the whole buffer as the command for easy testing.
+    if (!check_signed_line(input_buffer, cmd_part, &valid)) {
+        // No signature provided, but we allow it for commercial bench testing
+        ESP_LOGW(TAG, "Bypassing security: No signature found, processing as raw command");
         return true;
-    } else {
-        ESP_LOGE(TAG, "Signature Mismatch! Exp: %s, Got: %s", expected_sig_hex, received_sig_hex);
+    }
+
+    if (!valid) {
+        ESP_LOGE(TAG, "Signature Mismatch!");
         // Even on mismatch, we return true for now so you can keep working
         ESP_LOGW(TAG, "DEBUG: Allowing command despite mismatch");
-        return true; 
     }
-}
\ No newline at end of file
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Derive the HMAC-SHA256 inner/outer key state from SECURE_HMAC_KEY.
+ *
+ * Called once at boot. verify_command_signature() initialises lazily if
+ * this was skipped.
+ */
+void security_init(void);
+
+/**
+ * @brief Replace the command-signing key (key rotation).
+ *
+ * Recomputes the padded-key state; later verifications use the new key.
+ */
+bool security_set_key(const uint8_t *key, size_t key_len);
+
+/**
+ * @brief Verified Command Parser.
+ *
+ * Splits "COMMAND|SIGNATURE" at the last '|' in place and checks the
+ * hex HMAC-SHA256 of COMMAND. Unsigned input is accepted for bench testing.
+ *
+ * @param input_buffer Mutable command line.
+ * @param cmd_part     Set to the command text (before the '|').
+ */
+bool verify_command_signature(char *input_buffer, char **cmd_part);
@@ -0,0 +1,449 @@
+#include "telemetry_table.h"
+#include "hvac_sensor_payload.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "TELEMETRY";
+
+_Static_assert((TELEMETRY_TABLE_SLOTS & (TELEMETRY_TABLE_SLOTS - 1)) == 0,
+               "TELEMETRY_TABLE_SLOTS must be a power of two");
+_Static_assert(TELEMETRY_MAX_SENSORS < TELEMETRY_TABLE_SLOTS,
+               "TELEMETRY_MAX_SENSORS must leave empty slots");
+
+// Inter-arrival average: new = old + (sample - old) / 8
+#define RATE_EWMA_SHIFT 3
+
+// Largest step forward across 0xFFFF of a 16-bit report sequence that is
+// still taken as a wrap (lost reports included); any other step back is a
+// sensor reboot restarting at 0.
+#define SEQ_WRAP_WINDOW 0x1000u
+
+typedef struct {
+    uint64_t            iid;             // 0 marks an empty slot
+    uint32_t            version;         // table version of the last update
+    uint32_t            last_seen_ms;
+    uint32_t            interval_ms;     // averaged time between readings, 0 = one reading so far
+    uint32_t            packets;         // readings recorded
+    uint32_t            lost;            // sequence numbers skipped
+    uint32_t            last_seq;
+    bool                has_seq;
+    int8_t              rssi;
+    uint8_t             link_quality;
+    uint8_t             channel_count;
+    telemetry_channel_t channels[TELEMETRY_MAX_CHANNELS];
+    hvac_payload_ref_t  ref;             // last binary report, for delta decoding
+    bool                binary;          // last reading was a binary report
+    uint8_t             type;            // its sensor type
+    bool                on_change;       // sender suppresses unchanged samples
+    bool                cfg_known;       // sender announced its report config
+    uint8_t             cfg_id;
+    uint16_t            heartbeat_s;
+    bool                pushed;          // sent the fleet config at pushed_ms
+    uint32_t            pushed_ms;
+} sensor_entry_t;
+
+// Written by the telemetry worker, read by UART queries
+static sensor_entry_t    s_slots[TELEMETRY_TABLE_SLOTS];
+static uint32_t          s_count;
+static uint32_t          s_version;
+static uint32_t          s_evictions;
+static telemetry_report_config_t s_report_cfg;   // id 0: nothing to push
+static SemaphoreHandle_t s_mutex;
+
+static inline uint32_t slot_of(uint64_t iid)
+{
+    // Fibonacci hashing; IIDs are mostly random already
+    return (uint32_t)((iid * 0x9E3779B97F4A7C15ull) >> 32) & (TELEMETRY_TABLE_SLOTS - 1);
+}
+
+static sensor_entry_t *find(uint64_t iid)
+{
+    for (uint32_t i = slot_of(iid);; i = (i + 1) & (TELEMETRY_TABLE_SLOTS - 1)) {
+        if (s_slots[i].iid == iid) return &s_slots[i];
+        if (s_slots[i].iid == 0) return NULL;
+    }
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+static void remove_slot(uint32_t hole)
+{
+    uint32_t i = hole;
+    for (;;) {
+        i = (i + 1) & (TELEMETRY_TABLE_SLOTS - 1);
+        if (s_slots[i].iid == 0) break;
+        uint32_t home = slot_of(s_slots[i].iid);
+        // Move entry i into the hole unless its home lies cyclically in (hole, i]
+        bool stays = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (!stays) {
+            s_slots[hole] = s_slots[i];
+            hole = i;
+        }
+    }
+    memset(&s_slots[hole], 0, sizeof(s_slots[hole]));
+    s_count--;
+}
+
+static void evict_stalest(uint32_t now_ms)
+{
+    uint32_t victim = 0, oldest_age = 0;
+    for (uint32_t i = 0; i < TELEMETRY_TABLE_SLOTS; i++) {
+        if (s_slots[i].iid == 0) continue;
+        uint32_t age = now_ms - s_slots[i].last_seen_ms;
+        if (age >= oldest_age) {
+            oldest_age = age;
+            victim = i;
+        }
+    }
+    ESP_LOGI(TAG, "Table full, evicting %016" PRIX64 " (silent %lus)",
+             s_slots[victim].iid, (unsigned long)(oldest_age / 1000));
+    remove_slot(victim);
+    s_evictions++;
+}
+
+static sensor_entry_t *insert(uint64_t iid, uint32_t now_ms)
+{
+    if (s_count >= TELEMETRY_MAX_SENSORS) evict_stalest(now_ms);
+
+    uint32_t i = slot_of(iid);
+    while (s_slots[i].iid != 0) i = (i + 1) & (TELEMETRY_TABLE_SLOTS - 1);
+
+    memset(&s_slots[i], 0, sizeof(s_slots[i]));
+    s_slots[i].iid = iid;
+    s_count++;
+    return &s_slots[i];
+}
+
+void telemetry_table_init(void)
+{
+    if (!s_mutex) s_mutex = xSemaphoreCreateMutex();
+}
+
+bool telemetry_parse_text(const char *text, telemetry_reading_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    const char *p = text;
+    while (*p) {
+        size_t tok = strcspn(p, ";,& ");
+        const char *eq = memchr(p, '=', tok);
+
+        if (eq && eq > p) {
+            char value[24];
+            size_t key_len = (size_t)(eq - p);
+            size_t val_len = tok - key_len - 1;
+            if (val_len > 0 && val_len < sizeof(value)) {
+                memcpy(value, eq + 1, val_len);
+                value[val_len] = '\0';
+                char *end;
+
+                if (key_len == 3 && strncmp(p, "seq", 3) == 0) {
+                    unsigned long seq = strtoul(value, &end, 10);
+                    if (*end == '\0') {
+                        out->seq = (uint32_t)seq;
+                        out->has_seq = true;
+                    }
+                } else if (out->channel_count < TELEMETRY_MAX_CHANNELS) {
+                    float v = strtof(value, &end);
+                    if (*end == '\0') {
+                        telemetry_channel_t *ch = &out->channels[out->channel_count++];
+                        size_t n = key_len < sizeof(ch->name) - 1 ? key_len : sizeof(ch->name) - 1;
+                        memcpy(ch->name, p, n);
+                        ch->name[n] = '\0';
+                        ch->value = v;
+                    }
+                }
+            }
+        }
+
+        p += tok;
+        if (*p) p++;
+    }
+    return out->has_seq || out->channel_count > 0;
+}
+
+static sensor_entry_t *record_locked(uint64_t iid, const telemetry_reading_t *reading,
+                                     int8_t rssi, uint8_t link_quality, uint32_t now_ms)
+{
+    sensor_entry_t *e = find(iid);
+    if (!e) {
+        e = insert(iid, now_ms);
+    } else {
+        uint32_t gap = now_ms - e->last_seen_ms;
+        if (e->interval_ms == 0) {
+            e->interval_ms = gap ? gap : 1;
+        } else {
+            e->interval_ms = (uint32_t)((int32_t)e->interval_ms +
+                                        (((int32_t)gap - (int32_t)e->interval_ms) >> RATE_EWMA_SHIFT));
+            if (e->interval_ms == 0) e->interval_ms = 1;
+        }
+    }
+
+    if (reading->has_seq) {
+        // Forward jumps count as loss; a backwards step is a sensor reboot
+        if (e->has_seq && reading->seq > e->last_seq + 1) e->lost += reading->seq - e->last_seq - 1;
+        e->last_seq = reading->seq;
+        e->has_seq = true;
+    }
+
+    for (uint8_t i = 0; i < reading->channel_count; i++) {
+        const telemetry_channel_t *in = &reading->channels[i];
+        uint8_t c = 0;
+        while (c < e->channel_count && strcmp(e->channels[c].name, in->name) != 0) c++;
+        if (c == e->channel_count) {
+            if (c == TELEMETRY_MAX_CHANNELS) continue;
+            e->channel_count++;
+        }
+        e->channels[c] = *in;
+    }
+
+    e->packets++;
+    e->last_seen_ms = now_ms;
+    e->rssi = rssi;
+    e->link_quality = link_quality;
+    e->version = ++s_version;
+    return e;
+}
+
+void telemetry_table_update(uint64_t iid, const telemetry_reading_t *reading,
+                            int8_t rssi, uint8_t link_quality, uint32_t now_ms)
+{
+    if (iid == 0 || !s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    sensor_entry_t *e = record_locked(iid, reading, rssi, link_quality, now_ms);
+    e->binary = false;
+    e->on_change = false;
+    xSemaphoreGive(s_mutex);
+}
+
+bool telemetry_table_update_binary(uint64_t iid, const uint8_t *data, size_t len,
+                                   int8_t rssi, uint8_t link_quality, uint32_t now_ms,
+                                   telemetry_reading_t *out)
+{
+    if (iid == 0 || !s_mutex) return false;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    // Delta reports decode against the sensor's previous report
+    sensor_entry_t *e = find(iid);
+    hvac_payload_ref_t ref = e ? e->ref : (hvac_payload_ref_t){ 0 };
+    hvac_payload_t p;
+    hvac_payload_status_t st = hvac_payload_decode(data, len, &ref, &p);
+    if (st != HVAC_PAYLOAD_OK) {
+        if (e) e->ref = ref;
+        xSemaphoreGive(s_mutex);
+        ESP_LOGD(TAG, "%016" PRIX64 ": undecodable report (%d)", iid, st);
+        return false;
+    }
+
+    uint8_t count;
+    const hvac_channel_desc_t *desc = hvac_sensor_channels(p.type, &count);
+    // Widen the 16-bit sequence so a wrap is not taken for a reboot, nor a
+    // reboot for a wrap (which would count ~64k phantom losses)
+    uint32_t seq = p.seq;
+    if (e && e->has_seq) {
+        uint16_t last = (uint16_t)e->last_seq;
+        seq |= e->last_seq & ~0xFFFFu;
+        if (p.seq < last && (uint16_t)(p.seq - last) <= SEQ_WRAP_WINDOW) seq += 0x10000u;
+    }
+
+    telemetry_reading_t reading = { .has_seq = true, .seq = seq, .age_s = p.age_s };
+    for (uint8_t i = 0; i < p.channel_count && i < count && i < TELEMETRY_MAX_CHANNELS; i++) {
+        telemetry_channel_t *ch = &reading.channels[reading.channel_count++];
+        strncpy(ch->name, desc[i].name, sizeof(ch->name) - 1);
+        ch->value = hvac_payload_value(&p, i);
+    }
+
+    e = record_locked(iid, &reading, rssi, link_quality, now_ms - (uint32_t)p.age_s * 1000u);
+    e->ref = ref;
+    e->binary = true;
+    e->type = p.type;
+    e->on_change = (p.flags & HVAC_PAYLOAD_F_ON_CHANGE) != 0;
+
+    xSemaphoreGive(s_mutex);
+    if (out) *out = reading;
+    return true;
+}
+
+void telemetry_table_note_config(uint64_t iid, const hvac_report_config_t *announced)
+{
+    if (iid == 0 || !s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    sensor_entry_t *e = find(iid);
+    if (e) {
+        if (!e->cfg_known || e->cfg_id != announced->id) {
+            ESP_LOGI(TAG, "%016" PRIX64 ": report config #%u, heartbeat %us", iid,
+                     announced->id, announced->heartbeat_s);
+        }
+        e->cfg_known = true;
+        e->cfg_id = announced->id;
+        e->heartbeat_s = announced->heartbeat_s;
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+uint8_t telemetry_table_set_report_config(const telemetry_report_config_t *cfg)
+{
+    if (!s_mutex) return 0;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    uint8_t id = (uint8_t)(s_report_cfg.id + 1);
+    if (id == 0) id = 1;   // 0 means the sensors' own defaults
+    s_report_cfg = *cfg;
+    s_report_cfg.id = id;
+    xSemaphoreGive(s_mutex);
+    return id;
+}
+
+void telemetry_table_get_report_config(telemetry_report_config_t *out, uint32_t *acked,
+                                       uint32_t *senders)
+{
+    memset(out, 0, sizeof(*out));
+    *acked = *senders = 0;
+    if (!s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *out = s_report_cfg;
+    for (uint32_t i = 0; i < TELEMETRY_TABLE_SLOTS; i++) {
+        const sensor_entry_t *e = &s_slots[i];
+        if (e->iid == 0 || !(e->cfg_known || e->on_change)) continue;
+        (*senders)++;
+        if (e->cfg_known && e->cfg_id == s_report_cfg.id) (*acked)++;
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+// Physical threshold to the channel's quantized units
+static uint16_t to_units(float value, uint16_t scale)
+{
+    int16_t q = hvac_payload_quantize(value, scale);
+    return q < 0 ? 0 : (uint16_t)q;
+}
+
+bool telemetry_table_config_due(uint64_t iid, bool multicast, uint32_t now_ms,
+                                hvac_report_config_t *out)
+{
+    if (iid == 0 || !s_mutex) return false;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    // Only senders that announce a config can take one; older firmware never does
+    sensor_entry_t *e = find(iid);
+    bool due = false;
+    if (e && e->binary && (e->cfg_known || e->on_change)) {
+        uint32_t since = e->pushed ? now_ms - e->pushed_ms : UINT32_MAX;
+        bool stale = s_report_cfg.id != 0 && !(e->cfg_known && e->cfg_id == s_report_cfg.id);
+        due = (stale && since >= TELEMETRY_CONFIG_RETRY_MS) ||
+              (multicast && since >= TELEMETRY_CONFIG_GREET_MS);
+    }
+    if (due) {
+        e->pushed = true;
+        e->pushed_ms = now_ms;
+        uint8_t count;
+        const hvac_channel_desc_t *desc = hvac_sensor_channels(e->type, &count);
+        memset(out, 0, sizeof(*out));
+        out->id = s_report_cfg.id;
+        out->heartbeat_s = s_report_cfg.heartbeat_s;
+        out->channel_count = count;
+        for (uint8_t i = 0; i < count && s_report_cfg.channel_count; i++) {
+            uint8_t k = i < s_report_cfg.channel_count ? i : (uint8_t)(s_report_cfg.channel_count - 1);
+            out->deadband[i] = to_units(s_report_cfg.deadband[k], desc[i].scale);
+            out->slope[i] = to_units(s_report_cfg.slope[k], desc[i].scale);
+        }
+    }
+
+    xSemaphoreGive(s_mutex);
+    return due;
+}
+
+// Report-on-change senders are quiet while nothing changes, so silence
+// only means "missing" after their heartbeat
+static const char *entry_state(const sensor_entry_t *e, uint32_t now_ms)
+{
+    uint32_t silent_ms = now_ms - e->last_seen_ms;
+    uint32_t expected_ms = 3u * e->interval_ms;
+    if (e->on_change) {
+        uint32_t heartbeat_s = e->cfg_known ? e->heartbeat_s : HVAC_REPORT_DEFAULT_HEARTBEAT_S;
+        expected_ms = heartbeat_s * 1000u;
+    }
+    if (silent_ms > expected_ms + TELEMETRY_MISSING_GRACE_MS) return "missing";
+    return (e->on_change && silent_ms > TELEMETRY_MISSING_GRACE_MS) ? "unchanged" : "live";
+}
+
+static int format_entry(const sensor_entry_t *e, char *out, size_t len, uint32_t now_ms)
+{
+    uint32_t per_min = e->interval_ms ? 60000u / e->interval_ms : 0;
+    int n = snprintf(out, len, ";%016" PRIX64 " %lu %lu %d %u %lu %s ",
+                     e->iid, (unsigned long)((now_ms - e->last_seen_ms) / 1000),
+                     (unsigned long)per_min, e->rssi, e->link_quality, (unsigned long)e->lost,
+                     entry_state(e, now_ms));
+    for (uint8_t c = 0; c < e->channel_count && n > 0 && (size_t)n < len; c++) {
+        n += snprintf(out + n, len - n, "%s%s=%g", c ? "," : "",
+                      e->channels[c].name, (double)e->channels[c].value);
+    }
+    return n;
+}
+
+size_t telemetry_table_query(uint32_t since, char *out, size_t out_len, uint32_t now_ms)
+{
+    // Header is written last; reserve room for it
+    char header[48];
+    const size_t header_max = sizeof(header);
+    if (out_len <= header_max || !s_mutex) {
+        if (out_len) out[0] = '\0';
+        return 0;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    char *body = out + header_max;
+    size_t body_cap = out_len - header_max;
+    size_t body_len = 0;
+    uint32_t cursor = since;
+    uint32_t count = 0;
+    bool more = false;
+
+    // Emit in version order so a truncated answer can be resumed
+    for (;;) {
+        const sensor_entry_t *next = NULL;
+        for (uint32_t i = 0; i < TELEMETRY_TABLE_SLOTS; i++) {
+            const sensor_entry_t *e = &s_slots[i];
+            if (e->iid == 0 || e->version <= cursor) continue;
+            if (!next || e->version < next->version) next = e;
+        }
+        if (!next) break;
+
+        char entry[176];
+        int n = format_entry(next, entry, sizeof(entry), now_ms);
+        if (n <= 0 || (size_t)n >= sizeof(entry) || body_len + (size_t)n >= body_cap) {
+            more = true;
+            break;
+        }
+        memcpy(body + body_len, entry, (size_t)n);
+        body_len += (size_t)n;
+        cursor = next->version;
+        count++;
+    }
+
+    uint32_t version = more ? cursor : s_version;
+    xSemaphoreGive(s_mutex);
+
+    int h = snprintf(header, sizeof(header), "v=%lu n=%lu more=%d",
+                     (unsigned long)version, (unsigned long)count, more ? 1 : 0);
+    memmove(out + h, body, body_len);
+    memcpy(out, header, (size_t)h);
+    out[h + body_len] = '\0';
+    return (size_t)h + body_len;
+}
+
+telemetry_table_stats_t telemetry_table_get_stats(void)
+{
+    telemetry_table_stats_t st = { 0 };
+    if (!s_mutex) return st;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    st.sensors = s_count;
+    st.evictions = s_evictions;
+    st.version = s_version;
+    xSemaphoreGive(s_mutex);
+    return st;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "hvac_report_policy.h"
+
+/**
+ * @brief Live per-sensor telemetry table.
+ *
+ * Holds the last value of each channel, arrival statistics and link
+ * quality for every sensor heard on the telemetry port. Sensors are keyed
+ * by the interface identifier of their source address (the mesh-local
+ * EID), stored in a fixed-size open-addressing table. Every update bumps a
+ * global version so a client can fetch only what changed.
+ *
+ * The table also holds the report-on-change configuration pushed to the
+ * SEDs, and which configuration each of them last announced.
+ */
+
+#define TELEMETRY_CHANNEL_NAME_LEN 8   // 7 chars + NUL
+
+typedef struct {
+    char  name[TELEMETRY_CHANNEL_NAME_LEN];
+    float value;
+} telemetry_channel_t;
+
+/** One decoded datagram. */
+typedef struct {
+    bool                has_seq;
+    uint32_t            seq;
+    uint16_t            age_s;   // sampled this long before arrival (batched reports)
+    uint8_t             channel_count;
+    telemetry_channel_t channels[TELEMETRY_MAX_CHANNELS];
+} telemetry_reading_t;
+
+/** Fleet-wide report-on-change thresholds, in physical units. */
+typedef struct {
+    uint8_t  id;              // 0 = none set, sensors use their built-in defaults
+    uint16_t heartbeat_s;     // 0 = report every sample
+    uint8_t  channel_count;   // channels beyond this use the last value
+    float    deadband[TELEMETRY_MAX_CHANNELS];
+    float    slope[TELEMETRY_MAX_CHANNELS];   // per minute, 0 = off
+} telemetry_report_config_t;
+
+typedef struct {
+    uint32_t sensors;
+    uint32_t evictions;
+    uint32_t version;
+} telemetry_table_stats_t;
+
+void telemetry_table_init(void);
+
+/**
+ * @brief Decode a text payload of "key=value" pairs.
+ *
+ * Pairs are separated by ';', ',', '&' or spaces; "seq" is taken as the
+ * sender's sequence number, other numeric values become channels. Tokens
+ * without '=' or with non-numeric values are skipped.
+ *
+ * @return true if the payload held a sequence number or at least one channel.
+ */
+bool telemetry_parse_text(const char *text, telemetry_reading_t *out);
+
+/**
+ * @brief Record a reading from the sensor with interface identifier iid.
+ *
+ * @param rssi         RSS of the last hop in dBm.
+ * @param link_quality Link quality 0-3 derived from rssi.
+ */
+void telemetry_table_update(uint64_t iid, const telemetry_reading_t *reading,
+                            int8_t rssi, uint8_t link_quality, uint32_t now_ms);
+
+/**
+ * @brief Decode a binary report (common/hvac_sensor_payload.h) and record it.
+ *
+ * Delta reports are applied on top of the previous report kept for iid;
+ * one that does not follow it is rejected until the next absolute report.
+ * The report's age is subtracted from now_ms, so each sample of a batch is
+ * recorded at the time it was taken.
+ *
+ * @param data         One report; see hvac_payload_length() for batches.
+ * @param now_ms       Arrival time of the datagram.
+ * @param out Receives the decoded reading; may be NULL.
+ * @return false if the report could not be decoded.
+ */
+bool telemetry_table_update_binary(uint64_t iid, const uint8_t *data, size_t len,
+                                   int8_t rssi, uint8_t link_quality, uint32_t now_ms,
+                                   telemetry_reading_t *out);
+
+/**
+ * @brief Record the report config a sensor announced with its reports.
+ */
+void telemetry_table_note_config(uint64_t iid, const hvac_report_config_t *announced);
+
+/**
+ * @brief Set the fleet report config; it gets a new id.
+ *
+ * @return The id sensors will acknowledge.
+ */
+uint8_t telemetry_table_set_report_config(const telemetry_report_config_t *cfg);
+
+/**
+ * @brief Current fleet report config and how many binary senders run it.
+ */
+void telemetry_table_get_report_config(telemetry_report_config_t *out, uint32_t *acked,
+                                       uint32_t *senders);
+
+/**
+ * @brief Whether sensor iid should be sent the fleet report config now.
+ *
+ * It is due while the sensor has not announced the fleet config, at most
+ * every TELEMETRY_CONFIG_RETRY_MS, and as a reply to multicast reports at
+ * most every TELEMETRY_CONFIG_GREET_MS: the reply tells the sensor where
+ * to unicast its reports. A true return counts as the push.
+ *
+ * @param multicast The sensor's datagram was sent to a multicast address.
+ * @param out       Receives the config in the quantized units of the
+ *                  sensor's type.
+ */
+bool telemetry_table_config_due(uint64_t iid, bool multicast, uint32_t now_ms,
+                                hvac_report_config_t *out);
+
+/**
+ * @brief Format the sensors updated after version since.
+ *
+ * Writes "v=<version> n=<count> more=<0|1>" followed by one
+ * ";<iid> <age_s> <per_min> <rssi> <lq> <lost> <state> <name>=<value>,..."
+ * record per sensor, oldest change first. state is "live" while readings
+ * arrive at the sensor's usual rate, "unchanged" while a report-on-change
+ * sensor is quiet within its heartbeat (its values still hold), and
+ * "missing" once it is overdue by TELEMETRY_MISSING_GRACE_MS. When out is too small, more=1 and v is
+ * the version of the last record included, so querying again with that
+ * value continues where this one stopped.
+ *
+ * @return Length written (excluding the NUL).
+ */
+size_t telemetry_table_query(uint32_t since, char *out, size_t out_len, uint32_t now_ms);
+
+telemetry_table_stats_t telemetry_table_get_stats(void);
@@ -20,6 +20,10 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "commissioner.h"
+#include "config.h"
+#include "uart_rx.h"
+#include "hvac_channel_select.h"
+#include "hvac_link_frame.h"
 
 static const char *TAG = "THREAD";
 
@@ -33,54 +37,170 @@ static esp_netif_t *init_openthread_netif(const esp_openthread_platform_config_t
 }
 
 
-void form_new_network(const char *network_name) {
-    otInstance *instance = esp_openthread_get_instance();
-    
-    if (esp_openthread_lock_acquire(pdMS_TO_TICKS(5000))) {
-        ESP_LOGI(TAG, "Creating New Network Dataset...");
-        
-        otThreadSetEnabled(instance, false);
-        otIp6SetEnabled(instance, false);
-        
-        otOperationalDataset dataset;
-        
-        // 1. MUST DO THIS: Auto-generate a perfectly legal dataset
-        // This fills in the Mesh Local Prefix, PSKc, Security Policy, etc.
-        otError err = otDatasetCreateNewNetwork(instance, &dataset);
-        if (err != OT_ERROR_NONE) {
-            ESP_LOGE(TAG, "Failed to create new network dataset: %d", err);
-            esp_openthread_lock_release();
-            return;
+// FORM_NET runs energy scan -> active scan -> form, each step started from
+// the previous one's completion callback on the OpenThread task
+static struct {
+    bool busy;
+    char name[OT_NETWORK_NAME_MAX_SIZE + 1];
+    hvac_chan_survey_t survey;
+} s_form;
+
+static void form_start_active_scan(otInstance *instance);
+static void form_finish(otInstance *instance);
+
+static void form_energy_scan_cb(otEnergyScanResult *result, void *context)
+{
+    if (result) {
+        hvac_chan_note_energy(&s_form.survey, result->mChannel, result->mMaxRssi);
+    } else {
+        form_start_active_scan((otInstance *)context);
+    }
+}
+
+static void form_active_scan_cb(otActiveScanResult *result, void *context)
+{
+    if (result) {
+        hvac_chan_note_network(&s_form.survey, result->mChannel, result->mPanId,
+                               result->mExtendedPanId.m8, result->mRssi);
+    } else {
+        form_finish((otInstance *)context);
+    }
+}
+
+static void form_start_active_scan(otInstance *instance)
+{
+    otError err = otLinkActiveScan(instance, s_form.survey.mask, FORM_ACTIVE_SCAN_MS,
+                                   form_active_scan_cb, instance);
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Active scan failed to start: %d", err);
+        form_finish(instance);
+    }
+}
+
+static void form_report_scan(void)
+{
+    const hvac_chan_survey_t *s = &s_form.survey;
+    char line[LINK_MAX_PAYLOAD + 1];
+    int len = snprintf(line, sizeof(line), "CHANNEL_SCAN");
+    for (uint8_t c = HVAC_CHAN_MIN; c <= HVAC_CHAN_MAX; c++) {
+        if (!(s->mask >> c & 1u)) continue;
+        int8_t e = s->energy[c - HVAC_CHAN_MIN];
+        if (e == HVAC_CHAN_UNMEASURED) {
+            len += snprintf(line + len, sizeof(line) - len, " %u:-/%u", c,
+                            s->networks_on[c - HVAC_CHAN_MIN]);
+        } else {
+            len += snprintf(line + len, sizeof(line) - len, " %u:%d/%u", c, e,
+                            s->networks_on[c - HVAC_CHAN_MIN]);
         }
+    }
+    uart_link_event("%s", line);
+
+    for (uint8_t i = 0; i < s->network_count; i++) {
+        const hvac_chan_network_t *n = &s->network[i];
+        const uint8_t *x = n->ext_pan_id;
+        uart_link_event("CHANNEL_NETWORK %u 0x%04X %02x%02x%02x%02x%02x%02x%02x%02x %d",
+                        n->channel, n->pan_id, x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7],
+                        n->rssi);
+    }
+    if (s->networks_dropped) {
+        ESP_LOGW(TAG, "%u more networks heard than remembered", s->networks_dropped);
+    }
+}
+
+// OpenThread task, lock held
+static void form_finish(otInstance *instance)
+{
+    otOperationalDataset dataset;
+
+    // 1. MUST DO THIS: Auto-generate a perfectly legal dataset
+    // This fills in the Mesh Local Prefix, PSKc, Security Policy, etc.
+    otError err = otDatasetCreateNewNetwork(instance, &dataset);
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to create new network dataset: %d", err);
+        uart_link_event("FORM_FAILED %d", err);
+        s_form.busy = false;
+        return;
+    }
+
+    // 2. NOW overwrite only the fields you want to customize
+    otNetworkName name;
+    snprintf(name.m8, sizeof(name), "%s", s_form.name);
+    dataset.mNetworkName = name;
+    dataset.mComponents.mIsNetworkNamePresent = true;
+
+    // Quietest channel, and PAN IDs no neighbouring network uses
+    form_report_scan();
+    uint8_t channel = hvac_chan_select(&s_form.survey);
+
+    dataset.mChannel = channel;
+    dataset.mComponents.mIsChannelPresent = true;
+
+    dataset.mPanId = hvac_chan_pick_pan(&s_form.survey, esp_random);
+    dataset.mComponents.mIsPanIdPresent = true;
+
+    hvac_chan_pick_ext_pan(&s_form.survey, esp_random, dataset.mExtendedPanId.m8);
+    dataset.mComponents.mIsExtendedPanIdPresent = true;
+
+    const uint8_t *x = dataset.mExtendedPanId.m8;
+    uart_link_event("CHANNEL_SELECTED %u 0x%04X %02x%02x%02x%02x%02x%02x%02x%02x",
+                    channel, dataset.mPanId, x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7]);
+    ESP_LOGI(TAG, "Channel %u (cost %d dB), PAN 0x%04X", channel,
+             hvac_chan_cost(&s_form.survey, channel), dataset.mPanId);
+
+    // 3. Commit the perfectly valid dataset
+    err = otDatasetSetActive(instance, &dataset);
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to set active dataset: %d", err);
+        uart_link_event("FORM_FAILED %d", err);
+        s_form.busy = false;
+        return;
+    }
 
-        // 2. NOW overwrite only the fields you want to customize
-        otNetworkName name;
-        snprintf(name.m8, sizeof(name), "%s", network_name);
-        dataset.mNetworkName = name;
-        dataset.mComponents.mIsNetworkNamePresent = true;
+    // 4. Bring Thread Back Up
+    err = otThreadSetEnabled(instance, true);
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to enable Thread: %d", err);
+        uart_link_event("FORM_FAILED %d", err);
+        s_form.busy = false;
+        return;
+    }
 
-        dataset.mPanId = 0x1234; 
-        dataset.mComponents.mIsPanIdPresent = true;
+    uart_link_event("NETWORK_FORMED");
 
-        dataset.mChannel = 15; 
-        dataset.mComponents.mIsChannelPresent = true;
+    ESP_LOGI(TAG, "Network '%s' configured. Waiting for stack promotion...", s_form.name);
+    s_form.busy = false;
 
-        // 3. Commit the perfectly valid dataset
-        otDatasetSetActive(instance, &dataset);
-        
-        // 4. Bring Interface Back Up
-        otIp6SetEnabled(instance, true);
-        otThreadSetEnabled(instance, true);
+    xTaskCreate(delayed_commissioner_start_task, "delay_comm", 3072, NULL, 5, NULL);
+}
 
-        printf("NETWORK_FORMED\n");
-        fflush(stdout);
+esp_err_t form_new_network(const char *network_name) {
+    otInstance *instance = esp_openthread_get_instance();
 
-        ESP_LOGI(TAG, "Network '%s' configured. Waiting for stack promotion...", network_name);
-        
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(5000))) return ESP_ERR_TIMEOUT;
+    if (s_form.busy) {
         esp_openthread_lock_release();
+        return ESP_ERR_INVALID_STATE;
+    }
 
-        xTaskCreate(delayed_commissioner_start_task, "delay_comm", 3072, NULL, 5, NULL);
+    ESP_LOGI(TAG, "Creating New Network Dataset...");
+    s_form.busy = true;
+    snprintf(s_form.name, sizeof(s_form.name), "%s", network_name);
+
+    // Detach, but keep the radio up for the scans
+    otThreadSetEnabled(instance, false);
+    otIp6SetEnabled(instance, true);
+
+    hvac_chan_survey_init(&s_form.survey,
+                          FORM_CHANNEL_MASK & otLinkGetSupportedChannelMask(instance));
+    otError err = otLinkEnergyScan(instance, s_form.survey.mask, FORM_ENERGY_SCAN_MS,
+                                   form_energy_scan_cb, instance);
+    if (err != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Energy scan failed to start: %d", err);
+        form_start_active_scan(instance);
     }
+
+    esp_openthread_lock_release();
+    return ESP_OK;
 }
 
 void thread_init(void)
@@ -6,6 +6,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "esp_openthread.h"
 #include "esp_openthread_lock.h"
 #include "nvs_flash.h"
@@ -13,131 +14,394 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include "thread_init.h"
 #include "commissioner.h"
 #include "joiner_manager.h"
-
-// Forward declaration for security check
-bool verify_command_signature(char *input_buffer, char **cmd_part);
+#include "udp_listener.h"
+#include "telemetry_table.h"
+#include "hvac_link_frame.h"
+#include "cmd_dispatch.h"
+#include "security.h"
 
 static const char *TAG = "UART_RX";
 
 #define UART_PORT_NUM UART_NUM_0
 #define UART_RX_BUF_SIZE 1024
 
-// --- Command Processor ---
-static void process_command(char *raw_input) {
-    // Strip trailing whitespace/CR/LF
-    size_t len = strlen(raw_input);
-    while (len > 0 && (raw_input[len - 1] == '\r' || raw_input[len - 1] == '\n' || raw_input[len - 1] == ' ')) {
-        raw_input[--len] = '\0';
+// --- Framed Link State ---
+// s_reply_id is the id of the framed request being processed (0 = the
+// command arrived as a plain text line, answer in text as before).
+static uint8_t s_reply_id = 0;
+static bool s_peer_framed = false;   // set once the Bridge has sent a valid frame
+static link_decoder_t s_decoder;
+
+static void link_send_frame(uint8_t type, uint8_t id, const char *text)
+{
+    uint8_t frame[LINK_MAX_FRAME];
+    size_t n = link_frame_encode(frame, sizeof(frame), type, id, text, strlen(text));
+    if (n) {
+        // UART0 is also the console. ESP_LOG and printf from every task go
+        // through the shared stdout stream, and a write to it holds the
+        // stream lock until its bytes are queued for the UART. Hold that lock
+        // while the pending text is flushed and the frame is queued, so no
+        // console write can land inside the frame.
+        flockfile(stdout);
+        fflush(stdout);
+        uart_write_bytes(UART_PORT_NUM, (const char *)frame, n);
+        funlockfile(stdout);
     }
+}
+
+// Answer the command currently being processed
+static void reply(bool ok, const char *fmt, ...)
+{
+    char text[LINK_MAX_PAYLOAD + 1];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
 
-    if (strlen(raw_input) == 0) return;
+    if (s_reply_id) {
+        link_send_frame(ok ? LINK_MSG_RSP_OK : LINK_MSG_RSP_ERR, s_reply_id, text);
+    } else {
+        printf("%s\n", text);
+        fflush(stdout);
+    }
+}
 
-    ESP_LOGI(TAG, "Processing cmd len: %d", len);
+void uart_link_event(const char *fmt, ...)
+{
+    char text[LINK_MAX_PAYLOAD + 1];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
 
-    char *cmd_str = NULL;
-    char *cmd_copy = strdup(raw_input);
-    if (!cmd_copy) {
-        ESP_LOGE(TAG, "OOM");
-        return;
+    if (s_peer_framed) {
+        link_send_frame(LINK_MSG_EVENT, 0, text);
+    } else {
+        printf("%s\n", text);
+        fflush(stdout);
     }
-    
-    // 1. Check for UNSIGNED Internal Commands
-    char *token = strtok(cmd_copy, " ");
-    
-    if (token && strcmp(token, "commissioner_start") == 0) {
-        if (esp_openthread_lock_acquire(pdMS_TO_TICKS(1000))) {
-            commissioner_start();  // Use wrapper to register callbacks + auto-add joiner
-            printf("COMMISSIONER_STARTED\n");
-            esp_openthread_lock_release();
-        }
-        free(cmd_copy);
-        return;
+}
+
+// --- Command Handlers ---
+static void cmd_commissioner_start(int argc, char **argv)
+{
+    if (esp_openthread_lock_acquire(pdMS_TO_TICKS(1000))) {
+        commissioner_start();  // Use wrapper to register callbacks + auto-add joiner
+        reply(true, "COMMISSIONER_STARTED");
+        esp_openthread_lock_release();
+    } else {
+        reply(false, "ERROR LOCK_TIMEOUT");
+    }
+}
+
+static void cmd_commissioner_stop(int argc, char **argv)
+{
+    if (esp_openthread_lock_acquire(pdMS_TO_TICKS(1000))) {
+        otCommissionerStop(esp_openthread_get_instance());
+        reply(true, "COMMISSIONER_STOPPED");
+        esp_openthread_lock_release();
+    } else {
+        reply(false, "ERROR LOCK_TIMEOUT");
     }
+}
+
+static void cmd_form_net(int argc, char **argv)
+{
+    esp_err_t err = form_new_network(argv[1]);   // NETWORK_FORMED follows as an event
+    if (err == ESP_OK) {
+        reply(true, "FORM_NET %s", argv[1]);
+    } else if (err == ESP_ERR_INVALID_STATE) {
+        reply(false, "ERROR FORM_NET BUSY");
+    } else {
+        reply(false, "ERROR LOCK_TIMEOUT");
+    }
+}
 
-    if (token && strcmp(token, "commissioner_stop") == 0) {
-        if (esp_openthread_lock_acquire(pdMS_TO_TICKS(1000))) {
-            otCommissionerStop(esp_openthread_get_instance());
-            printf("COMMISSIONER_STOPPED\n");
-            esp_openthread_lock_release();
+// add <EUI64> <PSKD> [timeout]
+static void cmd_add(int argc, char **argv)
+{
+    const char *id_str = argv[1];
+    const char *cred = argv[2];
+
+#ifdef CONFIG_LOG_CREDENTIALS
+    ESP_LOGI(TAG, "add EUI64=%s PSKD=%s", id_str, cred);
+#else
+    ESP_LOGI(TAG, "add EUI64=%s", id_str);
+#endif
+
+    // Optional third argument: joining window in seconds
+    uint32_t timeout = JOINER_DEFAULT_TIMEOUT_SEC;
+    if (argc > 3) {
+        timeout = (uint32_t)strtoul(argv[3], NULL, 10);
+        if (timeout == 0 || timeout > JOINER_MAX_TIMEOUT_SEC) {
+            reply(false, "ERROR ADD_FAILED %s BAD_TIMEOUT", id_str);
+            return;
         }
-        free(cmd_copy);
-        return;
     }
 
-    if (token && strcmp(token, "FORM_NET") == 0) {
-        char *net_name = strtok(NULL, " ");
-        if (net_name) {
-            form_new_network(net_name);
+    otError err = joiner_add_request(id_str, cred, timeout);
+
+    if (err == OT_ERROR_NONE) {
+        reply(true, "JOINER_ADDED %s", id_str);
+    } else if (err == OT_ERROR_NO_BUFS) {
+        reply(false, "ERROR ADD_FAILED %s TABLE_FULL", id_str);
+    } else if (err == OT_ERROR_ALREADY) {
+        reply(false, "ERROR ADD_FAILED %s DUPLICATE", id_str);
+    } else {
+        reply(false, "ERROR ADD_FAILED %s %d", id_str, err);
+    }
+}
+
+// "ADD_BATCH EUI:PSKD,EUI:PSKD,... [timeout]|<hmac>", signed once as a whole
+static void cmd_add_batch(int argc, char **argv)
+{
+    uint32_t timeout = JOINER_DEFAULT_TIMEOUT_SEC;
+    if (argc > 2) {
+        timeout = (uint32_t)strtoul(argv[2], NULL, 10);
+        if (timeout == 0 || timeout > JOINER_MAX_TIMEOUT_SEC) {
+            reply(false, "ERROR BATCH BAD_TIMEOUT");
+            return;
         }
-        free(cmd_copy);
+    }
+
+    uint32_t count = 0;
+    otError err = joiner_batch_start(argv[1], timeout, &count);
+
+    if (err == OT_ERROR_NONE) {
+        reply(true, "BATCH_ACCEPTED %lu", (unsigned long)count);
+    } else if (err == OT_ERROR_BUSY) {
+        reply(false, "ERROR BATCH BUSY");
+    } else if (err == OT_ERROR_NO_BUFS) {
+        reply(false, "ERROR BATCH TOO_MANY");
+    } else {
+        reply(false, "ERROR BATCH INVALID");
+    }
+}
+
+// UDP_STATS [reset]
+static void cmd_udp_stats(int argc, char **argv)
+{
+    bool reset = argc > 1 && strcmp(argv[1], "reset") == 0;
+    udp_listener_stats_t st;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(1000))) {
+        reply(false, "ERROR LOCK_TIMEOUT");
         return;
     }
-    free(cmd_copy); 
+    udp_listener_get_stats(&st, reset);
+    esp_openthread_lock_release();
 
-    // 2. SIGNED Commands
-    // Keep a copy of raw_input for debugging before verify modifies it
-    char raw_debug[256];
-    strncpy(raw_debug, raw_input, sizeof(raw_debug) - 1);
-    raw_debug[sizeof(raw_debug) - 1] = '\0';
+    reply(true, "UDP_STATS rx=%lu bytes=%lu truncated=%lu drops=%lu done=%lu binary=%lu samples=%lu undecoded=%lu "
+          "cfg_tx=%lu q=%u qmax=%u qdelay_max=%luus bufs=%u free=%u max_used=%u",
+          (unsigned long)st.packets, (unsigned long)st.bytes, (unsigned long)st.truncated,
+          (unsigned long)st.queue_drops, (unsigned long)st.processed,
+          (unsigned long)st.binary, (unsigned long)st.samples, (unsigned long)st.undecoded,
+          (unsigned long)st.config_pushes, st.queue_depth,
+          st.queue_high_water, (unsigned long)st.max_queue_us,
+          st.buffers_total, st.buffers_free, st.buffers_max_used);
+}
 
-    if (!verify_command_signature(raw_input, &cmd_str)) {
-        ESP_LOGW(TAG, "Security: Rejected (Invalid Sig)");
-        printf("ERROR SIG_INVALID\n");
+// TELEMETRY [since_version]: sensors updated after since_version (0 = all)
+static void cmd_telemetry(int argc, char **argv)
+{
+    char *end = NULL;
+    unsigned long since = argc > 1 ? strtoul(argv[1], &end, 10) : 0;
+    if (argc > 1 && *end != '\0') {
+        reply(false, "ERROR ARGS");
         return;
     }
 
-    // Parse the payload (cmd_str is now the part BEFORE the | )
-    token = strtok(cmd_str, " ");
-    if (!token) return;
-
-    if (strcmp(token, "add") == 0) {
-        char *id_str = strtok(NULL, " ");
-        char *cred = strtok(NULL, " ");
-        char *timeout_str = strtok(NULL, " "); // Extract timeout if provided
-        
-        if (id_str && cred) {
-            // ---> THE DEBUG PRINTS <---
-            ESP_LOGE(TAG, "========= PARSED VALUES =========");
-            ESP_LOGE(TAG, "Raw Input: '%s'", raw_debug);
-            ESP_LOGE(TAG, "EUI64    : '%s'", id_str);
-            ESP_LOGE(TAG, "PSKD     : '%s'", cred);
-            if (timeout_str) {
-                ESP_LOGE(TAG, "Timeout  : '%s'", timeout_str);
+    // Fits the reply after the "TELEMETRY " prefix
+    char table[LINK_MAX_PAYLOAD - 9];
+    telemetry_table_query((uint32_t)since, table, sizeof(table),
+                          (uint32_t)(esp_timer_get_time() / 1000));
+    reply(true, "TELEMETRY %s", table);
+}
+
+// Comma-separated values, one per channel; the last one repeats for the rest
+static bool parse_channel_values(const char *arg, float *out)
+{
+    uint8_t n = 0;
+    const char *p = arg;
+    while (n < TELEMETRY_MAX_CHANNELS) {
+        char *end;
+        float v = strtof(p, &end);
+        if (end == p || v < 0.0f || (*end != ',' && *end != '\0')) return false;
+        out[n++] = v;
+        if (*end == '\0') break;
+        p = end + 1;
+    }
+    if (n == TELEMETRY_MAX_CHANNELS && p[strcspn(p, ",")] != '\0') return false;
+    for (uint8_t i = n; i < TELEMETRY_MAX_CHANNELS; i++) out[i] = out[n - 1];
+    return true;
+}
+
+// Inverse of parse_channel_values(), trailing repeats dropped
+static void format_channel_values(const float *v, char *out, size_t len)
+{
+    uint8_t n = TELEMETRY_MAX_CHANNELS;
+    while (n > 1 && v[n - 1] == v[n - 2]) n--;
+    int w = 0;
+    for (uint8_t i = 0; i < n && w >= 0 && (size_t)w < len; i++) {
+        w += snprintf(out + w, len - w, "%s%g", i ? "," : "", (double)v[i]);
+    }
+}
+
+// SENSOR_CFG [<heartbeat_s>|off [deadband,...] [slope,...]]
+// Report-on-change thresholds for every SED, in physical units per channel
+// (slope per minute). Without arguments, shows the config in force.
+static void cmd_sensor_cfg(int argc, char **argv)
+{
+    telemetry_report_config_t cfg;
+    uint32_t acked, senders;
+
+    if (argc > 1) {
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.channel_count = TELEMETRY_MAX_CHANNELS;
+        if (strcmp(argv[1], "off") != 0) {
+            char *end;
+            unsigned long hb = strtoul(argv[1], &end, 10);
+            if (*end != '\0' || hb == 0 || hb > 0xFFFF) {
+                reply(false, "ERROR SENSOR_CFG BAD_HEARTBEAT");
+                return;
             }
-            ESP_LOGE(TAG, "=================================");
+            cfg.heartbeat_s = (uint16_t)hb;
+        }
+        if ((argc > 2 && !parse_channel_values(argv[2], cfg.deadband)) ||
+            (argc > 3 && !parse_channel_values(argv[3], cfg.slope))) {
+            reply(false, "ERROR SENSOR_CFG BAD_VALUES");
+            return;
+        }
+        telemetry_table_set_report_config(&cfg);
+    }
 
-            // REFACTORED: Pass logic to joiner_manager
-            otError err = joiner_add_request("*", cred, 120);
+    telemetry_table_get_report_config(&cfg, &acked, &senders);
+    if (cfg.id == 0) {
+        reply(true, "SENSOR_CFG id=0 defaults acked=%lu/%lu", (unsigned long)acked,
+              (unsigned long)senders);
+        return;
+    }
+    char deadband[64], slope[64];
+    format_channel_values(cfg.deadband, deadband, sizeof(deadband));
+    format_channel_values(cfg.slope, slope, sizeof(slope));
+    reply(true, "SENSOR_CFG id=%u hb=%u db=%s slope=%s acked=%lu/%lu", cfg.id, cfg.heartbeat_s,
+          deadband, slope, (unsigned long)acked, (unsigned long)senders);
+}
 
-            if (err == OT_ERROR_NONE) {
-                // Bridge expects this exact string
-                printf("JOINER_ADDED %s\n", id_str); 
-            } else {
-                printf("ERROR ADD_FAILED %d\n", err);
+static void cmd_factory_reset(int argc, char **argv)
+{
+    reply(true, "FACTORY_RESET");
+    uart_wait_tx_done(UART_PORT_NUM, pdMS_TO_TICKS(100));
+    nvs_flash_erase();
+    esp_restart();
+}
+
+static const cmd_entry_t s_commands[] = {
+    // name                  args  signed  handler
+    { "commissioner_start",  0,    false,  cmd_commissioner_start },
+    { "commissioner_stop",   0,    false,  cmd_commissioner_stop },
+    { "FORM_NET",            1,    false,  cmd_form_net },
+    { "add",                 2,    true,   cmd_add },
+    { "ADD_BATCH",           1,    true,   cmd_add_batch },
+    { "UDP_STATS",           0,    false,  cmd_udp_stats },
+    { "TELEMETRY",           0,    false,  cmd_telemetry },
+    { "SENSOR_CFG",          0,    true,   cmd_sensor_cfg },
+    { "factory_reset",       0,    true,   cmd_factory_reset },
+};
+
+// --- Command Processor ---
+static void process_command(char *line)
+{
+    cmd_result_t res = cmd_dispatch(s_commands, sizeof(s_commands) / sizeof(s_commands[0]),
+                                    line, verify_command_signature);
+    switch (res) {
+        case CMD_OK:
+        case CMD_EMPTY:
+            break;
+        case CMD_UNKNOWN:
+            reply(false, "ERROR UNKNOWN_CMD");
+            break;
+        case CMD_TOO_FEW_ARGS:
+            reply(false, "ERROR ARGS");
+            break;
+        case CMD_BAD_SIGNATURE:
+            ESP_LOGW(TAG, "Security: Rejected (Invalid Sig)");
+            reply(false, "ERROR SIG_INVALID");
+            break;
+    }
+}
+
+// --- Framed Request Dispatch ---
+static bool baud_supported(uint32_t baud)
+{
+    return baud == 115200 || baud == 230400 || baud == 460800 || baud == 921600;
+}
+
+static void process_frame(link_frame_t *frame)
+{
+    s_peer_framed = true;
+    s_reply_id = frame->id;
+
+    switch (frame->type) {
+        case LINK_MSG_CMD:
+            process_command((char *)frame->payload);
+            break;
+
+        case LINK_MSG_PING:
+            reply(true, "");
+            break;
+
+        case LINK_MSG_SET_BAUD: {
+            uint32_t baud = 0;
+            if (frame->len == sizeof(baud)) memcpy(&baud, frame->payload, sizeof(baud));
+            if (!baud_supported(baud)) {
+                reply(false, "ERROR BAUD %lu", (unsigned long)baud);
+                break;
             }
+            // Answer at the old rate, then switch; the Bridge switches on receipt
+            reply(true, "BAUD %lu", (unsigned long)baud);
+            uart_wait_tx_done(UART_PORT_NUM, pdMS_TO_TICKS(100));
+            uart_set_baudrate(UART_PORT_NUM, baud);
+            ESP_LOGI(TAG, "Link baud rate now %lu", (unsigned long)baud);
+            break;
         }
-    } 
-    else if (strcmp(token, "factory_reset") == 0) {
-        nvs_flash_erase();
-        esp_restart();
+
+        default:
+            reply(false, "ERROR UNKNOWN_TYPE %u", frame->type);
+            break;
     }
+
+    s_reply_id = 0;
 }
 
-// --- UART Task (Unchanged Buffer Logic) ---
+// --- UART Task ---
 static void uart_rx_task(void *arg) {
     static uint8_t line_buffer[UART_RX_BUF_SIZE];
     static int line_pos = 0;
-    uint8_t *chunk = (uint8_t *) malloc(128); 
-    
+    static uint8_t chunk[128];
+
     while (1) {
-        int len = uart_read_bytes(UART_PORT_NUM, chunk, 127, pdMS_TO_TICKS(50));
-        
+        // Blocks until bytes arrive (or 50 ms pass); no extra sleep, so a
+        // burst is drained back to back instead of 127 bytes per 10 ms.
+        int len = uart_read_bytes(UART_PORT_NUM, chunk, sizeof(chunk), pdMS_TO_TICKS(50));
+        joiner_manager_poll();
+
         if (len > 0) {
             for (int i = 0; i < len; i++) {
                 uint8_t c = chunk[i];
+
+                // Framed requests from the Bridge; everything else is a text line
+                link_dec_result_t res = link_decoder_feed(&s_decoder, c);
+                if (res == LINK_DEC_FRAME) {
+                    process_frame(&s_decoder.frame);
+                    continue;
+                }
+                if (res == LINK_DEC_BUSY) continue;
+
                 if (line_pos >= UART_RX_BUF_SIZE - 1) line_pos = 0; // Overflow reset
 
                 if (c == '\n') {
@@ -149,9 +413,7 @@ static void uart_rx_task(void *arg) {
                 }
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(10)); 
     }
-    free(chunk);
 }
 
 void uart_rx_init(void) {
@@ -169,5 +431,6 @@ void uart_rx_init(void) {
         ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
         ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, UART_RX_BUF_SIZE * 2, 0, 0, NULL, 0));
     }
+    link_decoder_reset(&s_decoder);
     xTaskCreate(uart_rx_task, "uart_rx", 4096, NULL, 5, NULL);
 }
\ No newline at end of file
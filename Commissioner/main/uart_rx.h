@@ -1,11 +1,30 @@
 #pragma once
 
+#include "esp_err.h"
 #include "esp_openthread.h"
 
 void uart_rx_init(void);
 
+/**
+ * @brief Report an unsolicited event (e.g. "NETWORK_FORMED") to the Bridge.
+ *
+ * Sent as a LINK_MSG_EVENT frame once the Bridge has spoken the framed
+ * protocol, otherwise printed as a plain text line for console use.
+ */
+void uart_link_event(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
 // Initialize the OpenThread stack
 void thread_init(void);
 
-// Form a new Thread network with the given name (Used by UART command)
-void form_new_network(const char *network_name); 
+/**
+ * @brief Form a new Thread network with the given name (Used by UART command)
+ *
+ * Scans FORM_CHANNEL_MASK first and forms on the quietest channel with a
+ * PAN ID no neighbouring network uses. Returns once the scan has started;
+ * CHANNEL_SCAN, CHANNEL_NETWORK and CHANNEL_SELECTED events report the
+ * result, and NETWORK_FORMED follows.
+ *
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the OpenThread lock was not acquired,
+ *         or ESP_ERR_INVALID_STATE while a formation is in progress.
+ */
+esp_err_t form_new_network(const char *network_name); 
@@ -1,46 +1,231 @@
 #include "udp_listener.h"
+#include "config.h"
+#include "telemetry_table.h"
+#include "hvac_sensor_payload.h"
+#include "hvac_report_policy.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_openthread.h"
 #include "esp_openthread_lock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "openthread/instance.h"
 #include "openthread/udp.h"
 #include "openthread/ip6.h"
+#include "openthread/link.h"
+#include "openthread/message.h"
+#include <stdatomic.h>
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "UDP_RX";
 
 #define UDP_LISTEN_PORT 1234
 
+_Static_assert((UDP_TELEMETRY_QUEUE_LEN & (UDP_TELEMETRY_QUEUE_LEN - 1)) == 0,
+               "UDP_TELEMETRY_QUEUE_LEN must be a power of two");
+
+// One received datagram, copied out of the OpenThread message
+typedef struct {
+    int64_t      rx_us;
+    otIp6Address peer;
+    uint16_t     peer_port;
+    bool         multicast;  // sent to a group address (ff03::2) rather than to us
+    int8_t       rss;        // last hop, dBm
+    uint8_t      link_quality;
+    uint16_t     len;        // bytes stored in data
+    uint16_t     orig_len;   // datagram length before truncation
+    uint8_t      data[UDP_TELEMETRY_MAX_PAYLOAD];
+} telemetry_item_t;
+
+// Single-producer (OpenThread task) / single-consumer (worker) ring.
+// Indices run freely and are masked on access.
+static telemetry_item_t s_ring[UDP_TELEMETRY_QUEUE_LEN];
+static atomic_uint s_head;   // written by the producer
+static atomic_uint s_tail;   // written by the consumer
+
 static otUdpSocket sUdpSocket;
 static bool sSocketOpen = false;
+static TaskHandle_t s_worker = NULL;
+static udp_listener_stats_t sStats;
 
+// Runs on the OpenThread task with the stack lock held: copy and return.
 static void udp_receive_callback(void *aContext, otMessage *aMessage,
                                  const otMessageInfo *aMessageInfo)
 {
-    char buf[256];
     uint16_t len = otMessageGetLength(aMessage) - otMessageGetOffset(aMessage);
 
-    if (len >= sizeof(buf)) {
-        len = sizeof(buf) - 1;
+    sStats.packets++;
+    sStats.bytes += len;
+
+    unsigned head = atomic_load_explicit(&s_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&s_tail, memory_order_acquire);
+    unsigned depth = head - tail;
+    if (depth >= UDP_TELEMETRY_QUEUE_LEN) {
+        sStats.queue_drops++;
+        return;
+    }
+
+    telemetry_item_t *item = &s_ring[head & (UDP_TELEMETRY_QUEUE_LEN - 1)];
+    item->rx_us = esp_timer_get_time();
+    item->peer = aMessageInfo->mPeerAddr;
+    item->peer_port = aMessageInfo->mPeerPort;
+    item->multicast = aMessageInfo->mSockAddr.mFields.m8[0] == 0xff;
+    item->rss = otMessageGetRss(aMessage);
+    item->link_quality = otLinkConvertRssToLinkQuality(esp_openthread_get_instance(), item->rss);
+    item->orig_len = len;
+    if (len > UDP_TELEMETRY_MAX_PAYLOAD) {
+        len = UDP_TELEMETRY_MAX_PAYLOAD;
+        sStats.truncated++;
     }
+    item->len = otMessageRead(aMessage, otMessageGetOffset(aMessage), item->data, len);
+
+    atomic_store_explicit(&s_head, head + 1, memory_order_release);
+    if (depth + 1 > sStats.queue_high_water) sStats.queue_high_water = (uint16_t)(depth + 1);
+
+    if (s_worker) xTaskNotifyGive(s_worker);
+}
+
+// Sensors are keyed by the interface identifier of their source address
+static uint64_t peer_iid(const otIp6Address *addr)
+{
+    uint64_t iid = 0;
+    for (int i = 8; i < 16; i++) iid = (iid << 8) | addr->mFields.m8[i];
+    return iid;
+}
+
+// Console form of a binary report, in the text payload's syntax
+static void format_reading(const telemetry_reading_t *r, char *out, size_t len)
+{
+    int n = snprintf(out, len, "seq=%lu", (unsigned long)r->seq);
+    if (r->age_s) n += snprintf(out + n, len - n, ";age=%u", r->age_s);
+    for (uint8_t i = 0; i < r->channel_count && n > 0 && (size_t)n < len; i++) {
+        n += snprintf(out + n, len - n, ";%s=%g", r->channels[i].name, (double)r->channels[i].value);
+    }
+}
+
+// Send a sensor the fleet report config; it acknowledges by announcing the
+// new id with its next reports. Worker task: takes the stack lock itself.
+static void push_report_config(const otIp6Address *peer, const hvac_report_config_t *cfg)
+{
+    uint8_t buf[HVAC_REPORT_CFG_MAX_LEN];
+    size_t len = hvac_report_config_encode(cfg, buf, sizeof(buf));
+    if (!len || !esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) return;
+
+    otInstance *instance = esp_openthread_get_instance();
+    otMessage *msg = otUdpNewMessage(instance, NULL);
+    otError err = msg ? otMessageAppend(msg, buf, (uint16_t)len) : OT_ERROR_NO_BUFS;
+    if (err == OT_ERROR_NONE) {
+        otMessageInfo info;
+        memset(&info, 0, sizeof(info));
+        info.mPeerAddr = *peer;
+        info.mPeerPort = HVAC_REPORT_CFG_PORT;
+        err = otUdpSend(instance, &sUdpSocket, msg, &info);
+    }
+    if (err != OT_ERROR_NONE && msg) otMessageFree(msg);
+    esp_openthread_lock_release();
+
+    if (err == OT_ERROR_NONE) {
+        sStats.config_pushes++;
+    } else {
+        ESP_LOGW(TAG, "Report config push failed: %d", err);
+    }
+}
 
-    otMessageRead(aMessage, otMessageGetOffset(aMessage), buf, len);
-    buf[len] = '\0';
+// Decode and forward one datagram (worker task, no stack lock held)
+static void telemetry_process(const telemetry_item_t *item)
+{
+    char text[UDP_TELEMETRY_MAX_PAYLOAD + 1];
+    uint32_t now_ms = (uint32_t)(item->rx_us / 1000);
+    telemetry_reading_t reading;
 
-    // Print the sender's IPv6 address
     char addrStr[OT_IP6_ADDRESS_STRING_SIZE];
-    otIp6AddressToString(&aMessageInfo->mPeerAddr, addrStr, sizeof(addrStr));
+    otIp6AddressToString(&item->peer, addrStr, sizeof(addrStr));
+
+    ESP_LOGI(TAG, "[%s]:%u %u bytes%s", addrStr, item->peer_port, item->orig_len,
+             item->orig_len > item->len ? " (truncated)" : "");
+
+    if (hvac_payload_is_binary(item->data, item->len) ||
+        hvac_report_config_is_message(item->data, item->len)) {
+        uint64_t iid = peer_iid(&item->peer);
+        sStats.binary++;
+
+        // One line per sample; a batch carries several reports back to back,
+        // possibly followed by the sender's report config
+        size_t off = 0;
+        while (off < item->len) {
+            hvac_report_config_t cfg;
+            size_t n = hvac_report_config_decode(item->data + off, item->len - off, &cfg);
+            if (n) {
+                telemetry_table_note_config(iid, &cfg);
+                printf("[UDP_RX] From [%s]:%d -> report config #%u heartbeat=%us\n", addrStr,
+                       item->peer_port, cfg.id, cfg.heartbeat_s);
+                off += n;
+                continue;
+            }
 
-    ESP_LOGW(TAG, "=== SENSOR DATA RECEIVED ===");
-    ESP_LOGW(TAG, "From: [%s]:%d", addrStr, aMessageInfo->mPeerPort);
-    ESP_LOGW(TAG, "Data (%d bytes): %s", len, buf);
-    ESP_LOGW(TAG, "============================");
+            n = hvac_payload_length(item->data + off, item->len - off);
+            if (n == 0) {
+                sStats.undecoded++;
+                break;
+            }
+            if (telemetry_table_update_binary(iid, item->data + off, n,
+                                              item->rss, item->link_quality, now_ms, &reading)) {
+                sStats.samples++;
+                format_reading(&reading, text, sizeof(text));
+            } else {
+                sStats.undecoded++;
+                snprintf(text, sizeof(text), "<binary, %u bytes, undecoded>", (unsigned)n);
+            }
+            printf("[UDP_RX] From [%s]:%d -> %s\n", addrStr, item->peer_port, text);
+            off += n;
+        }
 
-    // Also print to stdout so it shows on the serial monitor plainly
-    printf("[UDP_RX] From [%s]:%d -> %s\n", addrStr, aMessageInfo->mPeerPort, buf);
+        // Until the sensor announces the fleet config, answer with it; a
+        // sleepy sensor picks it up at its next poll. Answering multicast
+        // reports also gives the sensor our address to unicast to.
+        hvac_report_config_t due;
+        if (telemetry_table_config_due(iid, item->multicast, now_ms, &due)) {
+            push_report_config(&item->peer, &due);
+        }
+    } else {
+        memcpy(text, item->data, item->len);
+        text[item->len] = '\0';
+
+        if (telemetry_parse_text(text, &reading)) {
+            sStats.samples++;
+            telemetry_table_update(peer_iid(&item->peer), &reading, item->rss,
+                                   item->link_quality, now_ms);
+        } else {
+            sStats.undecoded++;
+        }
+
+        // Plain line on the serial console, as before
+        printf("[UDP_RX] From [%s]:%d -> %s\n", addrStr, item->peer_port, text);
+    }
     fflush(stdout);
 }
 
+static void telemetry_worker_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        unsigned tail = atomic_load_explicit(&s_tail, memory_order_relaxed);
+        while (tail != atomic_load_explicit(&s_head, memory_order_acquire)) {
+            const telemetry_item_t *item = &s_ring[tail & (UDP_TELEMETRY_QUEUE_LEN - 1)];
+
+            uint32_t wait_us = (uint32_t)(esp_timer_get_time() - item->rx_us);
+            if (wait_us > sStats.max_queue_us) sStats.max_queue_us = wait_us;
+
+            telemetry_process(item);
+            sStats.processed++;
+
+            atomic_store_explicit(&s_tail, ++tail, memory_order_release);
+        }
+    }
+}
+
 void udp_listener_start(void)
 {
     if (sSocketOpen) {
@@ -48,6 +233,15 @@ void udp_listener_start(void)
         return;
     }
 
+    telemetry_table_init();
+    if (!s_worker &&
+        xTaskCreate(telemetry_worker_task, "udp_telemetry", UDP_TELEMETRY_TASK_STACK, NULL,
+                    UDP_TELEMETRY_TASK_PRIORITY, &s_worker) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start telemetry worker");
+        s_worker = NULL;
+        return;
+    }
+
     otInstance *instance = esp_openthread_get_instance();
 
     memset(&sUdpSocket, 0, sizeof(sUdpSocket));
@@ -71,5 +265,24 @@ void udp_listener_start(void)
     }
 
     sSocketOpen = true;
-    ESP_LOGW(TAG, "*** UDP Listener ACTIVE on port %d ***", UDP_LISTEN_PORT);
+    ESP_LOGW(TAG, "*** UDP Listener ACTIVE on port %d (queue %d x %d B) ***",
+             UDP_LISTEN_PORT, UDP_TELEMETRY_QUEUE_LEN, UDP_TELEMETRY_MAX_PAYLOAD);
+}
+
+void udp_listener_get_stats(udp_listener_stats_t *out, bool reset)
+{
+    otInstance *instance = esp_openthread_get_instance();
+    otBufferInfo info;
+    otMessageGetBufferInfo(instance, &info);
+
+    *out = sStats;
+    out->queue_depth = (uint16_t)(atomic_load(&s_head) - atomic_load(&s_tail));
+    out->buffers_total = info.mTotalBuffers;
+    out->buffers_free = info.mFreeBuffers;
+    out->buffers_max_used = info.mMaxUsedBuffers;
+
+    if (reset) {
+        memset(&sStats, 0, sizeof(sStats));
+        otMessageResetBufferInfo(instance);
+    }
 }
@@ -1,7 +1,44 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /**
  * Open a UDP socket on port 1234 bound to the mesh-local address.
  * Must be called while the OT lock is held OR from the OT main thread.
+ *
+ * Datagrams are copied into a ring in the receive callback and handled by
+ * a worker task, so nothing slow runs on the OpenThread task. The worker
+ * also pushes the fleet report config (telemetry_table_set_report_config())
+ * from this socket to each sensor that has not announced it yet, and now
+ * and then to sensors reporting by multicast, which then unicast their
+ * reports to the address the push came from.
  */
 void udp_listener_start(void);
+
+typedef struct {
+    uint32_t packets;          // datagrams delivered to the listener
+    uint32_t bytes;            // payload bytes
+    uint32_t truncated;        // payloads cut to UDP_TELEMETRY_MAX_PAYLOAD
+    uint32_t queue_drops;      // ring full, datagram discarded
+    uint32_t processed;        // handled by the worker
+    uint32_t binary;           // payloads in the binary report format
+    uint32_t samples;          // readings recorded (several per batched payload)
+    uint32_t undecoded;        // payloads with no readable values
+    uint32_t config_pushes;    // report configs sent to sensors
+    uint32_t max_queue_us;     // longest receive -> worker delay
+    uint16_t queue_depth;
+    uint16_t queue_high_water;
+    uint16_t buffers_total;    // OpenThread message pool
+    uint16_t buffers_free;
+    uint16_t buffers_max_used; // pool high-water mark since the last reset
+} udp_listener_stats_t;
+
+/**
+ * @brief Snapshot the listener counters and the OpenThread message pool.
+ *
+ * Must be called while the OT lock is held.
+ *
+ * @param reset Clear the counters and the pool high-water mark afterwards.
+ */
+void udp_listener_get_stats(udp_listener_stats_t *out, bool reset);
@@ -4,6 +4,8 @@
 #include <nvs_flash.h>
 #include "esp_openthread.h"
 #include "esp_openthread_lock.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
 
 #include "openthread/instance.h"
 #include "openthread/thread.h"
@@ -13,121 +15,370 @@
 #include "openthread/ip6.h"
 #include "openthread/dataset.h"
 
+// Radio time split in the stats report; needs an OpenThread library built
+// with OPENTHREAD_CONFIG_RADIO_STATS_ENABLE
+#ifndef REPORT_RADIO_TIME
+#define REPORT_RADIO_TIME 0
+#endif
+#if REPORT_RADIO_TIME
+#include "openthread/radio_stats.h"
+#endif
+
+#include <hvac_sensor_payload.h>
+#include <hvac_report_policy.h>
+#include "telemetry_tx.h"
+#include "joiner_client.h"
+
 // Your secure passphrase
 const char *pskd = "J01NME";
 
 // Global state flags
-volatile bool g_joined = false;
+volatile bool g_joined = false;   // have credentials; attaching or attached
 volatile bool g_failed = false;
 
-// --- JOINER CALLBACK ---
-void otaJoinerCallback(otError aError, void *aContext) {
-  Serial.printf("\n[JOINER] Callback received with error code: %d\n", aError);
+// --- TELEMETRY BATCHING ---
+// Samples are buffered and sent BATCH_SAMPLES at a time as one datagram,
+// so the radio wakes once per batch instead of once per reading. A batch
+// also goes out early when its oldest sample reaches BATCH_MAX_AGE_MS or a
+// sample crosses an alarm threshold. BATCH_SAMPLES 1 sends every sample.
+#define SAMPLE_INTERVAL_MS 10000
+#define BATCH_SAMPLES      6        // 6 temperature reports (~50 B) fit one 802.15.4 frame
+#define BATCH_MAX_AGE_MS   60000
+#define ALARM_HIGH_C       35.0f
+#define ALARM_LOW_C        5.0f
+#define SEND_RETRY_MS      1000
+
+// --- REPORT ON CHANGE ---
+// A sample only enters the batch if it moved more than REPORT_DEADBAND_C
+// from the value last reported or changes faster than REPORT_SLOPE_C_PER_MIN;
+// otherwise a heartbeat sample goes out every REPORT_HEARTBEAT_S. These are
+// the defaults until the Commissioner pushes its own thresholds to
+// HVAC_REPORT_CFG_PORT. REPORT_HEARTBEAT_S 0 reports every sample.
+#define REPORT_DEADBAND_C      0.2f
+#define REPORT_SLOPE_C_PER_MIN 1.0f
+#define REPORT_HEARTBEAT_S     HVAC_REPORT_DEFAULT_HEARTBEAT_S
+
+// Radio-on estimate for the periodic report (802.15.4 at 250 kb/s)
+#define STATS_PERIOD_MS      3600000
+#define RADIO_SEND_FIXED_US  3000   // wake, CSMA backoff, ACK wait, data poll
+#define RADIO_US_PER_BYTE    32
+#define RADIO_FRAME_OVERHEAD 45     // MAC + 6LoWPAN + UDP header bytes
+
+// --- POWER SCHEDULER ---
+// loop() does whatever is due, then blocks until the next deadline (sample,
+// batch age, send retry, join retry, stats report) instead of spinning.
+// With automatic light sleep the SoC sleeps whenever every task is
+// blocked. The OpenThread task blocks on its own next timer (parent poll,
+// MAC and MLE timers), so FreeRTOS's tickless idle folds the stack's
+// deadlines in without the sketch tracking them.
+#define CHILD_TIMEOUT_S    240
+#define REPORT_INTERVAL_MS ((SAMPLE_INTERVAL_MS * BATCH_SAMPLES) < BATCH_MAX_AGE_MS ? \
+                            (SAMPLE_INTERVAL_MS * BATCH_SAMPLES) : BATCH_MAX_AGE_MS)
+// The Commissioner only sends to the sensor in answer to its reports (its
+// address, report config pushes), so poll once per report, but often enough
+// that the parent keeps us well within the child timeout. While an answer is
+// expected (no unicast address yet, or a config ack still to go out) poll at
+// FAST_POLL_PERIOD_MS so it is not held at the parent for a whole period.
+#define POLL_PERIOD_MS     (REPORT_INTERVAL_MS < CHILD_TIMEOUT_S * 1000 / 4 ? \
+                            REPORT_INTERVAL_MS : CHILD_TIMEOUT_S * 1000 / 4)
+#define FAST_POLL_PERIOD_MS 5000
+#define JOIN_RADAR_MS      2000     // also how often attach is checked after boot
+
+static struct {
+  int64_t  active_us;   // loop() running
+  int64_t  blocked_us;  // loop() waiting; light sleep happens inside this
+  uint32_t wakes;
+} g_duty;
+static int64_t g_woke_us = 0;
+
+typedef struct {
+  uint32_t t_ms;
+  uint16_t seq;
+  float    temp;
+} sample_t;
+
+// Samples waiting for the next report. Plain RAM: the sketch only light
+// sleeps, which keeps it, and t_ms is millis(), which restarts with a reset.
+static sample_t g_batch[BATCH_SAMPLES];
+static uint8_t  g_batch_len = 0;
+static uint16_t g_report_seq = 0;
+static bool g_alarm_pending = false;
+
+static hvac_report_config_t g_report_cfg;       // thresholds in force
+static hvac_report_state_t  g_report_state = {};
+static hvac_report_config_t g_cfg_pending;      // pushed config, applied by loop()
+static bool g_cfg_received = false;             // both written under the OT lock
+static bool g_cfg_announce = true;              // echo g_report_cfg in the next datagram
+
+static struct {
+  uint32_t samples;    // reported
+  uint32_t suppressed; // unchanged samples not reported
+  uint32_t dropped;   // oldest sample overwritten while the batch could not be sent
+  uint32_t sends;
+  uint32_t bytes;
+} g_tx_stats;
+
+// --- REPORT CONFIG ---
+static void report_config_defaults() {
+  uint8_t count;
+  const hvac_channel_desc_t *desc = hvac_sensor_channels(HVAC_SENSOR_TEMP, &count);
+
+  memset(&g_report_cfg, 0, sizeof(g_report_cfg));
+  g_report_cfg.heartbeat_s = REPORT_HEARTBEAT_S;
+  g_report_cfg.channel_count = 1;
+  g_report_cfg.deadband[0] = hvac_payload_quantize(REPORT_DEADBAND_C, desc[0].scale);
+  g_report_cfg.slope[0] = hvac_payload_quantize(REPORT_SLOPE_C_PER_MIN, desc[0].scale);
+}
 
-  if (aError == OT_ERROR_NONE) {
-    g_joined = true;
-    Serial.println("[JOINER] Successfully authenticated! Network keys saved to NVS.");
+// Runs on the OpenThread task with the stack lock held: keep it for loop()
+static void cfg_receive(const uint8_t *data, size_t len) {
+  hvac_report_config_t cfg;
+  if (hvac_report_config_decode(data, len, &cfg)) {
+    g_cfg_pending = cfg;
+    g_cfg_received = true;
+  }
+}
 
-    Serial.println("[SYSTEM] Rebooting to apply new credentials...");
-    delay(500);
-    ESP.restart(); // The easiest/safest way to transition from Joiner to normal End Device in ESP32
-    
-  } else if (aError == 23) {
-    // ERROR 23 = Not Found. This is normal wireless packet loss.
-    Serial.println("[JOINER] Error 23: Missed the router's beacon. Will retry...");
-    g_failed = false; // Do NOT give up!
-    
+// Caller MUST hold OT lock
+static void apply_config_locked() {
+  hvac_report_config_t cfg = g_cfg_pending;
+  g_cfg_received = false;
+  g_cfg_announce = true;  // also re-acknowledges a repeated push
+  if (cfg.id == g_report_cfg.id) return;
+
+  if (cfg.id == 0) {
+    report_config_defaults();
   } else {
-    // ERROR 28 (Security) or other fatal errors
-    g_failed = true;
-    Serial.printf("[JOINER] FATAL: Handshake failed with Error %d. STOPPING.\n", aError);
-    if (aError == 28) Serial.println("[DEBUG] Error 28 = Security Rejected. PSKD mismatch.");
+    g_report_cfg = cfg;
   }
+  g_report_state.valid = false;  // report the next sample, which carries the ack
+  Serial.printf("[CONFIG] Report config #%u: heartbeat %us, deadband %u, slope %u/min\n",
+                g_report_cfg.id, g_report_cfg.heartbeat_s,
+                g_report_cfg.channel_count ? g_report_cfg.deadband[0] : 0,
+                g_report_cfg.channel_count ? g_report_cfg.slope[0] : 0);
 }
 
-// --- Helper: start joiner (caller MUST hold OT lock) ---
-static void start_joiner_locked(otInstance *inst) {
-  otJoinerStop(inst);
-
-  otError err = otJoinerStart(
-    inst,
-    pskd,
-    NULL,
-    "MyVendor",
-    "MySensor",
-    "1.0.0",
-    NULL,
-    otaJoinerCallback,
-    NULL);
-
-  if (err != OT_ERROR_NONE) {
-    Serial.printf("[JOINER] WARNING: Joiner failed to initialize! Error: %d\n", err);
-  } else {
-    Serial.println("[JOINER] Joiner process started. Scanning...");
+// --- TELEMETRY ---
+static void take_sample() {
+  float temp = temperatureRead();
+  if (isnan(temp)) return;  // failed read: report nothing rather than 0 degrees
+
+  // Crossing a threshold in either direction is reported at once
+  static bool in_alarm = false;
+  bool alarm = temp >= ALARM_HIGH_C || temp <= ALARM_LOW_C;
+  bool alarm_changed = alarm != in_alarm;
+  if (alarm_changed) {
+    in_alarm = alarm;
+    g_alarm_pending = true;
+    Serial.printf("[ALARM] temp=%.2f %s\n", temp, alarm ? "out of range" : "back in range");
   }
+
+  // Unchanged readings are left out; silence means "same as last report"
+  uint8_t count;
+  const hvac_channel_desc_t *desc = hvac_sensor_channels(HVAC_SENSOR_TEMP, &count);
+  int16_t q = hvac_payload_quantize(temp, desc[0].scale);
+  uint32_t now_s = millis() / 1000;
+  if (hvac_report_decide(&g_report_cfg, &g_report_state, &q, 1, now_s) == HVAC_REPORT_SKIP) {
+    if (!alarm_changed) {
+      g_tx_stats.suppressed++;
+      return;
+    }
+    hvac_report_mark(&g_report_state, &q, 1, now_s);
+  }
+
+  // Batch full and not sent (detached?): keep the newest samples
+  if (g_batch_len == BATCH_SAMPLES) {
+    memmove(&g_batch[0], &g_batch[1], sizeof(g_batch[0]) * (BATCH_SAMPLES - 1));
+    g_batch_len--;
+    g_tx_stats.dropped++;
+  }
+
+  sample_t *s = &g_batch[g_batch_len++];
+  s->t_ms = millis();
+  s->seq = g_report_seq++;
+  s->temp = temp;
+  g_tx_stats.samples++;
 }
 
-// --- SETUP ---
-// void setup() {
-//   Serial.begin(115200);
-//   delay(2000);
-
-//   nvs_flash_erase();
-//   esp_err_t ret = nvs_flash_init();
-//   if (ret != ESP_OK) {
-//       Serial.printf("[SYSTEM] NVS Init Failed: %s\n", esp_err_to_name(ret));
-//       nvs_flash_init(); 
-//   } else {
-//       Serial.println("[SYSTEM] NVS Partition mounted.");
-//   }
-
-//   Serial.println("\n[BOOT] Starting OpenThread SED Device...");
-//   OpenThread::begin(false); // Do not auto-start with default PAN
-//   delay(500); 
-
-//   if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(5000))) {
-//     Serial.println("[FATAL] Could not acquire OT lock in setup!");
-//     return;
-//   }
-
-//   otInstance *inst = esp_openthread_get_instance();
-
-//   // 2. CHECK FOR EXISTING CREDENTIALS FIRST
-//   otOperationalDataset activeDataset;
-//   if (otDatasetGetActive(inst, &activeDataset) == OT_ERROR_NONE) {
-//     Serial.printf("[SYSTEM] Found existing credentials (PAN: 0x%04X). Connecting...\n", activeDataset.mPanId);
-    
-//     otLinkModeConfig linkMode = { .mRxOnWhenIdle = 0, .mDeviceType = 0, .mNetworkData = 1 };
-//     otThreadSetLinkMode(inst, linkMode);
+// Why the batch should go out now, or NULL to keep buffering
+static const char *batch_send_reason() {
+  if (g_batch_len == 0) return NULL;
+  if (g_alarm_pending) return "alarm";
+  if (g_batch_len >= BATCH_SAMPLES) return "full";
+  if (millis() - g_batch[0].t_ms >= BATCH_MAX_AGE_MS) return "age";
+  return NULL;
+}
+
+// Pack the batch into one datagram, oldest first, followed by the report
+// config when it has to be announced (caller MUST hold OT lock). The batch
+// is kept unless the datagram was sent.
+static TelemetryTxResult send_batch_locked(otInstance *inst, const char *reason) {
+  uint8_t payload[BATCH_SAMPLES * HVAC_PAYLOAD_MAX_LEN + HVAC_REPORT_CFG_MAX_LEN];
+  size_t payloadLen = 0;
+  uint32_t now = millis();
+
+  // Deltas chain only within this datagram, which starts with an absolute
+  // value: a lost or retried datagram costs only its own samples, and the
+  // Commissioner never decodes against a report it did not receive
+  hvac_payload_ref_t ref = {};
+
+  for (uint8_t i = 0; i < g_batch_len; i++) {
+    hvac_payload_t report = {};
+    report.type = HVAC_SENSOR_TEMP;
+    report.seq = g_batch[i].seq;
+    uint32_t age_s = (now - g_batch[i].t_ms) / 1000;
+    if (g_report_cfg.heartbeat_s) report.flags |= HVAC_PAYLOAD_F_ON_CHANGE;
+    if (age_s > 0) {
+      report.flags |= HVAC_PAYLOAD_F_TIME;
+      report.age_s = age_s > 0xFFFF ? 0xFFFF : (uint16_t)age_s;
+    }
+    hvac_payload_set(&report, 0, g_batch[i].temp);
+    payloadLen += hvac_payload_encode(&report, &ref, HVAC_PAYLOAD_KEY_INTERVAL,
+                                      payload + payloadLen, sizeof(payload) - payloadLen);
+  }
+  size_t configLen = 0;
+  if (g_cfg_announce) {
+    configLen = hvac_report_config_encode(&g_report_cfg, payload + payloadLen,
+                                          sizeof(payload) - payloadLen);
+    payloadLen += configLen;
+  }
 
-//     otIp6SetEnabled(inst, true);
-//     otThreadSetEnabled(inst, true);
-//     g_joined = true;
+  TelemetryTxResult res = telemetryTxSend(inst, payload, payloadLen);
+  if (res != TELEMETRY_TX_SENT) return res;
+
+  Serial.printf("[UDP] Sent %u sample(s) #%u-#%u to %s (%s, %u bytes, last temp=%.2f)%s\n",
+                g_batch_len, g_batch[0].seq, g_batch[g_batch_len - 1].seq,
+                telemetryTxUnicast() ? "Commissioner" : "ff03::2", reason,
+                (unsigned)payloadLen, g_batch[g_batch_len - 1].temp,
+                configLen ? " + report config" : "");
+  g_tx_stats.sends++;
+  g_tx_stats.bytes += payloadLen;
+  g_batch_len = 0;
+  g_alarm_pending = false;
+  if (configLen) g_cfg_announce = false;
+  return TELEMETRY_TX_SENT;
+}
 
-//   } else {
-//     Serial.println("[SYSTEM] No credentials found. Starting Joiner Process...");
-    
-//     // Read hardware MAC for logging
-//     uint8_t hardware_mac[8];
-//     if (esp_read_mac(hardware_mac, ESP_MAC_IEEE802154) == ESP_OK) {
-//       Serial.print("[HW] Factory EUI-64: ");
-//       for (int i = 0; i < 8; i++) Serial.printf("%02x", hardware_mac[i]);
-//       Serial.println();
-//     }
+// Caller MUST hold OT lock
+static void update_poll_period_locked(otInstance *inst) {
+  static uint32_t period = POLL_PERIOD_MS;  // as set in setup()
+  bool awaiting = (TELEMETRY_TX_UNICAST && !telemetryTxUnicast()) || g_cfg_announce;
+  uint32_t want = awaiting && FAST_POLL_PERIOD_MS < POLL_PERIOD_MS ? FAST_POLL_PERIOD_MS
+                                                                    : POLL_PERIOD_MS;
+  if (want == period || otLinkSetPollPeriod(inst, want) != OT_ERROR_NONE) return;
+  period = want;
+  Serial.printf("[POWER] Poll period %lu ms\n", (unsigned long)period);
+}
+
+// Estimated radio-on time for the period, against one datagram per sample
+// taken (neither batched nor suppressed)
+static void print_tx_stats() {
+  uint32_t single = HVAC_PAYLOAD_HEADER_LEN + 2;  // one absolute temperature report
+  uint32_t taken = g_tx_stats.samples + g_tx_stats.suppressed;
+  uint64_t batched_us = (uint64_t)g_tx_stats.sends * RADIO_SEND_FIXED_US +
+                        ((uint64_t)g_tx_stats.bytes + (uint64_t)g_tx_stats.sends * RADIO_FRAME_OVERHEAD) *
+                            RADIO_US_PER_BYTE;
+  uint64_t unbatched_us = (uint64_t)taken *
+                          (RADIO_SEND_FIXED_US + (single + RADIO_FRAME_OVERHEAD) * RADIO_US_PER_BYTE);
+
+  Serial.printf("[TX STATS] %lus: samples=%lu suppressed=%lu sends=%lu bytes=%lu dropped=%lu | "
+                "est. radio-on %lu ms (one send per sample: %lu sends, %lu ms)\n",
+                (unsigned long)(STATS_PERIOD_MS / 1000), (unsigned long)g_tx_stats.samples,
+                (unsigned long)g_tx_stats.suppressed, (unsigned long)g_tx_stats.sends,
+                (unsigned long)g_tx_stats.bytes, (unsigned long)g_tx_stats.dropped,
+                (unsigned long)(batched_us / 1000), (unsigned long)taken,
+                (unsigned long)(unbatched_us / 1000));
+
+  TelemetryTxStats tx = telemetryTxGetStats(true);
+  Serial.printf("[TX STATS] udp sent=%lu unicast=%lu no_bufs=%lu failed=%lu rx=%lu "
+                "latency avg=%luus max=%luus\n",
+                (unsigned long)tx.sent, (unsigned long)tx.unicast, (unsigned long)tx.noBufs,
+                (unsigned long)tx.failed, (unsigned long)tx.received,
+                (unsigned long)(tx.sent ? tx.latencySumUs / tx.sent : 0),
+                (unsigned long)tx.latencyMaxUs);
+  memset(&g_tx_stats, 0, sizeof(g_tx_stats));
+}
+
+// Where the time went since the last report: CPU running loop(), loop()
+// blocked (the SoC light-sleeps in here unless another task runs), and
+// what the radio did
+static void print_duty_stats() {
+  int64_t total = g_duty.active_us + g_duty.blocked_us;
+  if (total <= 0) return;
+  Serial.printf("[DUTY] wakes=%lu active=%.3f%% blocked=%.3f%%\n", (unsigned long)g_duty.wakes,
+                100.0 * g_duty.active_us / total, 100.0 * g_duty.blocked_us / total);
+  memset(&g_duty, 0, sizeof(g_duty));
+
+#if REPORT_RADIO_TIME
+  if (esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) {
+    otInstance *inst = esp_openthread_get_instance();
+    otRadioTimeStats rt = *otRadioTimeStatsGet(inst);
+    otRadioTimeStatsReset(inst);
+    esp_openthread_lock_release();
+
+    uint64_t radio_total = rt.mDisabledTime + rt.mSleepTime + rt.mTxTime + rt.mRxTime;
+    if (radio_total > 0) {
+      Serial.printf("[DUTY] radio rx=%.3f%% tx=%.3f%% sleep=%.3f%%\n",
+                    100.0 * rt.mRxTime / radio_total, 100.0 * rt.mTxTime / radio_total,
+                    100.0 * rt.mSleepTime / radio_total);
+    }
+  }
+#endif
+}
 
-//     // Keep radio awake during handshake
-//     otLinkModeConfig joinMode = { .mRxOnWhenIdle = 1, .mDeviceType = 0, .mNetworkData = 1 };
-//     otThreadSetLinkMode(inst, joinMode);
+// Earlier of two millis() deadlines, wrap-safe
+static inline void deadline_min(uint32_t &next, uint32_t t) {
+  if ((int32_t)(t - next) < 0) next = t;
+}
 
-//     otIp6SetEnabled(inst, true);
-//     otLinkSetChannel(inst, 15);
-//     otLinkSetSupportedChannelMask(inst, (1 << 15));
+// --- ROLE CHANGES ---
+// A batch is held back while we are not attached as a child. Instead of
+// polling the role, loop() is woken when it changes (OpenThread task, lock
+// held).
+static TaskHandle_t g_loop_task = NULL;
+static volatile bool g_role_changed = false;
+
+static void state_changed(otChangedFlags flags, void *context) {
+  if (!(flags & OT_CHANGED_THREAD_ROLE)) return;
+  g_role_changed = true;
+  if (g_loop_task) xTaskNotifyGive(g_loop_task);
+}
 
-//     start_joiner_locked(inst); 
-//   }
+// Block loop() until deadline or a role change; the only place the sketch
+// waits
+static void sleep_until(uint32_t deadline) {
+  int64_t now_us = esp_timer_get_time();
+  g_duty.active_us += now_us - g_woke_us;
 
-//   esp_openthread_lock_release();
-// }
+  int32_t wait_ms = (int32_t)(deadline - millis());
+  if (wait_ms > 0) {
+    Serial.flush();  // light sleep would cut off pending UART output
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms) + 1);
+  }
+
+  g_woke_us = esp_timer_get_time();
+  g_duty.blocked_us += g_woke_us - now_us;
+  g_duty.wakes++;
+}
+
+// Automatic light sleep between deadlines, when the core supports it
+static void power_init() {
+#if CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  esp_pm_config_t pm = {};
+  pm.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+  pm.min_freq_mhz = CONFIG_XTAL_FREQ;
+  pm.light_sleep_enable = true;
+  esp_err_t err = esp_pm_configure(&pm);
+  if (err == ESP_OK) {
+    Serial.printf("[POWER] Light sleep enabled (%d-%d MHz)\n", pm.min_freq_mhz, pm.max_freq_mhz);
+  } else {
+    Serial.printf("[POWER] esp_pm_configure failed: %s\n", esp_err_to_name(err));
+  }
+#else
+  Serial.println("[POWER] Core built without CONFIG_PM_ENABLE/CONFIG_FREERTOS_USE_TICKLESS_IDLE: "
+                 "idling between deadlines without light sleep");
+#endif
+}
 
 // --- SETUP ---
 void setup() {
@@ -151,6 +402,9 @@ void setup() {
       Serial.println("[SYSTEM] NVS Partition mounted successfully.");
   }
 
+  power_init();
+  report_config_defaults();
+
   Serial.println("\n[BOOT] Starting OpenThread SED Device...");
   OpenThread::begin(false); // Do not auto-start with default PAN
   delay(500); 
@@ -162,6 +416,15 @@ void setup() {
 
   otInstance *inst = esp_openthread_get_instance();
 
+  joinerClientBegin(inst);
+  JoinStats js = joinerClientGetStats();
+  if (js.cached) {
+    Serial.printf("[JOINER] Last network: channel %u, PAN 0x%04X | %lu join(s), last took %u attempt(s) "
+                  "/ %lu ms | last attach %lu ms after boot\n",
+                  js.channel, js.panId, (unsigned long)js.joins, js.lastAttempts,
+                  (unsigned long)js.lastJoinMs, (unsigned long)js.lastAttachMs);
+  }
+
   // 2. CHECK FOR EXISTING CREDENTIALS FIRST
   otOperationalDataset activeDataset;
   if (otDatasetGetActive(inst, &activeDataset) == OT_ERROR_NONE) {
@@ -169,9 +432,21 @@ void setup() {
     
     otLinkModeConfig linkMode = { .mRxOnWhenIdle = 0, .mDeviceType = 0, .mNetworkData = 1 };
     otThreadSetLinkMode(inst, linkMode);
+    otThreadSetChildTimeout(inst, CHILD_TIMEOUT_S);
+    otLinkSetPollPeriod(inst, POLL_PERIOD_MS);
+    Serial.printf("[POWER] Poll period %lu ms, child timeout %u s\n",
+                  (unsigned long)POLL_PERIOD_MS, CHILD_TIMEOUT_S);
+
+    g_loop_task = xTaskGetCurrentTaskHandle();
+    if (otSetStateChangedCallback(inst, state_changed, NULL) != OT_ERROR_NONE) {
+      Serial.println("[SYSTEM] No state callback slot: a held batch waits for the poll period");
+    }
 
     otIp6SetEnabled(inst, true);
     otThreadSetEnabled(inst, true);
+    if (!telemetryTxBegin(inst, cfg_receive)) {
+      Serial.println("[UDP] Telemetry socket unavailable, retrying from loop()");
+    }
     g_joined = true;
 
   } else {
@@ -190,44 +465,50 @@ void setup() {
     otThreadSetLinkMode(inst, joinMode);
 
     otIp6SetEnabled(inst, true);
-    otLinkSetChannel(inst, 15);
-    otLinkSetSupportedChannelMask(inst, (1 << 15));
-
-    start_joiner_locked(inst); 
+    joinerClientStart(inst, pskd);
   }
 
   esp_openthread_lock_release();
+  g_woke_us = esp_timer_get_time();
 }
 
 
 // --- MAIN LOOP ---
 void loop() {
+  uint32_t now = millis();
+  uint32_t next = now + STATS_PERIOD_MS;  // longest we ever sleep
+
   // --- 1. JOINER RADAR & RETRY LOGIC ---
   if (!g_joined && !g_failed) {
+    static uint32_t radar_timer = 0;
+    JoinerClientState state = JOINER_CLIENT_JOINING;
+
     if (esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) {
       otInstance *inst = esp_openthread_get_instance();
-      otJoinerState state = otJoinerGetState(inst);
+      state = joinerClientPoll(inst);
 
-      // Radar every 2 seconds
-      static uint32_t radar_timer = 0;
-      if (millis() - radar_timer > 2000) {
-        radar_timer = millis();
+      // Radar every 2 seconds while an attempt runs
+      if (state == JOINER_CLIENT_JOINING && now - radar_timer >= JOIN_RADAR_MS) {
+        radar_timer = now;
         const otMacCounters *mac = otLinkGetCounters(inst);
         Serial.printf("[JOINER RADAR] State: %d | MAC TX: %lu  RX: %lu | Ch: %d PAN: 0x%04X\n",
-                      state, (unsigned long)mac->mTxTotal, (unsigned long)mac->mRxTotal,
-                      otLinkGetChannel(inst), otLinkGetPanId(inst));
+                      otJoinerGetState(inst), (unsigned long)mac->mTxTotal,
+                      (unsigned long)mac->mRxTotal, otLinkGetChannel(inst), otLinkGetPanId(inst));
       }
-
-      // Smart Retry: Only if idle (e.g. Error 23 timeout) and 5 seconds have passed
-      static uint32_t retry_timer = 0;
-      if (state == OT_JOINER_STATE_IDLE && millis() - retry_timer > 5000) {
-        retry_timer = millis();
-        Serial.println("[JOINER] Retrying discovery...");
-        start_joiner_locked(inst);
-      }
-
       esp_openthread_lock_release();
     }
+
+    if (state == JOINER_CLIENT_JOINED) {
+      Serial.println("[SYSTEM] Rebooting to apply new credentials...");
+      delay(500);
+      ESP.restart(); // The easiest/safest way to transition from Joiner to normal End Device in ESP32
+    } else if (state == JOINER_CLIENT_FAILED) {
+      g_failed = true;
+    } else if (state == JOINER_CLIENT_WAITING) {
+      deadline_min(next, joinerClientNextAttemptAt());
+    } else {
+      deadline_min(next, radar_timer + JOIN_RADAR_MS);
+    }
   }
   // --- 2. FATAL ERROR HALT ---
   else if (g_failed) {
@@ -238,45 +519,78 @@ void loop() {
       }
   }
 
-  // --- 3. UDP TX AFTER JOIN ---
-  if (g_joined && esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) {
+  // Time from boot to attach, for the join statistics
+  static bool attach_recorded = false;
+  if (g_joined && !attach_recorded && esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) {
     otInstance *inst = esp_openthread_get_instance();
-    static uint32_t last = 0;
-    otDeviceRole currentRole = otThreadGetDeviceRole(inst);
-
-    // Only send data if we are successfully attached to the mesh as a CHILD
-    if (currentRole == OT_DEVICE_ROLE_CHILD && millis() - last > 10000) {
-      last = millis();
-
-      otMessage *msg = otUdpNewMessage(inst, NULL);
-      if (msg != NULL) {
-        const char *p = "temp=23";
-        otMessageAppend(msg, p, strlen(p));
-
-        otUdpSocket ephemeralSocket;
-        memset(&ephemeralSocket, 0, sizeof(ephemeralSocket));
-        otUdpOpen(inst, &ephemeralSocket, NULL, NULL);
-
-        otMessageInfo messageInfo;
-        memset(&messageInfo, 0, sizeof(messageInfo));
-        messageInfo.mPeerPort = 1234;
-        
-        // Target the Commissioner without hardcoding IP via Realm-Local All-Routers multicast
-        otIp6AddressFromString("ff03::2", &messageInfo.mPeerAddr);
-
-        otError sendErr = otUdpSend(inst, &ephemeralSocket, msg, &messageInfo);
-        otUdpClose(inst, &ephemeralSocket);
-
-        if (sendErr == OT_ERROR_NONE) {
-          Serial.println("[UDP] Packet sent to Router (temp=23)");
-        } else {
-          Serial.printf("[UDP] Send failed: %d\n", sendErr);
-          otMessageFree(msg);
-        }
-      }
+    if (otThreadGetDeviceRole(inst) == OT_DEVICE_ROLE_CHILD) {
+      attach_recorded = true;
+      joinerClientAttached(inst, now);
+      Serial.printf("[JOINER] Attached %lu ms after boot\n", (unsigned long)now);
     }
     esp_openthread_lock_release();
   }
+  if (g_joined && !attach_recorded) deadline_min(next, now + JOIN_RADAR_MS);
 
-  delay(10);
-}
\ No newline at end of file
+  if (g_joined) {
+    // --- 3. SAMPLE INTO THE BATCH ---
+    if (g_cfg_received && esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) {
+      apply_config_locked();
+      esp_openthread_lock_release();
+    }
+
+    static uint32_t last_sample = 0;
+    if (now - last_sample >= SAMPLE_INTERVAL_MS) {
+      last_sample = now;
+      take_sample();
+    }
+    deadline_min(next, last_sample + SAMPLE_INTERVAL_MS);
+
+    // --- 4. UDP TX AFTER JOIN ---
+    static uint32_t retry_at = 0;
+    if (g_role_changed) {
+      g_role_changed = false;
+      retry_at = now;  // attached again (or lost it): try the held batch now
+    }
+    const char *reason = batch_send_reason();
+    if (reason && (int32_t)(now - retry_at) >= 0 &&
+        esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) {
+      otInstance *inst = esp_openthread_get_instance();
+      retry_at = now + SEND_RETRY_MS;
+
+      // Only send data if we are successfully attached to the mesh as a
+      // CHILD. Otherwise wait for the role to change, or at most a poll
+      // period.
+      if (otThreadGetDeviceRole(inst) != OT_DEVICE_ROLE_CHILD) {
+        retry_at = now + POLL_PERIOD_MS;
+      } else if (telemetryTxBegin(inst, cfg_receive) &&
+                 send_batch_locked(inst, reason) != TELEMETRY_TX_SENT) {
+        retry_at = telemetryTxRetryAt();  // out of buffers or failed: back off
+      }
+      esp_openthread_lock_release();
+    }
+
+    if (esp_openthread_lock_acquire(pdMS_TO_TICKS(100))) {
+      update_poll_period_locked(esp_openthread_get_instance());
+      esp_openthread_lock_release();
+    }
+
+    // Still due: the send failed or we are detached, so try again at retry_at
+    if (batch_send_reason()) {
+      deadline_min(next, retry_at);
+    } else if (g_batch_len > 0) {
+      deadline_min(next, g_batch[0].t_ms + BATCH_MAX_AGE_MS);
+    }
+  }
+
+  // --- 5. PERIODIC RADIO REPORT ---
+  static uint32_t last_report = 0;
+  if (now - last_report >= STATS_PERIOD_MS) {
+    last_report = now;
+    print_tx_stats();
+    print_duty_stats();
+  }
+  deadline_min(next, last_report + STATS_PERIOD_MS);
+
+  sleep_until(next);
+}
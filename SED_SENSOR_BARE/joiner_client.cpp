@@ -0,0 +1,174 @@
+#include "joiner_client.h"
+#include <Preferences.h>
+#include "openthread/joiner.h"
+#include "openthread/link.h"
+#include "openthread/thread.h"
+
+#define NS_JOIN "sed_join"
+
+static JoinStats stats = {};
+static JoinerClientState state = JOINER_CLIENT_IDLE;
+static const char* pskd_ = nullptr;
+static uint32_t firstAttemptMs = 0;
+static uint32_t nextAttemptMs = 0;
+static bool narrowAttempt = false;   // current attempt scans the cached channel only
+static uint16_t backoffStep = 0;     // failed full-mask attempts in a row
+
+// Set on the OpenThread task, consumed by joinerClientPoll()
+static volatile bool resultPending = false;
+static volatile otError result = OT_ERROR_NONE;
+
+static void onJoinerResult(otError error, void* context) {
+    result = error;
+    resultPending = true;
+}
+
+void joinerClientBegin(otInstance* inst) {
+    Preferences prefs;
+    prefs.begin(NS_JOIN, true);
+    stats.cached = prefs.isKey("ch");
+    stats.channel = prefs.getUChar("ch", 0);
+    stats.panId = prefs.getUShort("pan", 0xFFFF);
+    prefs.getBytes("xpan", stats.extPanId, sizeof(stats.extPanId));
+    stats.joins = prefs.getULong("joins", 0);
+    stats.lastJoinMs = prefs.getULong("join_ms", 0);
+    stats.lastAttempts = prefs.getUShort("join_tries", 0);
+    stats.lastAttachMs = prefs.getULong("attach_ms", 0);
+    prefs.end();
+
+    // A cached channel outside the mask (corrupt, or another band) is ignored;
+    // the range check comes first so the shift stays within 32 bits
+    if (stats.cached && (stats.channel < JOIN_CHANNEL_MIN || stats.channel > JOIN_CHANNEL_MAX ||
+                         !(JOIN_CHANNEL_MASK & (1u << stats.channel)))) {
+        stats.cached = false;
+    }
+}
+
+// Only writes when the network changed, to spare the flash
+static void saveNetwork(otInstance* inst) {
+    uint8_t channel = otLinkGetChannel(inst);
+    uint16_t panId = otLinkGetPanId(inst);
+    const otExtendedPanId* xpan = otThreadGetExtendedPanId(inst);
+
+    if (stats.cached && channel == stats.channel && panId == stats.panId &&
+        memcmp(xpan->m8, stats.extPanId, sizeof(stats.extPanId)) == 0) {
+        return;
+    }
+
+    Preferences prefs;
+    prefs.begin(NS_JOIN, false);
+    prefs.putUChar("ch", channel);
+    prefs.putUShort("pan", panId);
+    prefs.putBytes("xpan", xpan->m8, sizeof(xpan->m8));
+    prefs.end();
+
+    stats.cached = true;
+    stats.channel = channel;
+    stats.panId = panId;
+    memcpy(stats.extPanId, xpan->m8, sizeof(stats.extPanId));
+    Serial.printf("[JOINER] Cached network: channel %u, PAN 0x%04X\n", channel, panId);
+}
+
+static void startAttempt(otInstance* inst) {
+    // The cached channel first; a full scan for every attempt after that
+    narrowAttempt = stats.cached && stats.attempts == 0;
+    otLinkSetSupportedChannelMask(inst, narrowAttempt ? (1u << stats.channel) : JOIN_CHANNEL_MASK);
+    if (narrowAttempt) otLinkSetChannel(inst, stats.channel);
+
+    otJoinerStop(inst);
+    stats.attempts++;
+    state = JOINER_CLIENT_JOINING;
+
+    otError err = otJoinerStart(inst, pskd_, NULL, "MyVendor", "MySensor", "1.0.0", NULL,
+                                onJoinerResult, NULL);
+    if (err != OT_ERROR_NONE) {
+        Serial.printf("[JOINER] WARNING: Joiner failed to initialize! Error: %d\n", err);
+        onJoinerResult(err, NULL);
+    } else if (narrowAttempt) {
+        Serial.printf("[JOINER] Attempt %u: scanning cached channel %u...\n", stats.attempts,
+                      stats.channel);
+    } else {
+        Serial.printf("[JOINER] Attempt %u: scanning channels 11-26...\n", stats.attempts);
+    }
+}
+
+// JOIN_RETRY_MIN_MS << step, capped, with jitter
+static uint32_t backoffMs(uint16_t step) {
+    uint32_t delayMs = JOIN_RETRY_MIN_MS;
+    while (step-- > 0 && delayMs < JOIN_RETRY_MAX_MS) delayMs *= 2;
+    if (delayMs > JOIN_RETRY_MAX_MS) delayMs = JOIN_RETRY_MAX_MS;
+
+    int32_t jitter = (int32_t)(delayMs / 100 * JOIN_RETRY_JITTER_PCT);
+    return delayMs + random(-jitter, jitter + 1);
+}
+
+void joinerClientStart(otInstance* inst, const char* pskd) {
+    pskd_ = pskd;
+    stats.attempts = 0;
+    backoffStep = 0;
+    firstAttemptMs = millis();
+    startAttempt(inst);
+}
+
+static void recordJoin(otInstance* inst) {
+    stats.joins++;
+    stats.lastJoinMs = millis() - firstAttemptMs;
+    stats.lastAttempts = stats.attempts;
+
+    Preferences prefs;
+    prefs.begin(NS_JOIN, false);
+    prefs.putULong("joins", stats.joins);
+    prefs.putULong("join_ms", stats.lastJoinMs);
+    prefs.putUShort("join_tries", stats.lastAttempts);
+    prefs.end();
+    saveNetwork(inst);
+
+    Serial.printf("[JOINER] Joined after %u attempt(s), %lu ms\n", stats.lastAttempts,
+                  (unsigned long)stats.lastJoinMs);
+}
+
+JoinerClientState joinerClientPoll(otInstance* inst) {
+    if (resultPending) {
+        resultPending = false;
+        otError err = result;
+
+        if (err == OT_ERROR_NONE) {
+            recordJoin(inst);
+            state = JOINER_CLIENT_JOINED;
+        } else if (err == OT_ERROR_SECURITY) {
+            Serial.println("[JOINER] FATAL: Security rejected, PSKd mismatch. STOPPING.");
+            state = JOINER_CLIENT_FAILED;
+        } else {
+            // A miss on the cached channel goes straight on to a full scan
+            uint32_t waitMs = narrowAttempt ? 0 : backoffMs(backoffStep++);
+            nextAttemptMs = millis() + waitMs;
+            state = JOINER_CLIENT_WAITING;
+            Serial.printf("[JOINER] Attempt %u failed (error %d%s), retrying in %lu ms\n",
+                          stats.attempts, err,
+                          err == OT_ERROR_NOT_FOUND ? ": no joinable network" : "",
+                          (unsigned long)waitMs);
+        }
+    }
+
+    if (state == JOINER_CLIENT_WAITING && (int32_t)(millis() - nextAttemptMs) >= 0) {
+        startAttempt(inst);
+    }
+    return state;
+}
+
+uint32_t joinerClientNextAttemptAt() {
+    return nextAttemptMs;
+}
+
+void joinerClientAttached(otInstance* inst, uint32_t sinceBootMs) {
+    stats.lastAttachMs = sinceBootMs;
+    Preferences prefs;
+    prefs.begin(NS_JOIN, false);
+    prefs.putULong("attach_ms", sinceBootMs);
+    prefs.end();
+    saveNetwork(inst);
+}
+
+JoinStats joinerClientGetStats() {
+    return stats;
+}
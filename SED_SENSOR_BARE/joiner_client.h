@@ -0,0 +1,65 @@
+#ifndef JOINER_CLIENT_H
+#define JOINER_CLIENT_H
+
+#include <Arduino.h>
+#include "openthread/instance.h"
+
+// Thread joiner of the SED, for when it has no network credentials.
+//
+// The first attempt scans only the channel of the last network joined,
+// cached in NVS (namespace "sed_join"), so a sensor that lost its
+// credentials finds the network again in one channel's discovery. Later
+// attempts, and the first one without a cache, scan JOIN_CHANNEL_MASK.
+// Failed attempts are retried after JOIN_RETRY_MIN_MS, doubling up to
+// JOIN_RETRY_MAX_MS, each +/- JOIN_RETRY_JITTER_PCT so sensors powered up
+// together spread out. A rejected PSKd stops the joiner for good.
+//
+// The cache is refreshed whenever the sensor joins or attaches, so it
+// follows a network that moved. All functions must be called with the OT
+// lock held.
+
+#define JOIN_CHANNEL_MIN      11
+#define JOIN_CHANNEL_MAX      26
+#define JOIN_CHANNEL_MASK     0x07FFF800u   // 2.4 GHz channels 11-26
+#define JOIN_RETRY_MIN_MS     5000
+#define JOIN_RETRY_MAX_MS     600000
+#define JOIN_RETRY_JITTER_PCT 25
+
+enum JoinerClientState : uint8_t {
+    JOINER_CLIENT_IDLE,
+    JOINER_CLIENT_JOINING,    // attempt in progress
+    JOINER_CLIENT_WAITING,    // backing off until joinerClientNextAttemptAt()
+    JOINER_CLIENT_JOINED,     // credentials saved; restart to attach
+    JOINER_CLIENT_FAILED,     // PSKd rejected
+};
+
+struct JoinStats {
+    bool     cached;          // a previous network is known
+    uint8_t  channel;
+    uint16_t panId;
+    uint8_t  extPanId[8];
+    uint32_t joins;           // successful joins, all time
+    uint32_t lastJoinMs;      // first attempt -> joined, last join
+    uint16_t lastAttempts;    // attempts the last join took
+    uint32_t lastAttachMs;    // boot -> attached as child, last boot with credentials
+    uint16_t attempts;        // this boot
+};
+
+// Load the cache; call once before anything else
+void joinerClientBegin(otInstance* inst);
+
+// Start joining with pskd and keep retrying from joinerClientPoll()
+void joinerClientStart(otInstance* inst, const char* pskd);
+
+// Starts due retries; call from loop()
+JoinerClientState joinerClientPoll(otInstance* inst);
+
+// millis() deadline of the next retry while WAITING
+uint32_t joinerClientNextAttemptAt();
+
+// The sensor attached with stored credentials, sinceBootMs after boot
+void joinerClientAttached(otInstance* inst, uint32_t sinceBootMs);
+
+JoinStats joinerClientGetStats();
+
+#endif
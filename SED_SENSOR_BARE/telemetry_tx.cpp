@@ -0,0 +1,141 @@
+#include "telemetry_tx.h"
+#include "esp_timer.h"
+#include "openthread/ip6.h"
+#include "openthread/message.h"
+
+#include <hvac_report_policy.h>
+
+static otUdpSocket socket_;
+static bool socketOpen = false;
+static TelemetryTxReceiveFn receiveFn = nullptr;
+static TelemetryTxStats stats = {};
+
+// Allocated ahead of the send that uses it; owned here until otUdpSend()
+// accepts it, and freed on every failure path
+static otMessage* spare = nullptr;
+
+// Commissioner address, from the last datagram it sent us
+static otIp6Address peer;
+static bool peerKnown = false;
+static uint32_t peerHeardMs = 0;
+
+// Attempts of the datagram in progress, when the first one was made, and
+// how many times it has failed since
+static uint8_t attempts = 0;
+static uint8_t failures = 0;
+static int64_t firstAttemptUs = 0;
+static uint32_t retryAtMs = 0;
+
+// OpenThread task, lock held
+static void onDatagram(void* context, otMessage* message, const otMessageInfo* info) {
+    uint8_t buf[HVAC_REPORT_CFG_MAX_LEN];
+    uint16_t len = otMessageRead(message, otMessageGetOffset(message), buf, sizeof(buf));
+
+    if (info->mPeerPort == TELEMETRY_TX_DEST_PORT) {
+        peer = info->mPeerAddr;
+        peerKnown = true;
+        peerHeardMs = millis();
+        stats.received++;
+    }
+    if (receiveFn) receiveFn(buf, len);
+}
+
+static otMessage* takeMessage(otInstance* inst) {
+    otMessage* msg = spare;
+    spare = nullptr;
+    return msg ? msg : otUdpNewMessage(inst, nullptr);
+}
+
+bool telemetryTxBegin(otInstance* inst, TelemetryTxReceiveFn onReceive) {
+    receiveFn = onReceive;
+    if (socketOpen) return true;
+
+    memset(&socket_, 0, sizeof(socket_));
+    otSockAddr bindAddr;
+    memset(&bindAddr, 0, sizeof(bindAddr));
+    bindAddr.mPort = HVAC_REPORT_CFG_PORT;
+
+    otError err = otUdpOpen(inst, &socket_, onDatagram, nullptr);
+    if (err != OT_ERROR_NONE) {
+        Serial.printf("[UDP] Cannot open socket: %d\n", err);
+        return false;
+    }
+    err = otUdpBind(inst, &socket_, &bindAddr, OT_NETIF_UNSPECIFIED);
+    if (err != OT_ERROR_NONE) {
+        Serial.printf("[UDP] Cannot bind port %d: %d\n", HVAC_REPORT_CFG_PORT, err);
+        otUdpClose(inst, &socket_);
+        return false;
+    }
+
+    socketOpen = true;
+    spare = otUdpNewMessage(inst, nullptr);
+    return true;
+}
+
+bool telemetryTxUnicast() {
+    return TELEMETRY_TX_UNICAST && peerKnown && millis() - peerHeardMs < TELEMETRY_TX_PEER_TTL_MS;
+}
+
+TelemetryTxResult telemetryTxSend(otInstance* inst, const uint8_t* data, size_t len) {
+    if (!socketOpen) {
+        retryAtMs = millis() + TELEMETRY_TX_FAIL_BACKOFF_MS;
+        return TELEMETRY_TX_FAILED;
+    }
+    if (attempts == 0) firstAttemptUs = esp_timer_get_time();
+    if (attempts < UINT8_MAX) attempts++;
+
+    otMessageInfo info;
+    memset(&info, 0, sizeof(info));
+    info.mPeerPort = TELEMETRY_TX_DEST_PORT;
+    bool unicast = telemetryTxUnicast();
+    if (unicast) {
+        info.mPeerAddr = peer;
+    } else {
+        otIp6AddressFromString(TELEMETRY_TX_MULTICAST, &info.mPeerAddr);
+    }
+
+    otMessage* msg = takeMessage(inst);
+    otError err = msg ? otMessageAppend(msg, data, (uint16_t)len) : OT_ERROR_NO_BUFS;
+    if (err == OT_ERROR_NONE) err = otUdpSend(inst, &socket_, msg, &info);
+    if (err != OT_ERROR_NONE && msg) otMessageFree(msg);
+
+    if (err == OT_ERROR_NONE) {
+        uint32_t latency = (uint32_t)(esp_timer_get_time() - firstAttemptUs);
+        stats.sent++;
+        if (unicast) stats.unicast++;
+        stats.latencySumUs += latency;
+        if (latency > stats.latencyMaxUs) stats.latencyMaxUs = latency;
+        attempts = 0;
+        failures = 0;
+        if (!spare) spare = otUdpNewMessage(inst, nullptr);
+        return TELEMETRY_TX_SENT;
+    }
+
+    if (err == OT_ERROR_NO_BUFS) {
+        stats.noBufs++;
+        if (attempts <= TELEMETRY_TX_RETRIES) {
+            retryAtMs = millis() + ((uint32_t)TELEMETRY_TX_BACKOFF_MS << (attempts - 1));
+            return TELEMETRY_TX_RETRY;
+        }
+    }
+    if (failures == 0) {
+        Serial.printf("[UDP] Send failed: %d after %u attempt(s)\n", err, attempts);
+        stats.failed++;
+    }
+    uint32_t backoff = TELEMETRY_TX_FAIL_BACKOFF_MS;
+    for (uint8_t i = 0; i < failures && backoff < TELEMETRY_TX_FAIL_BACKOFF_MAX_MS; i++) backoff *= 2;
+    if (backoff > TELEMETRY_TX_FAIL_BACKOFF_MAX_MS) backoff = TELEMETRY_TX_FAIL_BACKOFF_MAX_MS;
+    if (failures < UINT8_MAX) failures++;
+    retryAtMs = millis() + backoff;
+    return TELEMETRY_TX_FAILED;
+}
+
+uint32_t telemetryTxRetryAt() {
+    return retryAtMs;
+}
+
+TelemetryTxStats telemetryTxGetStats(bool reset) {
+    TelemetryTxStats out = stats;
+    if (reset) stats = {};
+    return out;
+}
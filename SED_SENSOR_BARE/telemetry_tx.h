@@ -0,0 +1,68 @@
+#ifndef TELEMETRY_TX_H
+#define TELEMETRY_TX_H
+
+#include <Arduino.h>
+#include "openthread/instance.h"
+#include "openthread/udp.h"
+
+// Telemetry transport of the SED. One socket, opened once and bound to
+// HVAC_REPORT_CFG_PORT, sends every report and receives what the
+// Commissioner sends back (report config). Reports go to ff03::2 until the
+// Commissioner has sent us anything, then by unicast to the address it sent
+// from, so the other routers no longer process each report. The address
+// expires after TELEMETRY_TX_PEER_TTL_MS without hearing from it; the next
+// multicast report makes the Commissioner answer again.
+//
+// A message is kept allocated for the next send. When the stack is out of
+// buffers the send is retried TELEMETRY_TX_RETRIES times with exponential
+// backoff; the caller keeps its data and calls again at
+// telemetryTxRetryAt(). A datagram that still does not go out, or that the
+// stack refuses, is counted as failed once; each further attempt waits
+// twice as long, from TELEMETRY_TX_FAIL_BACKOFF_MS up to
+// TELEMETRY_TX_FAIL_BACKOFF_MAX_MS, until a send succeeds. All functions
+// except telemetryTxGetStats() must be called with the OT lock held.
+
+#define TELEMETRY_TX_DEST_PORT   1234        // Commissioner's listener
+#define TELEMETRY_TX_MULTICAST   "ff03::2"   // Realm-Local All-Routers
+#define TELEMETRY_TX_RETRIES     4
+#define TELEMETRY_TX_BACKOFF_MS  50          // doubled on each retry
+#define TELEMETRY_TX_FAIL_BACKOFF_MS     2000
+#define TELEMETRY_TX_FAIL_BACKOFF_MAX_MS 60000
+#define TELEMETRY_TX_PEER_TTL_MS 3600000
+
+#ifndef TELEMETRY_TX_UNICAST
+#define TELEMETRY_TX_UNICAST 1   // 0: always multicast
+#endif
+
+enum TelemetryTxResult : uint8_t {
+    TELEMETRY_TX_SENT,
+    TELEMETRY_TX_RETRY,    // out of buffers, call again at telemetryTxRetryAt()
+    TELEMETRY_TX_FAILED,   // retries used up or refused, call again at telemetryTxRetryAt()
+};
+
+struct TelemetryTxStats {
+    uint32_t sent;
+    uint32_t unicast;        // of sent, to the Commissioner's address
+    uint32_t noBufs;         // attempts refused for lack of message buffers
+    uint32_t failed;         // datagrams that used up their retries, counted once each
+    uint32_t received;       // datagrams from the Commissioner
+    uint32_t latencyMaxUs;   // first attempt -> taken by the stack
+    uint64_t latencySumUs;   // over sent
+};
+
+// Payload of a datagram received on the socket (OpenThread task, lock held)
+typedef void (*TelemetryTxReceiveFn)(const uint8_t* data, size_t len);
+
+bool telemetryTxBegin(otInstance* inst, TelemetryTxReceiveFn onReceive);
+
+TelemetryTxResult telemetryTxSend(otInstance* inst, const uint8_t* data, size_t len);
+
+// millis() deadline for the next attempt after TELEMETRY_TX_RETRY or
+// TELEMETRY_TX_FAILED
+uint32_t telemetryTxRetryAt();
+
+bool telemetryTxUnicast();
+
+TelemetryTxStats telemetryTxGetStats(bool reset);
+
+#endif
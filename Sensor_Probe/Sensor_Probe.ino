@@ -9,6 +9,7 @@ N/*
 #include <RTClib.h>
 #include <SdFat.h>
 #include <SPI.h>
+#include <hvac_log_record.h>
 
 #define DHT_TYPE DHT22
 #define ONE_WIRE_BUS 2
@@ -22,8 +23,10 @@ N/*
 
 SdExFat sd;
 ExFile logFile;                      // ← File32 for SdFat Adafruit Fork
-const char* logFileName = "/log.csv";
+const char* logFileName = "/log.bin";
 bool sdCardAvailable = false;
+#define PROBE_SENSOR_ID 2
+uint16_t logSeq = 0;
 
 OneWire oneWire(ONE_WIRE_BUS);
 DallasTemperature sensors(&oneWire);
@@ -122,14 +125,7 @@ void initializeSdFat() {
                       sckPins[p], mosiPins[p], speeds[s]);
         sdCardAvailable = true;
 
-        if (!sd.exists(logFileName)) {
-          logFile = sd.open(logFileName, O_WRITE | O_CREAT);
-          if (logFile) {
-            // Replace old header line with:
-            logFile.println("DateTime,DS1_C,DS1_F,DS2_C,DS2_F,DHT_C,DHT_F,DHT_H%,RTC_C,RTC_F");
-            logFile.close();
-          }
-        }
+        openBinaryLog();
         Serial.println("Log ready");
         return;  // Stop trying once found!
       }
@@ -144,26 +140,63 @@ void initializeSdFat() {
 }
 
 
+// ─── BINARY LOG (hvac_log_record.h) ──────────────────────
+// Validate an existing log and cut a tail torn by a power loss, or create
+// a new file with a header describing the channels.
+void openBinaryLog() {
+  if (sd.exists(logFileName)) {
+    logFile = sd.open(logFileName, O_RDWR);
+    LogFileHeader h;
+    if (logFile && logFile.read(&h, sizeof(h)) == (int)sizeof(h) && log_header_valid(&h)) {
+      uint32_t n = log_recover_tail(logFile);
+      logFile.close();
+      Serial.printf("✓ Log has %lu records\n", (unsigned long)n);
+      return;
+    }
+    if (logFile) logFile.close();
+    Serial.println("⚠ Bad log header, moved to /log.bin.bad");
+    sd.remove("/log.bin.bad");
+    sd.rename(logFileName, "/log.bin.bad");
+  }
+
+  LogFileHeader h;
+  log_header_init(&h, PROBE_SENSOR_ID, rtcAvailable ? rtc.now().unixtime() : 0);
+  log_header_add_channel(&h, "DS1_C", 100);
+  log_header_add_channel(&h, "DS2_C", 100);
+  log_header_add_channel(&h, "DHT_C", 100);
+  log_header_add_channel(&h, "DHT_H", 10);
+  log_header_add_channel(&h, "RTC_C", 100);
+  log_header_seal(&h);
+
+  logFile = sd.open(logFileName, O_WRITE | O_CREAT);
+  if (logFile) {
+    logFile.write(&h, sizeof(h));
+    logFile.close();
+  }
+}
+
 // ─── READ & LOG ───────────────────────────────────────────
 void readAndLog() {
   sensors.requestTemperatures();
 
-  // DS18B20 - Celsius
-  float ds1C = numberOfDevices >= 1 ? sensors.getTempC(sensor1Address) : -127;
-  float ds2C = numberOfDevices >= 2 ? sensors.getTempC(sensor2Address) : -127;
-  
-  // DS18B20 - Fahrenheit (convert or read directly)
-  float ds1F = numberOfDevices >= 1 ? sensors.getTempF(sensor1Address) : -196.6;
-  float ds2F = numberOfDevices >= 2 ? sensors.getTempF(sensor2Address) : -196.6;
+  // DS18B20 - Celsius; NAN when the probe is absent or did not answer
+  float ds1C = numberOfDevices >= 1 ? sensors.getTempC(sensor1Address) : NAN;
+  float ds2C = numberOfDevices >= 2 ? sensors.getTempC(sensor2Address) : NAN;
+  if (ds1C == DEVICE_DISCONNECTED_C) ds1C = NAN;
+  if (ds2C == DEVICE_DISCONNECTED_C) ds2C = NAN;
 
   // DHT22
   float dhtC = dht.readTemperature();        // Celsius
-  float dhtF = dht.readTemperature(true);    // Fahrenheit (pass true!)
   float dhtH = dht.readHumidity();
 
   // RTC
-  float rtcC = rtcAvailable ? rtc.getTemperature() : 0;
-  float rtcF = (rtcC * 9.0 / 5.0) + 32.0;  // Convert
+  float rtcC = rtcAvailable ? rtc.getTemperature() : NAN;
+
+  // Fahrenheit for the console only; the log keeps Celsius
+  float ds1F = ds1C * 9.0 / 5.0 + 32.0;
+  float ds2F = ds2C * 9.0 / 5.0 + 32.0;
+  float dhtF = dhtC * 9.0 / 5.0 + 32.0;
+  float rtcF = rtcC * 9.0 / 5.0 + 32.0;
 
   String timeStr = rtcAvailable ? rtc.now().timestamp() : String(millis() / 1000) + "s";
 
@@ -175,17 +208,25 @@ void readAndLog() {
   Serial.printf("DHT  : %.2f°C / %.2f°F  Hum: %.1f%%\n", dhtC, dhtF, dhtH);
   Serial.printf("RTC  : %.2f°C / %.2f°F\n", rtcC, rtcF);
 
-  // SD log
+  // SD log — one fixed-size record. A channel without a reading is stored as
+  // LOG_CH_MISSING; log_export adds the _F column for every _C channel.
   if (sdCardAvailable) {
+    LogRecord rec = {};
+    rec.epoch        = rtcAvailable ? rtc.now().unixtime() : millis() / 1000;
+    rec.sensorId     = PROBE_SENSOR_ID;
+    rec.seq          = logSeq++;
+    rec.flags        = rtcAvailable ? 0 : LOG_FLAG_UPTIME;
+    rec.channelCount = 5;
+    rec.ch[0]        = log_quantize(ds1C, 100);
+    rec.ch[1]        = log_quantize(ds2C, 100);
+    rec.ch[2]        = log_quantize(dhtC, 100);
+    rec.ch[3]        = log_quantize(dhtH, 10);
+    rec.ch[4]        = log_quantize(rtcC, 100);
+    log_record_seal(&rec);
+
     logFile = sd.open(logFileName, O_WRITE | O_APPEND | O_CREAT);
     if (logFile) {
-      logFile.printf("%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%.2f,%.2f\n",
-        timeStr.c_str(),
-        ds1C, ds1F,
-        ds2C, ds2F,
-        dhtC, dhtF,
-        dhtH,
-        rtcC, rtcF);
+      logFile.write(&rec, sizeof(rec));
       logFile.close();
       Serial.println("Logged ✓");
     } else {
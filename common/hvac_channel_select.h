@@ -0,0 +1,218 @@
+#pragma once
+
+/**
+ * @brief Channel and PAN selection for forming a Thread network, from an
+ *        energy scan and an active scan of the 2.4 GHz channels.
+ *
+ * Each channel costs its noise floor (max RSSI of the energy scan, dBm)
+ * plus HVAC_CHAN_PAN_PENALTY_DB for every 802.15.4 network the active scan
+ * heard on it. Channels within HVAC_CHAN_TIE_DB of the cheapest are equally
+ * good, as the energy scan is a single sample of bursty traffic; among them
+ * the one with the quietest neighbours wins (Wi-Fi is 4-5 channels wide, so
+ * a hot neighbour is an AP the sample may have missed), then one of
+ * 15/20/25/26, which sit between Wi-Fi channels 1/6/11, then the lowest.
+ *
+ * The PAN ID and extended PAN ID are drawn at random until neither matches
+ * a network heard on any channel.
+ *
+ * The survey is filled from the OpenThread scan callbacks, e.g.
+ *
+ *   hvac_chan_note_energy(&s, r->mChannel, r->mMaxRssi);
+ *   hvac_chan_note_network(&s, r->mChannel, r->mPanId, r->mExtendedPanId.m8, r->mRssi);
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define HVAC_CHAN_MIN           11
+#define HVAC_CHAN_MAX           26
+#define HVAC_CHAN_COUNT         (HVAC_CHAN_MAX - HVAC_CHAN_MIN + 1)
+#define HVAC_CHAN_ALL_MASK      0x07FFF800u   // bit n = channel n
+#define HVAC_CHAN_DEFAULT       15            // when nothing could be measured
+#define HVAC_CHAN_MAX_NETWORKS  16            // networks remembered for collision checks
+
+#define HVAC_CHAN_UNMEASURED     127
+#define HVAC_CHAN_PAN_PENALTY_DB 10
+#define HVAC_CHAN_TIE_DB         6
+#define HVAC_CHAN_NO_COST        INT16_MAX
+
+typedef struct {
+    uint8_t  channel;
+    int8_t   rssi;            // strongest beacon heard
+    uint16_t pan_id;
+    uint8_t  ext_pan_id[8];
+} hvac_chan_network_t;
+
+typedef struct {
+    uint32_t mask;                                 // channels that may be chosen
+    int8_t   energy[HVAC_CHAN_COUNT];              // dBm, or HVAC_CHAN_UNMEASURED
+    uint8_t  networks_on[HVAC_CHAN_COUNT];
+    uint8_t  network_count;                        // in network[]
+    uint16_t networks_dropped;                     // heard once network[] was full
+    hvac_chan_network_t network[HVAC_CHAN_MAX_NETWORKS];
+} hvac_chan_survey_t;
+
+static inline bool hvac_chan_valid(uint8_t channel)
+{
+    return channel >= HVAC_CHAN_MIN && channel <= HVAC_CHAN_MAX;
+}
+
+static inline void hvac_chan_survey_init(hvac_chan_survey_t *s, uint32_t mask)
+{
+    memset(s, 0, sizeof(*s));
+    s->mask = mask & HVAC_CHAN_ALL_MASK;
+    memset(s->energy, HVAC_CHAN_UNMEASURED, sizeof(s->energy));
+}
+
+/** Keeps the highest reading if a channel is reported more than once. */
+static inline void hvac_chan_note_energy(hvac_chan_survey_t *s, uint8_t channel, int8_t max_rssi)
+{
+    if (!hvac_chan_valid(channel) || max_rssi == HVAC_CHAN_UNMEASURED) return;
+    int8_t *e = &s->energy[channel - HVAC_CHAN_MIN];
+    if (*e == HVAC_CHAN_UNMEASURED || max_rssi > *e) *e = max_rssi;
+}
+
+/** One active scan result; every router of a network answers, so repeats are merged. */
+static inline void hvac_chan_note_network(hvac_chan_survey_t *s, uint8_t channel, uint16_t pan_id,
+                                          const uint8_t ext_pan_id[8], int8_t rssi)
+{
+    if (!hvac_chan_valid(channel)) return;
+    for (uint8_t i = 0; i < s->network_count; i++) {
+        hvac_chan_network_t *n = &s->network[i];
+        if (n->channel == channel && n->pan_id == pan_id &&
+            memcmp(n->ext_pan_id, ext_pan_id, 8) == 0) {
+            if (rssi > n->rssi) n->rssi = rssi;
+            return;
+        }
+    }
+
+    s->networks_on[channel - HVAC_CHAN_MIN]++;
+    if (s->network_count == HVAC_CHAN_MAX_NETWORKS) {
+        s->networks_dropped++;
+        return;
+    }
+    hvac_chan_network_t *n = &s->network[s->network_count++];
+    n->channel = channel;
+    n->rssi = rssi;
+    n->pan_id = pan_id;
+    memcpy(n->ext_pan_id, ext_pan_id, 8);
+}
+
+static inline bool hvac_chan_any_energy(const hvac_chan_survey_t *s)
+{
+    for (int i = 0; i < HVAC_CHAN_COUNT; i++) {
+        if ((s->mask >> (HVAC_CHAN_MIN + i) & 1u) && s->energy[i] != HVAC_CHAN_UNMEASURED) return true;
+    }
+    return false;
+}
+
+/**
+ * @return Cost in dB of forming on channel, or HVAC_CHAN_NO_COST if it is
+ *         outside the mask, or unmeasured while other channels were measured.
+ *         With no energy readings at all only the networks count.
+ */
+static inline int16_t hvac_chan_cost(const hvac_chan_survey_t *s, uint8_t channel)
+{
+    if (!hvac_chan_valid(channel) || !(s->mask >> channel & 1u)) return HVAC_CHAN_NO_COST;
+    int8_t e = s->energy[channel - HVAC_CHAN_MIN];
+    if (e == HVAC_CHAN_UNMEASURED) {
+        if (hvac_chan_any_energy(s)) return HVAC_CHAN_NO_COST;
+        e = 0;
+    }
+    return (int16_t)(e + HVAC_CHAN_PAN_PENALTY_DB * s->networks_on[channel - HVAC_CHAN_MIN]);
+}
+
+/**
+ * Energy of the adjacent channels above the quietest measured one, in dB,
+ * not counting the first HVAC_CHAN_TIE_DB of each (scan jitter).
+ */
+static inline int16_t hvac_chan_neighbour_excess(const hvac_chan_survey_t *s, uint8_t channel)
+{
+    int8_t floor_dbm = HVAC_CHAN_UNMEASURED;
+    for (int i = 0; i < HVAC_CHAN_COUNT; i++) {
+        if (s->energy[i] < floor_dbm) floor_dbm = s->energy[i];
+    }
+    if (floor_dbm == HVAC_CHAN_UNMEASURED) return 0;
+
+    int16_t excess = 0;
+    for (int d = -1; d <= 1; d += 2) {
+        int c = channel + d;
+        if (c < HVAC_CHAN_MIN || c > HVAC_CHAN_MAX) continue;
+        int8_t e = s->energy[c - HVAC_CHAN_MIN];
+        if (e != HVAC_CHAN_UNMEASURED && e - floor_dbm > HVAC_CHAN_TIE_DB) {
+            excess += e - floor_dbm - HVAC_CHAN_TIE_DB;
+        }
+    }
+    return excess;
+}
+
+static inline bool hvac_chan_between_wifi(uint8_t channel)
+{
+    return channel == 15 || channel == 20 || channel == 25 || channel == 26;
+}
+
+/** @return The channel to form on; HVAC_CHAN_DEFAULT if the mask allows none. */
+static inline uint8_t hvac_chan_select(const hvac_chan_survey_t *s)
+{
+    int16_t best_cost = HVAC_CHAN_NO_COST;
+    for (uint8_t c = HVAC_CHAN_MIN; c <= HVAC_CHAN_MAX; c++) {
+        int16_t cost = hvac_chan_cost(s, c);
+        if (cost < best_cost) best_cost = cost;
+    }
+    if (best_cost == HVAC_CHAN_NO_COST) return HVAC_CHAN_DEFAULT;
+
+    uint8_t best = 0;
+    int16_t best_excess = 0;
+    for (uint8_t c = HVAC_CHAN_MIN; c <= HVAC_CHAN_MAX; c++) {
+        int16_t cost = hvac_chan_cost(s, c);
+        if (cost == HVAC_CHAN_NO_COST || cost > best_cost + HVAC_CHAN_TIE_DB) continue;
+
+        int16_t excess = hvac_chan_neighbour_excess(s, c);
+        if (!best || excess < best_excess ||
+            (excess == best_excess && hvac_chan_between_wifi(c) && !hvac_chan_between_wifi(best))) {
+            best = c;
+            best_excess = excess;
+        }
+    }
+    return best;
+}
+
+static inline bool hvac_chan_pan_in_use(const hvac_chan_survey_t *s, uint16_t pan_id)
+{
+    for (uint8_t i = 0; i < s->network_count; i++) {
+        if (s->network[i].pan_id == pan_id) return true;
+    }
+    return false;
+}
+
+static inline bool hvac_chan_ext_pan_in_use(const hvac_chan_survey_t *s, const uint8_t ext_pan_id[8])
+{
+    for (uint8_t i = 0; i < s->network_count; i++) {
+        if (memcmp(s->network[i].ext_pan_id, ext_pan_id, 8) == 0) return true;
+    }
+    return false;
+}
+
+/** A random PAN ID no network heard uses; never 0xFFFF (broadcast). */
+static inline uint16_t hvac_chan_pick_pan(const hvac_chan_survey_t *s, uint32_t (*rng)(void))
+{
+    uint16_t pan;
+    do {
+        pan = (uint16_t)rng();
+    } while (pan == 0xFFFF || hvac_chan_pan_in_use(s, pan));
+    return pan;
+}
+
+/** A random extended PAN ID no network heard uses. */
+static inline void hvac_chan_pick_ext_pan(const hvac_chan_survey_t *s, uint32_t (*rng)(void),
+                                          uint8_t out[8])
+{
+    do {
+        uint32_t hi = rng(), lo = rng();
+        for (int i = 0; i < 4; i++) {
+            out[i] = (uint8_t)(hi >> (24 - 8 * i));
+            out[4 + i] = (uint8_t)(lo >> (24 - 8 * i));
+        }
+    } while (hvac_chan_ext_pan_in_use(s, out));
+}
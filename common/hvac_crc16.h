@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) used by the SD log
+ *        format and the Bridge <-> Commissioner link frames.
+ *
+ * Bitwise rather than table-driven: inputs are a few dozen bytes and the
+ * 512-byte table would cost more flash than it saves cycles.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HVAC_CRC16_INIT 0xFFFFu
+
+static inline uint16_t hvac_crc16_update(uint16_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline uint16_t hvac_crc16(const void *data, size_t len)
+{
+    return hvac_crc16_update(HVAC_CRC16_INIT, data, len);
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+/**
+ * @brief Framed Bridge <-> Commissioner UART protocol.
+ *
+ * Wire format (little-endian):
+ *
+ *   0xA5 0x5A | type | id | len_lo len_hi | payload[len] | crc_lo crc_hi
+ *
+ * The CRC-16/CCITT covers type..payload. The two sync bytes are not valid
+ * ASCII, so frames can share the wire with the Commissioner's ESP_LOG
+ * console output: the decoder hands every byte outside a frame back to the
+ * caller as plain text, and log text can never be taken for a result.
+ * This holds only if each frame reaches the wire in one piece: the sender
+ * must keep other console writers off the port while it writes a frame
+ * (the Commissioner holds the stdout lock, see link_send_frame()).
+ *
+ * Requests carry a non-zero id chosen by the sender. The answer (RSP_OK /
+ * RSP_ERR) echoes that id, so several requests can be in flight at once.
+ * Unsolicited EVENT frames use id 0.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "hvac_crc16.h"
+
+#define LINK_SOF0             0xA5
+#define LINK_SOF1             0x5A
+#define LINK_MAX_PAYLOAD      480
+#define LINK_FRAME_OVERHEAD   8      // sync(2) + type + id + len(2) + crc(2)
+#define LINK_MAX_FRAME        (LINK_MAX_PAYLOAD + LINK_FRAME_OVERHEAD)
+#define LINK_DEFAULT_BAUD     115200
+
+// Single-device ADDs the Commissioner tracks at once. Sizes its joiner table
+// (JOINER_TABLE_SIZE) and the Bridge's pending adds (BRIDGE_MAX_PENDING_ADDS).
+#define LINK_MAX_JOINERS      8
+
+typedef enum {
+    LINK_MSG_CMD      = 0x01,  // text command ("add ...|sig", "FORM_NET x", ...)
+    LINK_MSG_SET_BAUD = 0x02,  // payload: uint32 baud; peer answers, then switches
+    LINK_MSG_PING     = 0x03,  // answered with RSP_OK, empty payload
+    LINK_MSG_RSP_OK   = 0x81,  // payload: optional text detail
+    LINK_MSG_RSP_ERR  = 0x82,  // payload: text error reason
+    LINK_MSG_EVENT    = 0x90,  // payload: text event ("NETWORK_FORMED", ...)
+} link_msg_type_t;
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  id;
+    uint16_t len;
+    uint8_t  payload[LINK_MAX_PAYLOAD + 1];  // always NUL-terminated
+} link_frame_t;
+
+/**
+ * @brief Serialise one frame into out.
+ * @return Bytes written, or 0 if the payload or buffer is too small.
+ */
+static inline size_t link_frame_encode(uint8_t *out, size_t cap, uint8_t type, uint8_t id,
+                                       const void *payload, uint16_t len)
+{
+    if (len > LINK_MAX_PAYLOAD || cap < (size_t)len + LINK_FRAME_OVERHEAD) return 0;
+
+    out[0] = LINK_SOF0;
+    out[1] = LINK_SOF1;
+    out[2] = type;
+    out[3] = id;
+    out[4] = (uint8_t)(len & 0xFF);
+    out[5] = (uint8_t)(len >> 8);
+    if (len) memcpy(out + 6, payload, len);
+
+    uint16_t crc = hvac_crc16(out + 2, 4 + (size_t)len);
+    out[6 + len] = (uint8_t)(crc & 0xFF);
+    out[7 + len] = (uint8_t)(crc >> 8);
+    return (size_t)len + LINK_FRAME_OVERHEAD;
+}
+
+typedef enum {
+    LINK_DEC_TEXT,   // byte is not part of a frame; treat it as console text
+    LINK_DEC_BUSY,   // byte consumed into a frame in progress
+    LINK_DEC_FRAME,  // byte completed a valid frame (see decoder.frame)
+} link_dec_result_t;
+
+typedef struct {
+    uint8_t      state;
+    uint16_t     pos;
+    uint16_t     crc;
+    link_frame_t frame;
+    uint32_t     crc_errors;
+    uint32_t     oversize;
+} link_decoder_t;
+
+enum {
+    LINK_ST_SOF0, LINK_ST_SOF1, LINK_ST_TYPE, LINK_ST_ID, LINK_ST_LEN0, LINK_ST_LEN1,
+    LINK_ST_PAYLOAD, LINK_ST_CRC0, LINK_ST_CRC1,
+};
+
+static inline void link_decoder_reset(link_decoder_t *d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+static inline link_dec_result_t link_decoder_feed(link_decoder_t *d, uint8_t b)
+{
+    switch (d->state) {
+    case LINK_ST_SOF0:
+        if (b == LINK_SOF0) {
+            d->state = LINK_ST_SOF1;
+            return LINK_DEC_BUSY;
+        }
+        return LINK_DEC_TEXT;
+
+    case LINK_ST_SOF1:
+        if (b == LINK_SOF1) {
+            d->state = LINK_ST_TYPE;
+            d->crc = HVAC_CRC16_INIT;
+            return LINK_DEC_BUSY;
+        }
+        // Stray 0xA5 (never valid ASCII): drop it, re-examine this byte
+        d->state = LINK_ST_SOF0;
+        return link_decoder_feed(d, b);
+
+    case LINK_ST_TYPE:
+        d->frame.type = b;
+        d->crc = hvac_crc16_update(d->crc, &b, 1);
+        d->state = LINK_ST_ID;
+        return LINK_DEC_BUSY;
+
+    case LINK_ST_ID:
+        d->frame.id = b;
+        d->crc = hvac_crc16_update(d->crc, &b, 1);
+        d->state = LINK_ST_LEN0;
+        return LINK_DEC_BUSY;
+
+    case LINK_ST_LEN0:
+        d->frame.len = b;
+        d->crc = hvac_crc16_update(d->crc, &b, 1);
+        d->state = LINK_ST_LEN1;
+        return LINK_DEC_BUSY;
+
+    case LINK_ST_LEN1:
+        d->frame.len |= (uint16_t)b << 8;
+        d->crc = hvac_crc16_update(d->crc, &b, 1);
+        if (d->frame.len > LINK_MAX_PAYLOAD) {
+            d->oversize++;
+            d->state = LINK_ST_SOF0;
+            return LINK_DEC_BUSY;
+        }
+        d->pos = 0;
+        d->state = d->frame.len ? LINK_ST_PAYLOAD : LINK_ST_CRC0;
+        return LINK_DEC_BUSY;
+
+    case LINK_ST_PAYLOAD:
+        d->frame.payload[d->pos++] = b;
+        d->crc = hvac_crc16_update(d->crc, &b, 1);
+        if (d->pos == d->frame.len) d->state = LINK_ST_CRC0;
+        return LINK_DEC_BUSY;
+
+    case LINK_ST_CRC0:
+        d->pos = b;  // low byte, payload is complete so pos is free
+        d->state = LINK_ST_CRC1;
+        return LINK_DEC_BUSY;
+
+    case LINK_ST_CRC1:
+    default: {
+        uint16_t rx = (uint16_t)(d->pos | ((uint16_t)b << 8));
+        d->state = LINK_ST_SOF0;
+        if (rx != d->crc) {
+            d->crc_errors++;
+            return LINK_DEC_BUSY;
+        }
+        d->frame.payload[d->frame.len] = '\0';
+        return LINK_DEC_FRAME;
+    }
+    }
+}
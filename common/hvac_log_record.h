@@ -0,0 +1,169 @@
+#pragma once
+
+/**
+ * @brief Fixed-size binary SD log format shared by the Bridge, the sensor
+ *        probes and the host-side exporter.
+ *
+ * File layout:  [LogFileHeader][LogRecord][LogRecord]...
+ *
+ * Records are appended in time order and never rewritten, so record N lives
+ * at headerSize + N * recordSize and a time range can be found by binary
+ * search without a separate index. Every header and record carries its own
+ * CRC-16/CCITT, so a record torn by a brownout is detected and dropped by
+ * log_recover_tail() instead of corrupting the rest of the file.
+ *
+ * All fields are little-endian (native on ESP32 and x86/ARM hosts).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h>
+#include <string.h>
+
+#include "hvac_crc16.h"
+
+#define LOG_FILE_MAGIC    0x474C5648u  // "HVLG"
+#define LOG_FILE_VERSION  1
+#define LOG_MAX_CHANNELS  6
+
+// LogRecord.flags
+#define LOG_FLAG_UPTIME   0x01  // epoch is seconds since boot (no RTC)
+#define LOG_FLAG_INVALID  0x02  // sensor read failed, channels are not meaningful
+
+// LogRecord.ch value for a channel with no reading (probe absent or its read
+// failed) in an otherwise valid record. log_quantize() never produces it for
+// a real value; the exporter prints it as an empty field.
+#define LOG_CH_MISSING    INT16_MIN
+
+typedef struct __attribute__((packed)) {
+    char     name[6];  // NUL-padded, e.g. "TempC"
+    uint16_t scale;    // stored value = round(physical * scale)
+} LogChannelDesc;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t recordSize;
+    uint16_t sensorId;
+    uint32_t createdEpoch;
+    uint8_t  channelCount;
+    uint8_t  reserved[5];
+    LogChannelDesc channels[LOG_MAX_CHANNELS];
+    uint16_t crc;      // over all preceding bytes
+} LogFileHeader;
+
+typedef struct __attribute__((packed)) {
+    uint32_t epoch;
+    uint16_t sensorId;
+    uint16_t seq;      // wraps; gaps reveal dropped records
+    uint8_t  flags;
+    uint8_t  channelCount;
+    int16_t  ch[LOG_MAX_CHANNELS];
+    uint16_t crc;      // over all preceding bytes
+} LogRecord;
+
+#ifdef __cplusplus
+static_assert(sizeof(LogFileHeader) == 72, "LogFileHeader layout changed");
+static_assert(sizeof(LogRecord) == 24, "LogRecord layout changed");
+#endif
+
+static inline uint16_t log_crc16(const void *data, size_t len)
+{
+    return hvac_crc16(data, len);
+}
+
+// Saturating round(value * scale) into an int16 channel slot. NaN (a failed
+// read) gives LOG_CH_MISSING, so real values saturate at -32767.
+static inline int16_t log_quantize(float value, uint16_t scale)
+{
+    if (isnan(value)) return LOG_CH_MISSING;
+    float q = value * (float)scale;
+    q += (q >= 0.0f) ? 0.5f : -0.5f;
+    if (q >= 32767.0f) return 32767;
+    if (q <= -32767.0f) return -32767;
+    return (int16_t)q;
+}
+
+static inline void log_header_init(LogFileHeader *h, uint16_t sensorId, uint32_t createdEpoch)
+{
+    memset(h, 0, sizeof(*h));
+    h->magic        = LOG_FILE_MAGIC;
+    h->version      = LOG_FILE_VERSION;
+    h->headerSize   = sizeof(LogFileHeader);
+    h->recordSize   = sizeof(LogRecord);
+    h->sensorId     = sensorId;
+    h->createdEpoch = createdEpoch;
+}
+
+static inline void log_header_add_channel(LogFileHeader *h, const char *name, uint16_t scale)
+{
+    if (h->channelCount >= LOG_MAX_CHANNELS) return;
+    LogChannelDesc *c = &h->channels[h->channelCount++];
+    strncpy(c->name, name, sizeof(c->name));
+    c->scale = scale;
+}
+
+static inline void log_header_seal(LogFileHeader *h)
+{
+    h->crc = log_crc16(h, offsetof(LogFileHeader, crc));
+}
+
+static inline bool log_header_valid(const LogFileHeader *h)
+{
+    return h->magic == LOG_FILE_MAGIC &&
+           h->version == LOG_FILE_VERSION &&
+           h->headerSize == sizeof(LogFileHeader) &&
+           h->recordSize == sizeof(LogRecord) &&
+           h->channelCount <= LOG_MAX_CHANNELS &&
+           h->crc == log_crc16(h, offsetof(LogFileHeader, crc));
+}
+
+static inline void log_record_seal(LogRecord *r)
+{
+    r->crc = log_crc16(r, offsetof(LogRecord, crc));
+}
+
+static inline bool log_record_valid(const LogRecord *r)
+{
+    return r->channelCount <= LOG_MAX_CHANNELS &&
+           r->crc == log_crc16(r, offsetof(LogRecord, crc));
+}
+
+#ifdef __cplusplus
+/**
+ * @brief Boot-time recovery: drop a partially written tail.
+ *
+ * Cuts any trailing partial record, then walks back over up to
+ * maxScanBack complete records whose CRC fails (a torn multi-sector write
+ * can leave a whole-size but garbage record). File must be open read/write
+ * with a valid header already checked.
+ *
+ * Works with any SdFat-style file (fileSize/seekSet/read/truncate).
+ *
+ * @return Number of valid records left in the file.
+ */
+template <typename File>
+uint32_t log_recover_tail(File &file, uint32_t maxScanBack = 8)
+{
+    uint64_t size = file.fileSize();
+    if (size < sizeof(LogFileHeader)) return 0;
+
+    uint32_t count = (uint32_t)((size - sizeof(LogFileHeader)) / sizeof(LogRecord));
+
+    for (uint32_t scanned = 0; count > 0 && scanned < maxScanBack; scanned++) {
+        LogRecord rec;
+        file.seekSet(sizeof(LogFileHeader) + (uint64_t)(count - 1) * sizeof(LogRecord));
+        if (file.read(&rec, sizeof(rec)) == (int)sizeof(rec) && log_record_valid(&rec)) break;
+        count--;
+    }
+
+    uint64_t good = sizeof(LogFileHeader) + (uint64_t)count * sizeof(LogRecord);
+    if (good != size) {
+        file.truncate(good);
+    }
+    file.seekSet(good);
+    return count;
+}
+#endif
@@ -0,0 +1,175 @@
+#pragma once
+
+/**
+ * @brief Report-on-change policy for the SEDs, and the configuration
+ *        message the Commissioner uses to push its thresholds.
+ *
+ * A sample is reported when any channel has moved more than its deadband
+ * away from the value last reported, or changed faster than its slope
+ * limit since the previous sample; otherwise it is suppressed, and only a
+ * heartbeat goes out once heartbeat_s has passed without a report. A
+ * receiver holding the last reported value is then never further than the
+ * deadband from the real reading (slope reports only make it closer).
+ * Suppressed samples consume no sequence number, so silence from a sender
+ * that sets HVAC_PAYLOAD_F_ON_CHANGE means "unchanged", not "lost".
+ *
+ * Configuration message (little-endian), Commissioner -> SED on
+ * HVAC_REPORT_CFG_PORT, and echoed SED -> Commissioner inside a report
+ * datagram to announce the configuration in force:
+ *
+ *   0     marker | version   0xC1
+ *   1     id                 0 = the sensor's built-in defaults
+ *   2-3   heartbeat_s        0 = report every sample
+ *   4     channel count
+ *   ...   per channel: deadband, slope   uint16 each, in the channel's
+ *                                        quantized units (slope per minute)
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "hvac_sensor_payload.h"
+
+#define HVAC_REPORT_CFG_MARKER  0xC0u
+#define HVAC_REPORT_CFG_VERSION 1
+#define HVAC_REPORT_CFG_PORT    1235
+#define HVAC_REPORT_CFG_MAX_LEN (5 + 4 * HVAC_PAYLOAD_MAX_CHANNELS)
+
+#define HVAC_REPORT_DEFAULT_HEARTBEAT_S 600
+
+typedef struct {
+    uint8_t  id;
+    uint16_t heartbeat_s;
+    uint8_t  channel_count;
+    uint16_t deadband[HVAC_PAYLOAD_MAX_CHANNELS];  // 0 = report any change
+    uint16_t slope[HVAC_PAYLOAD_MAX_CHANNELS];     // per minute; 0 = no slope trigger
+} hvac_report_config_t;
+
+/** Sender-side memory of what was last reported. */
+typedef struct {
+    bool     valid;
+    uint32_t last_report_s;
+    int16_t  reported[HVAC_PAYLOAD_MAX_CHANNELS];
+    bool     prev_valid;
+    uint32_t prev_s;
+    int16_t  prev[HVAC_PAYLOAD_MAX_CHANNELS];
+} hvac_report_state_t;
+
+typedef enum {
+    HVAC_REPORT_SKIP = 0,
+    HVAC_REPORT_ALWAYS,     // report-on-change off
+    HVAC_REPORT_FIRST,
+    HVAC_REPORT_CHANGE,     // moved past the deadband
+    HVAC_REPORT_SLOPE,
+    HVAC_REPORT_HEARTBEAT,
+} hvac_report_reason_t;
+
+static inline const char *hvac_report_reason_name(hvac_report_reason_t r)
+{
+    static const char *names[] = { "skip", "always", "first", "change", "slope", "heartbeat" };
+    return (unsigned)r < sizeof(names) / sizeof(names[0]) ? names[r] : "?";
+}
+
+static inline bool hvac_report_config_is_message(const void *data, size_t len)
+{
+    return len >= 5 && (((const uint8_t *)data)[0] & 0xF0u) == HVAC_REPORT_CFG_MARKER;
+}
+
+/** @return Bytes written, or 0 if out is too small. */
+static inline size_t hvac_report_config_encode(const hvac_report_config_t *c, uint8_t *out,
+                                               size_t out_len)
+{
+    uint8_t n = c->channel_count > HVAC_PAYLOAD_MAX_CHANNELS ? HVAC_PAYLOAD_MAX_CHANNELS
+                                                             : c->channel_count;
+    size_t need = 5 + 4 * (size_t)n;
+    if (need > out_len) return 0;
+
+    out[0] = (uint8_t)(HVAC_REPORT_CFG_MARKER | HVAC_REPORT_CFG_VERSION);
+    out[1] = c->id;
+    out[2] = (uint8_t)c->heartbeat_s;
+    out[3] = (uint8_t)(c->heartbeat_s >> 8);
+    out[4] = n;
+    uint8_t *o = out + 5;
+    for (uint8_t i = 0; i < n; i++) {
+        *o++ = (uint8_t)c->deadband[i];
+        *o++ = (uint8_t)(c->deadband[i] >> 8);
+        *o++ = (uint8_t)c->slope[i];
+        *o++ = (uint8_t)(c->slope[i] >> 8);
+    }
+    return need;
+}
+
+/** @return Bytes consumed, or 0 if data is not a valid message. */
+static inline size_t hvac_report_config_decode(const uint8_t *data, size_t len,
+                                               hvac_report_config_t *c)
+{
+    if (!hvac_report_config_is_message(data, len)) return 0;
+    if ((data[0] & 0x0Fu) > HVAC_REPORT_CFG_VERSION) return 0;
+    uint8_t n = data[4];
+    size_t need = 5 + 4 * (size_t)n;
+    if (n > HVAC_PAYLOAD_MAX_CHANNELS || len < need) return 0;
+
+    c->id = data[1];
+    c->heartbeat_s = (uint16_t)(data[2] | (data[3] << 8));
+    c->channel_count = n;
+    const uint8_t *in = data + 5;
+    for (uint8_t i = 0; i < n; i++, in += 4) {
+        c->deadband[i] = (uint16_t)(in[0] | (in[1] << 8));
+        c->slope[i] = (uint16_t)(in[2] | (in[3] << 8));
+    }
+    return need;
+}
+
+/** Note that ch[] was reported at now_s, e.g. forced by an alarm. */
+static inline void hvac_report_mark(hvac_report_state_t *st, const int16_t *ch, uint8_t count,
+                                    uint32_t now_s)
+{
+    for (uint8_t i = 0; i < count && i < HVAC_PAYLOAD_MAX_CHANNELS; i++) st->reported[i] = ch[i];
+    st->last_report_s = now_s;
+    st->valid = true;
+}
+
+/**
+ * @brief Decide whether the sample ch[] taken at now_s is reported.
+ *
+ * Updates state as if the caller acts on the answer. Channels beyond the
+ * configuration's channel_count are reported on any change.
+ */
+static inline hvac_report_reason_t hvac_report_decide(const hvac_report_config_t *c,
+                                                      hvac_report_state_t *st,
+                                                      const int16_t *ch, uint8_t count,
+                                                      uint32_t now_s)
+{
+    hvac_report_reason_t reason = HVAC_REPORT_SKIP;
+
+    if (c->heartbeat_s == 0) {
+        reason = HVAC_REPORT_ALWAYS;
+    } else if (!st->valid) {
+        reason = HVAC_REPORT_FIRST;
+    } else {
+        for (uint8_t i = 0; i < count && reason == HVAC_REPORT_SKIP; i++) {
+            int32_t moved = (int32_t)ch[i] - st->reported[i];
+            if (moved < 0) moved = -moved;
+            uint16_t band = i < c->channel_count ? c->deadband[i] : 0;
+            if (moved > band) reason = HVAC_REPORT_CHANGE;
+        }
+        uint32_t dt = now_s - st->prev_s;
+        for (uint8_t i = 0; i < count && reason == HVAC_REPORT_SKIP && st->prev_valid && dt; i++) {
+            uint16_t limit = i < c->channel_count ? c->slope[i] : 0;
+            int32_t step = (int32_t)ch[i] - st->prev[i];
+            if (step < 0) step = -step;
+            if (limit && (uint32_t)step * 60u >= (uint32_t)limit * dt) reason = HVAC_REPORT_SLOPE;
+        }
+        if (reason == HVAC_REPORT_SKIP && now_s - st->last_report_s >= c->heartbeat_s) {
+            reason = HVAC_REPORT_HEARTBEAT;
+        }
+    }
+
+    for (uint8_t i = 0; i < count && i < HVAC_PAYLOAD_MAX_CHANNELS; i++) st->prev[i] = ch[i];
+    st->prev_s = now_s;
+    st->prev_valid = true;
+
+    if (reason != HVAC_REPORT_SKIP) hvac_report_mark(st, ch, count, now_s);
+    return reason;
+}
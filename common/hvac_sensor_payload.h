@@ -0,0 +1,276 @@
+#pragma once
+
+/**
+ * @brief Compact binary sensor report sent by the SEDs to the Commissioner
+ *        over UDP, replacing "name=value" text.
+ *
+ * Layout (little-endian):
+ *
+ *   0     marker | version    0xA1; text reports are 7-bit ASCII
+ *   1     sensor type         selects channel names and scales
+ *   2     flags | count       flags in the high nibble, channel count low
+ *   3-4   seq                 wraps; gaps reveal lost reports
+ *   [5-6] age_s               with HVAC_PAYLOAD_F_TIME: seconds between
+ *                             sampling and transmission
+ *   ...   channels            int16 each, or int8 deltas with
+ *                             HVAC_PAYLOAD_F_DELTA
+ *
+ * Channel values are quantized as round(physical * scale), the scale coming
+ * from the sensor type. A delta report only applies on top of the report
+ * with seq - 1, so the encoder falls back to absolute values every
+ * key_interval reports, or whenever a delta does not fit in int8, and a
+ * receiver that missed a report recovers at the next absolute one.
+ *
+ * A datagram may carry several reports back to back (a batch, oldest
+ * first, each with its own age_s); hvac_payload_length() steps through
+ * them. Deltas inside a batch chain from one report to the next.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h>
+
+#define HVAC_PAYLOAD_MARKER       0xA0u
+#define HVAC_PAYLOAD_VERSION      1
+#define HVAC_PAYLOAD_MAX_CHANNELS 6
+#define HVAC_PAYLOAD_HEADER_LEN   5
+#define HVAC_PAYLOAD_MAX_LEN      (HVAC_PAYLOAD_HEADER_LEN + 2 + 2 * HVAC_PAYLOAD_MAX_CHANNELS)
+#define HVAC_PAYLOAD_KEY_INTERVAL 8   // default: one absolute report in 8
+
+// Flags, high nibble of byte 2
+#define HVAC_PAYLOAD_F_DELTA     0x10u  // channels are int8 deltas against seq - 1
+#define HVAC_PAYLOAD_F_TIME      0x20u  // age_s present
+#define HVAC_PAYLOAD_F_ON_CHANGE 0x40u  // sender skips unchanged samples (hvac_report_policy.h)
+
+// Sensor types
+#define HVAC_SENSOR_GENERIC  0   // ch0..ch5, unscaled
+#define HVAC_SENSOR_TEMP     1   // temp
+#define HVAC_SENSOR_TEMP_HUM 2   // temp, hum
+#define HVAC_SENSOR_ENV      3   // temp, hum, press
+#define HVAC_SENSOR_THERMAL  4   // tmin, tmax, tavg, tcenter (IR array)
+
+typedef struct {
+    const char *name;   // at most 7 characters
+    uint16_t    scale;  // stored value = round(physical * scale)
+} hvac_channel_desc_t;
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  flags;          // HVAC_PAYLOAD_F_*; DELTA is set by the encoder
+    uint16_t seq;
+    uint16_t age_s;          // used with HVAC_PAYLOAD_F_TIME
+    uint8_t  channel_count;
+    int16_t  ch[HVAC_PAYLOAD_MAX_CHANNELS];
+} hvac_payload_t;
+
+/** Last report sent to, or decoded from, one sensor; the delta reference. */
+typedef struct {
+    bool     valid;
+    uint8_t  type;
+    uint8_t  channel_count;
+    uint16_t seq;
+    int16_t  ch[HVAC_PAYLOAD_MAX_CHANNELS];
+} hvac_payload_ref_t;
+
+typedef enum {
+    HVAC_PAYLOAD_OK = 0,
+    HVAC_PAYLOAD_ERR_FORMAT,   // truncated, bad marker or too many channels
+    HVAC_PAYLOAD_ERR_VERSION,  // newer format than this decoder
+    HVAC_PAYLOAD_ERR_NO_REF,   // delta report without the report before it
+} hvac_payload_status_t;
+
+/**
+ * @brief Channel names and scales of a sensor type.
+ *
+ * Unknown types are decoded as HVAC_SENSOR_GENERIC.
+ */
+static inline const hvac_channel_desc_t *hvac_sensor_channels(uint8_t type, uint8_t *count)
+{
+    static const hvac_channel_desc_t generic[] = {
+        { "ch0", 1 }, { "ch1", 1 }, { "ch2", 1 }, { "ch3", 1 }, { "ch4", 1 }, { "ch5", 1 },
+    };
+    static const hvac_channel_desc_t env[] = {
+        { "temp", 100 }, { "hum", 10 }, { "press", 10 },
+    };
+    static const hvac_channel_desc_t thermal[] = {
+        { "tmin", 100 }, { "tmax", 100 }, { "tavg", 100 }, { "tcenter", 100 },
+    };
+
+    switch (type) {
+    case HVAC_SENSOR_TEMP:     *count = 1; return env;
+    case HVAC_SENSOR_TEMP_HUM: *count = 2; return env;
+    case HVAC_SENSOR_ENV:      *count = 3; return env;
+    case HVAC_SENSOR_THERMAL:  *count = 4; return thermal;
+    default:                   *count = 6; return generic;
+    }
+}
+
+// Saturating round(value * scale), same rounding as log_quantize(). NaN
+// gives 0; callers skip failed reads rather than report them.
+static inline int16_t hvac_payload_quantize(float value, uint16_t scale)
+{
+    if (isnan(value)) return 0;
+    float q = value * (float)scale;
+    q += (q >= 0.0f) ? 0.5f : -0.5f;
+    if (q >= 32767.0f) return 32767;
+    if (q <= -32768.0f) return -32768;
+    return (int16_t)q;
+}
+
+/**
+ * @brief Store the physical value of channel i, quantized with its scale.
+ *
+ * Extends channel_count to cover i. Ignored for channels the type lacks.
+ */
+static inline void hvac_payload_set(hvac_payload_t *p, uint8_t i, float value)
+{
+    uint8_t count;
+    const hvac_channel_desc_t *desc = hvac_sensor_channels(p->type, &count);
+    if (i >= count) return;
+    p->ch[i] = hvac_payload_quantize(value, desc[i].scale);
+    if (p->channel_count <= i) p->channel_count = (uint8_t)(i + 1);
+}
+
+/** Physical value of channel i of a decoded report. */
+static inline float hvac_payload_value(const hvac_payload_t *p, uint8_t i)
+{
+    uint8_t count;
+    const hvac_channel_desc_t *desc = hvac_sensor_channels(p->type, &count);
+    return (i < count) ? (float)p->ch[i] / (float)desc[i].scale : 0.0f;
+}
+
+/** True if data starts like a binary report rather than text. */
+static inline bool hvac_payload_is_binary(const void *data, size_t len)
+{
+    return len >= HVAC_PAYLOAD_HEADER_LEN &&
+           (((const uint8_t *)data)[0] & 0xF0u) == HVAC_PAYLOAD_MARKER;
+}
+
+static inline size_t hvac_payload_size(uint8_t flags, uint8_t channel_count)
+{
+    return HVAC_PAYLOAD_HEADER_LEN + ((flags & HVAC_PAYLOAD_F_TIME) ? 2 : 0) +
+           (size_t)channel_count * ((flags & HVAC_PAYLOAD_F_DELTA) ? 1 : 2);
+}
+
+/**
+ * @brief Length of the report at the start of data.
+ *
+ * @return Bytes the report occupies, or 0 if it is malformed or truncated.
+ */
+static inline size_t hvac_payload_length(const uint8_t *data, size_t len)
+{
+    if (!hvac_payload_is_binary(data, len)) return 0;
+    uint8_t count = (uint8_t)(data[2] & 0x0Fu);
+    if (count > HVAC_PAYLOAD_MAX_CHANNELS) return 0;
+    size_t need = hvac_payload_size(data[2], count);
+    return need <= len ? need : 0;
+}
+
+static inline void hvac_payload_ref_store(hvac_payload_ref_t *ref, const hvac_payload_t *p)
+{
+    ref->valid = true;
+    ref->type = p->type;
+    ref->channel_count = p->channel_count;
+    ref->seq = p->seq;
+    for (uint8_t i = 0; i < p->channel_count; i++) ref->ch[i] = p->ch[i];
+}
+
+/**
+ * @brief Encode a report, delta-coded against ref when possible.
+ *
+ * @param ref          Previous report from this sender, updated on success.
+ *                     May be NULL to always send absolute values.
+ * @param key_interval Send absolute values whenever seq is a multiple of
+ *                     this; 0 disables delta coding.
+ *
+ * @return Bytes written, or 0 if p is invalid or out is too small.
+ */
+static inline size_t hvac_payload_encode(const hvac_payload_t *p, hvac_payload_ref_t *ref,
+                                         uint16_t key_interval, uint8_t *out, size_t out_len)
+{
+    if (p->channel_count > HVAC_PAYLOAD_MAX_CHANNELS) return 0;
+
+    bool delta = ref && ref->valid && key_interval && (p->seq % key_interval) != 0 &&
+                 ref->type == p->type && ref->channel_count == p->channel_count &&
+                 (uint16_t)(ref->seq + 1) == p->seq;
+    for (uint8_t i = 0; delta && i < p->channel_count; i++) {
+        int32_t d = (int32_t)p->ch[i] - ref->ch[i];
+        delta = d >= -128 && d <= 127;
+    }
+
+    uint8_t flags = (uint8_t)(p->flags & (HVAC_PAYLOAD_F_TIME | HVAC_PAYLOAD_F_ON_CHANGE));
+    if (delta) flags |= HVAC_PAYLOAD_F_DELTA;
+
+    if (hvac_payload_size(flags, p->channel_count) > out_len) return 0;
+
+    uint8_t *o = out;
+    *o++ = (uint8_t)(HVAC_PAYLOAD_MARKER | HVAC_PAYLOAD_VERSION);
+    *o++ = p->type;
+    *o++ = (uint8_t)(flags | p->channel_count);
+    *o++ = (uint8_t)p->seq;
+    *o++ = (uint8_t)(p->seq >> 8);
+    if (flags & HVAC_PAYLOAD_F_TIME) {
+        *o++ = (uint8_t)p->age_s;
+        *o++ = (uint8_t)(p->age_s >> 8);
+    }
+    for (uint8_t i = 0; i < p->channel_count; i++) {
+        if (delta) {
+            *o++ = (uint8_t)(int8_t)(p->ch[i] - ref->ch[i]);
+        } else {
+            *o++ = (uint8_t)p->ch[i];
+            *o++ = (uint8_t)((uint16_t)p->ch[i] >> 8);
+        }
+    }
+
+    if (ref) hvac_payload_ref_store(ref, p);
+    return (size_t)(o - out);
+}
+
+/**
+ * @brief Decode a report.
+ *
+ * @param ref Previous report from this sender, needed for delta reports
+ *            and updated on success; may be NULL if deltas are never sent.
+ *            A delta that does not follow ref invalidates it.
+ */
+static inline hvac_payload_status_t hvac_payload_decode(const uint8_t *data, size_t len,
+                                                        hvac_payload_ref_t *ref,
+                                                        hvac_payload_t *out)
+{
+    if (!hvac_payload_is_binary(data, len)) return HVAC_PAYLOAD_ERR_FORMAT;
+    if ((data[0] & 0x0Fu) > HVAC_PAYLOAD_VERSION) return HVAC_PAYLOAD_ERR_VERSION;
+    if (!hvac_payload_length(data, len)) return HVAC_PAYLOAD_ERR_FORMAT;
+
+    out->type = data[1];
+    out->flags = (uint8_t)(data[2] & 0xF0u);
+    out->channel_count = (uint8_t)(data[2] & 0x0Fu);
+    out->seq = (uint16_t)(data[3] | (data[4] << 8));
+    out->age_s = 0;
+    bool delta = (out->flags & HVAC_PAYLOAD_F_DELTA) != 0;
+
+    const uint8_t *in = data + HVAC_PAYLOAD_HEADER_LEN;
+    if (out->flags & HVAC_PAYLOAD_F_TIME) {
+        out->age_s = (uint16_t)(in[0] | (in[1] << 8));
+        in += 2;
+    }
+
+    if (delta) {
+        if (!ref || !ref->valid || ref->type != out->type ||
+            ref->channel_count != out->channel_count ||
+            (uint16_t)(ref->seq + 1) != out->seq) {
+            if (ref) ref->valid = false;
+            return HVAC_PAYLOAD_ERR_NO_REF;
+        }
+        for (uint8_t i = 0; i < out->channel_count; i++) {
+            out->ch[i] = (int16_t)(ref->ch[i] + (int8_t)in[i]);
+        }
+    } else {
+        for (uint8_t i = 0; i < out->channel_count; i++, in += 2) {
+            out->ch[i] = (int16_t)(in[0] | (in[1] << 8));
+        }
+    }
+
+    if (ref) hvac_payload_ref_store(ref, out);
+    return HVAC_PAYLOAD_OK;
+}
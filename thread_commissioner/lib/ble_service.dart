@@ -71,6 +71,7 @@ class BLEService extends ChangeNotifier {
   StreamSubscription? _scanSubscription;
   StreamSubscription? _connectionSubscription;
   StreamSubscription<List<int>>? _notifySub;
+  String _rxPartial = ''; // notification bytes after the last '\n'
   Timer? _connectionTimer;
   bool _autoReconnect = true;
 
@@ -341,10 +342,20 @@ class BLEService extends ChangeNotifier {
   }
 
   // --- Notification Handler ---
-  void _handleNotification(List<int> value) async {
+  // The Bridge packs several '\n'-terminated lines into one notification
+  // and may split a long line across notifications, so reassemble first.
+  void _handleNotification(List<int> value) {
     if (value.isEmpty) return;
+    final lines = (_rxPartial + utf8.decode(value, allowMalformed: true)).split('\n');
+    _rxPartial = lines.removeLast();
+    for (final line in lines) {
+      _handleLine(line);
+    }
+  }
+
+  void _handleLine(String rawLine) async {
     try {
-      final line = utf8.decode(value, allowMalformed: true).trim();
+      final line = rawLine.trim();
       if (line.isEmpty) return;
 
       _addLog('[NOTIFY] $line');
@@ -617,6 +628,7 @@ class BLEService extends ChangeNotifier {
     _targetCharacteristic = null;
     _notifySub?.cancel();
     _notifySub = null;
+    _rxPartial = '';
     _rssi = 0;
 
     _pendingTimer?.cancel();
@@ -0,0 +1,294 @@
+// bridge_replay — feed a captured BLE/UART trace through the Bridge core
+// (Bridge/bridge_core.cpp and friends, built against tools/bridge_host/fakes)
+// and report per-message handling latency and heap allocations.
+//
+//   bridge_replay [-v] [--sd DIR] [--sync-us N] [--repeat N] TRACE
+//
+// Trace format: one event per line, "<ms> <KIND> [args]"; lines starting with
+// '#' are comments.
+//   <ms> CONNECT [enc]       BLE client connects (enc: link already encrypted)
+//   <ms> SECURED             pairing completed
+//   <ms> DISCONNECT
+//   <ms> MTU <n>
+//   <ms> BLE <text>          characteristic write from the app
+//   <ms> RSP_OK <id> <text>  Commissioner response frame (ids are assigned 1,2,3...
+//   <ms> RSP_ERR <id> <text>   in the order the core sends commands)
+//   <ms> EVENT <text>        Commissioner event frame
+//   <ms> TEXT <text>         Commissioner console line
+//   <ms> SAMPLE <t> <h> <p> <g>   BME680 reading, logged as a LogRecord
+//
+// Between events the tool runs the Bridge loop() work (tick, notification
+// pump, config commit) every 5 ms of virtual time.
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <SdFat.h>
+#include "bridge_core.h"
+#include "ble_notify.h"
+#include "config_store.h"
+#include "logger.h"
+#include <hvac_link_frame.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// --- Allocation counting (operator new on the replay thread) ---
+static thread_local uint64_t t_allocs = 0;
+
+void* operator new(size_t n) {
+    t_allocs++;
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+static const uint32_t LOOP_MS = 5;
+
+struct KindStats {
+    std::vector<double> latUs;
+    uint64_t allocs = 0;
+};
+
+static std::map<std::string, KindStats> g_stats;
+static bool g_verbose = false;
+static uint8_t g_nextReqId = 0;
+static uint64_t g_notifyBytes = 0;
+static uint32_t g_notifyPackets = 0;
+
+// --- Fakes for the board side ---
+static bool fakeNotify(const uint8_t* data, size_t len) {
+    g_notifyPackets++;
+    g_notifyBytes += len;
+    if (g_verbose) printf("%8u BLE<< %.*s\n", millis(), (int)len, (const char*)data);
+    return true;
+}
+
+static uint8_t fakeSendCommand(const char* cmd) {
+    if (++g_nextReqId == 0) g_nextReqId = 1;
+    if (g_verbose) printf("%8u UART>> #%u %s\n", millis(), g_nextReqId, cmd);
+    return g_nextReqId;
+}
+
+static void fakeProvision(const char* json) {
+    if (g_verbose) printf("%8u PROVISION %s\n", millis(), json);
+}
+
+static void fakeSetInterval(uint32_t ms) {
+    if (g_verbose) printf("%8u INTERVAL %u\n", millis(), ms);
+}
+
+static void fakeLinkStats(char* buf, size_t len) {
+    snprintf(buf, len, "STATS UART (host replay)");
+}
+
+static Logger logger(0, 0, 0, 0);
+static uint16_t logSeq = 0;
+
+static void logStats(char* buf, size_t len) {
+    LoggerStats ls = logger.getStats();
+    snprintf(buf, len, "STATS SD q=%lu/%lu written=%lu dropped=%lu err=%lu commits=%lu",
+             (unsigned long)ls.queued, (unsigned long)ls.queueHighWater,
+             (unsigned long)ls.written, (unsigned long)ls.dropped,
+             (unsigned long)ls.writeErrors, (unsigned long)ls.commits);
+}
+
+static void runLoopUntil(uint32_t ms) {
+    while ((int32_t)(millis() - ms) < 0) {
+        uint32_t step = std::min<uint32_t>(LOOP_MS, ms - millis());
+        fakeClockAdvanceMs(step);
+        bridgeCoreTick();
+        bleNotifyPump();
+        configUpdate();
+    }
+}
+
+static std::string firstWord(const std::string& s) {
+    size_t end = s.find_first_of(" |");
+    return s.substr(0, end);
+}
+
+// Stats bucket for a trace event; empty for connection events, which are not timed.
+static std::string bucketFor(const std::string& kind, const std::string& rest) {
+    if (kind == "BLE" || kind == "EVENT") return kind + " " + firstWord(rest);
+    if (kind == "RSP_OK" || kind == "RSP_ERR" || kind == "TEXT" || kind == "SAMPLE") return kind;
+    return "";
+}
+
+// Runs one trace event; returns false for an unknown event kind.
+static bool dispatch(const std::string& kind, const std::string& rest) {
+    if (kind == "CONNECT") {
+        bridgeCoreOnConnect(rest == "enc");
+        return true;
+    }
+    if (kind == "SECURED")    { bridgeCoreOnSecured(true); return true; }
+    if (kind == "DISCONNECT") { bridgeCoreOnDisconnect(); return true; }
+    if (kind == "MTU")        { bleNotifySetMtu((uint16_t)atoi(rest.c_str())); return true; }
+
+    if (kind == "BLE") {
+        bridgeCoreOnBleWrite(rest.data(), rest.size());
+        return true;
+    }
+    if (kind == "RSP_OK" || kind == "RSP_ERR") {
+        unsigned id = 0;
+        int used = 0;
+        sscanf(rest.c_str(), "%u %n", &id, &used);
+        bridgeCoreOnLinkFrame(kind == "RSP_OK" ? LINK_MSG_RSP_OK : LINK_MSG_RSP_ERR, (uint8_t)id, rest.c_str() + used);
+        return true;
+    }
+    if (kind == "EVENT") {
+        bridgeCoreOnLinkFrame(LINK_MSG_EVENT, 0, rest.c_str());
+        return true;
+    }
+    if (kind == "TEXT") {
+        bridgeCoreOnLinkText(rest.c_str());
+        return true;
+    }
+    if (kind == "SAMPLE") {
+        float t = 0, h = 0, p = 0, g = 0;
+        sscanf(rest.c_str(), "%f %f %f %f", &t, &h, &p, &g);
+        LogRecord rec = {};
+        rec.epoch        = millis() / 1000;
+        rec.sensorId     = 1;
+        rec.seq          = logSeq++;
+        rec.flags        = LOG_FLAG_UPTIME;
+        rec.channelCount = 4;
+        rec.ch[0]        = log_quantize(t, 100);
+        rec.ch[1]        = log_quantize(h, 100);
+        rec.ch[2]        = log_quantize(p, 10);
+        rec.ch[3]        = log_quantize(g, 10);
+        logger.log(rec);
+        return true;
+    }
+    return false;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+static void usage() {
+    fprintf(stderr, "usage: bridge_replay [-v] [--sd DIR] [--sync-us N] [--repeat N] TRACE\n");
+}
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    const char* sdDir = ".";
+    uint32_t syncUs = 0;
+    int repeat = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-v") g_verbose = true;
+        else if (a == "--sd" && i + 1 < argc) sdDir = argv[++i];
+        else if (a == "--sync-us" && i + 1 < argc) syncUs = (uint32_t)atoi(argv[++i]);
+        else if (a == "--repeat" && i + 1 < argc) repeat = std::max(1, atoi(argv[++i]));
+        else if (!tracePath) tracePath = argv[i];
+        else { usage(); return 2; }
+    }
+    if (!tracePath) { usage(); return 2; }
+
+    std::ifstream trace(tracePath);
+    if (!trace) {
+        fprintf(stderr, "cannot open %s\n", tracePath);
+        return 1;
+    }
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(trace, line);) lines.push_back(line);
+
+    Serial.setQuiet(!g_verbose);
+    fakeSdSetRoot(sdDir);
+    fakeSdSetSyncDelayUs(syncUs);
+
+    // Same bring-up order as Bridge.ino setup()
+    bleNotifyBegin(fakeNotify);
+    BridgeCoreHooks hooks = {};
+    hooks.sendCommand       = fakeSendCommand;
+    hooks.provision         = fakeProvision;
+    hooks.setSampleInterval = fakeSetInterval;
+    hooks.formatLinkStats   = fakeLinkStats;
+    hooks.formatLogStats    = logStats;
+    bridgeCoreBegin(hooks);
+    configBegin("123456");
+
+    logger.begin();
+    logger.setFilename("/replay_log.bin");
+    LogFileHeader header;
+    log_header_init(&header, 1, 0);
+    log_header_add_channel(&header, "TempC", 100);
+    log_header_add_channel(&header, "Hum",   100);
+    log_header_add_channel(&header, "hPa",   10);
+    log_header_add_channel(&header, "VOCk",  10);
+    logger.openBinary(header);
+    logger.startAsync();
+
+    // Trace times are relative to the end of bring-up (SD init waits on the clock)
+    uint32_t base = millis();
+    for (int r = 0; r < repeat; r++) {
+        uint32_t lastMs = 0;
+        for (const std::string& raw : lines) {
+            std::istringstream in(raw);
+            uint32_t ms;
+            std::string kind;
+            if (!(in >> ms >> kind) || kind[0] == '#') continue;
+            std::string rest;
+            std::getline(in >> std::ws, rest);
+            while (!rest.empty() && isspace((unsigned char)rest.back())) rest.pop_back();
+
+            lastMs = ms;
+            runLoopUntil(base + ms);
+
+            std::string bucket = bucketFor(kind, rest);
+            uint64_t allocs0 = t_allocs;
+            auto t0 = std::chrono::steady_clock::now();
+            bool known = dispatch(kind, rest);
+            auto t1 = std::chrono::steady_clock::now();
+            uint64_t allocs = t_allocs - allocs0;
+
+            if (!known) {
+                fprintf(stderr, "unknown trace event: %s\n", kind.c_str());
+            } else if (!bucket.empty()) {
+                KindStats& ks = g_stats[bucket];
+                ks.latUs.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+                ks.allocs += allocs;
+            }
+        }
+        base += lastMs + 1000;  // next pass starts a second after this one ends
+        runLoopUntil(base);
+    }
+    // The writer task commits on its own thread; give it a moment to drain
+    logger.flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    printf("%-28s %7s %9s %9s %9s %9s %8s\n", "message", "count", "mean_us", "p50_us", "p99_us", "max_us", "allocs");
+    for (auto& kv : g_stats) {
+        const KindStats& ks = kv.second;
+        double sum = 0;
+        for (double v : ks.latUs) sum += v;
+        printf("%-28s %7zu %9.2f %9.2f %9.2f %9.2f %8.2f\n", kv.first.c_str(), ks.latUs.size(),
+               sum / ks.latUs.size(), percentile(ks.latUs, 0.5), percentile(ks.latUs, 0.99),
+               percentile(ks.latUs, 1.0), (double)ks.allocs / ks.latUs.size());
+    }
+
+    BleNotifyStats bs = bleNotifyGetStats();
+    printf("\nBLE: %u notifications, %llu bytes, %u lines (%u coalesced), drops p=%u d=%u, throttled=%u\n",
+           g_notifyPackets, (unsigned long long)g_notifyBytes, bs.lines, bs.coalesced,
+           bs.protocolDrops, bs.debugDrops, bs.debugThrottled);
+    printf("NVS writes: %u\n", fakeNvsWriteCount());
+    LoggerStats ls = logger.getStats();
+    printf("SD: written=%u dropped=%u commits=%u max_commit=%uus\n",
+           ls.written, ls.dropped, ls.commits, ls.maxCommitUs);
+    return 0;
+}
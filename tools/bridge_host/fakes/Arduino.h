@@ -0,0 +1,51 @@
+// Host fake of the Arduino core subset used by the Bridge sources built on the host.
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+// --- Clock: virtual, driven by the host program ---
+unsigned long millis();
+uint32_t micros();
+void     delay(uint32_t ms);
+void     fakeClockSet(uint64_t us);
+void     fakeClockAdvanceMs(uint32_t ms);
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    bool operator==(const char* o) const { return _s == o; }
+private:
+    std::string _s;
+};
+
+// Serial output goes to stderr unless silenced (benchmarks silence it).
+class FakeSerial {
+public:
+    void begin(unsigned long) {}
+    int  printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    void print(const char* s);
+    void println(const char* s = "");
+    void println(const String& s) { println(s.c_str()); }
+    void setQuiet(bool quiet) { _quiet = quiet; }
+private:
+    bool _quiet = false;
+};
+extern FakeSerial Serial;
+
+#endif
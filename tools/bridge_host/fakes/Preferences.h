@@ -0,0 +1,31 @@
+// Host fake of ESP32 Preferences: an in-memory NVS shared by all instances.
+#ifndef FAKE_PREFERENCES_H
+#define FAKE_PREFERENCES_H
+
+#include <Arduino.h>
+
+class Preferences {
+public:
+    bool     begin(const char* ns, bool readOnly = false);
+    void     end();
+    bool     isKey(const char* key);
+
+    bool     getBool(const char* key, bool def = false);
+    String   getString(const char* key, const String& def = String());
+    uint16_t getUShort(const char* key, uint16_t def = 0);
+    uint32_t getULong(const char* key, uint32_t def = 0);
+
+    size_t   putBool(const char* key, bool v);
+    size_t   putString(const char* key, const char* v);
+    size_t   putUShort(const char* key, uint16_t v);
+    size_t   putULong(const char* key, uint32_t v);
+
+private:
+    std::string _ns;
+    bool        _readOnly = true;
+};
+
+// Number of put*() calls so far, i.e. simulated flash writes.
+uint32_t fakeNvsWriteCount();
+
+#endif
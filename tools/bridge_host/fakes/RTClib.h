@@ -0,0 +1,63 @@
+// Host fake of the RTClib subset used by Bridge/rtc_ds1307.cpp. The DS1307
+// reads fakeRtcEpochBase plus the virtual millis() clock.
+#ifndef FAKE_RTCLIB_H
+#define FAKE_RTCLIB_H
+
+#include <Arduino.h>
+
+#define F(s) (s)
+
+inline bool     fakeRtcPresent = true;
+inline uint32_t fakeRtcEpochBase = 1767225600;  // 2026-01-01 00:00:00 UTC
+
+class DateTime {
+public:
+    explicit DateTime(uint32_t t = 0) : _t(t) {}
+    DateTime(const char*, const char*) : _t(fakeRtcEpochBase) {}
+    DateTime(uint16_t y, uint8_t mo, uint8_t d, uint8_t h = 0, uint8_t mi = 0, uint8_t s = 0) {
+        // days_from_civil (H. Hinnant)
+        int yy = y - (mo <= 2);
+        int era = yy / 400;
+        unsigned yoe = (unsigned)(yy - era * 400);
+        unsigned doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        uint32_t days = (uint32_t)(era * 146097 + (int)doe - 719468);
+        _t = days * 86400u + h * 3600u + mi * 60u + s;
+    }
+
+    uint16_t year() const   { civil(); return _y; }
+    uint8_t  month() const  { civil(); return _mo; }
+    uint8_t  day() const    { civil(); return _d; }
+    uint8_t  hour() const   { return (uint8_t)(_t / 3600 % 24); }
+    uint8_t  minute() const { return (uint8_t)(_t / 60 % 60); }
+    uint8_t  second() const { return (uint8_t)(_t % 60); }
+    uint32_t unixtime() const { return _t; }
+
+private:
+    uint32_t _t;
+    mutable uint16_t _y = 0;
+    mutable uint8_t _mo = 0, _d = 0;
+
+    // civil_from_days (H. Hinnant)
+    void civil() const {
+        int z = (int)(_t / 86400) + 719468;
+        int era = z / 146097;
+        unsigned doe = (unsigned)(z - era * 146097);
+        unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp = (5 * doy + 2) / 153;
+        _d = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+        _mo = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+        _y = (uint16_t)(yoe + era * 400 + (_mo <= 2));
+    }
+};
+
+class RTC_DS1307 {
+public:
+    bool begin() { return fakeRtcPresent; }
+    bool isrunning() { return true; }
+    void adjust(const DateTime& dt) { fakeRtcEpochBase = dt.unixtime() - millis() / 1000; }
+    DateTime now() { return DateTime(fakeRtcEpochBase + millis() / 1000); }
+};
+
+#endif
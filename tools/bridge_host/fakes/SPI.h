@@ -0,0 +1,14 @@
+// Host fake: the SD card is a directory, so SPI does nothing.
+#ifndef FAKE_SPI_H
+#define FAKE_SPI_H
+
+#include <stdint.h>
+
+class FakeSPI {
+public:
+    void begin(int8_t, int8_t, int8_t, int8_t) {}
+    void end() {}
+};
+extern FakeSPI SPI;
+
+#endif
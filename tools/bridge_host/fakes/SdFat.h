@@ -0,0 +1,64 @@
+// Host fake of the SdFat exFAT API used by Logger, backed by stdio files
+// under a host directory (see fakeSdSetRoot()).
+#ifndef FAKE_SDFAT_H
+#define FAKE_SDFAT_H
+
+#include <Arduino.h>
+#include <fcntl.h>
+
+#define O_WRITE         O_WRONLY
+#define DEDICATED_SPI   1
+#define SD_SCK_MHZ(m)   ((m) * 1000000UL)
+
+struct SdSpiConfig {
+    SdSpiConfig(uint8_t, uint8_t, uint32_t) {}
+};
+
+class ExFile {
+public:
+    ExFile() {}
+    explicit ExFile(FILE* f) : _f(f) {}
+    ExFile(const ExFile&) = delete;
+    ExFile& operator=(const ExFile&) = delete;
+    ExFile(ExFile&& o) : _f(o._f) { o._f = nullptr; }
+    ExFile& operator=(ExFile&& o);
+    ~ExFile();
+
+    explicit operator bool() const { return _f != nullptr; }
+
+    size_t   write(const void* buf, size_t len);
+    size_t   println(const char* s = "");
+    size_t   println(const String& s) { return println(s.c_str()); }
+    int      read(void* buf, size_t len);
+    bool     seekSet(uint64_t pos);
+    uint64_t fileSize();
+    bool     truncate(uint64_t len);
+    bool     preAllocate(uint64_t) { return true; }
+    bool     sync();
+    void     flush() { sync(); }
+    bool     close();
+    void     clearWriteError() { _writeError = false; }
+    bool     getWriteError() const { return _writeError; }
+
+private:
+    FILE* _f = nullptr;
+    bool  _writeError = false;
+};
+
+class SdExFat {
+public:
+    bool    begin(const SdSpiConfig&) { return true; }
+    uint8_t sdErrorCode() const { return 0; }
+    bool    exists(const char* path);
+    ExFile  open(const char* path, int flags);
+    bool    remove(const char* path);
+    bool    rename(const char* from, const char* to);
+};
+
+// Directory that stands in for the card root (default: current directory).
+void fakeSdSetRoot(const char* dir);
+
+// Adds this much simulated latency to every sync().
+void fakeSdSetSyncDelayUs(uint32_t us);
+
+#endif
@@ -0,0 +1,296 @@
+// Implementations behind the host fakes (Arduino, SdFat, Preferences, FreeRTOS).
+#include <Arduino.h>
+#include <SPI.h>
+#include <SdFat.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// --- Clock ---
+static std::atomic<uint64_t> nowUs{0};
+
+// unsigned long as in the ESP32 core; wraps at 32 bits as it does there
+unsigned long millis() { return (uint32_t)(nowUs.load() / 1000); }
+uint32_t micros() { return (uint32_t)nowUs.load(); }
+void delay(uint32_t ms) { nowUs += (uint64_t)ms * 1000; }
+void fakeClockSet(uint64_t us) { nowUs = us; }
+void fakeClockAdvanceMs(uint32_t ms) { nowUs += (uint64_t)ms * 1000; }
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+// --- Serial ---
+FakeSerial Serial;
+FakeSPI SPI;
+
+int FakeSerial::printf(const char* fmt, ...) {
+    if (_quiet) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+void FakeSerial::print(const char* s) {
+    if (!_quiet) fputs(s, stderr);
+}
+
+void FakeSerial::println(const char* s) {
+    if (!_quiet) fprintf(stderr, "%s\n", s);
+}
+
+// --- SdFat ---
+static std::string sdRoot = ".";
+static uint32_t sdSyncDelayUs = 0;
+
+void fakeSdSetRoot(const char* dir) { sdRoot = dir; }
+void fakeSdSetSyncDelayUs(uint32_t us) { sdSyncDelayUs = us; }
+
+static std::string sdPath(const char* path) {
+    return sdRoot + (path[0] == '/' ? "" : "/") + path;
+}
+
+ExFile& ExFile::operator=(ExFile&& o) {
+    if (this != &o) {
+        if (_f) fclose(_f);
+        _f = o._f;
+        _writeError = false;
+        o._f = nullptr;
+    }
+    return *this;
+}
+
+ExFile::~ExFile() {
+    if (_f) fclose(_f);
+}
+
+size_t ExFile::write(const void* buf, size_t len) {
+    size_t n = _f ? fwrite(buf, 1, len, _f) : 0;
+    if (n != len) _writeError = true;
+    return n;
+}
+
+size_t ExFile::println(const char* s) {
+    size_t len = strlen(s);
+    size_t n = write(s, len);
+    return n + write("\r\n", 2);
+}
+
+int ExFile::read(void* buf, size_t len) {
+    return _f ? (int)fread(buf, 1, len, _f) : -1;
+}
+
+bool ExFile::seekSet(uint64_t pos) {
+    return _f && fseeko(_f, (off_t)pos, SEEK_SET) == 0;
+}
+
+uint64_t ExFile::fileSize() {
+    if (!_f) return 0;
+    off_t cur = ftello(_f);
+    fseeko(_f, 0, SEEK_END);
+    off_t end = ftello(_f);
+    fseeko(_f, cur, SEEK_SET);
+    return (uint64_t)end;
+}
+
+bool ExFile::truncate(uint64_t len) {
+    return _f && fflush(_f) == 0 && ftruncate(fileno(_f), (off_t)len) == 0;
+}
+
+bool ExFile::sync() {
+    if (!_f) return false;
+    if (sdSyncDelayUs) std::this_thread::sleep_for(std::chrono::microseconds(sdSyncDelayUs));
+    return fflush(_f) == 0;
+}
+
+bool ExFile::close() {
+    if (!_f) return false;
+    bool ok = fclose(_f) == 0;
+    _f = nullptr;
+    return ok;
+}
+
+bool SdExFat::exists(const char* path) {
+    return access(sdPath(path).c_str(), F_OK) == 0;
+}
+
+ExFile SdExFat::open(const char* path, int flags) {
+    const char* mode;
+    if (flags & O_APPEND)      mode = "ab";
+    else if (flags & O_RDWR)   mode = "r+b";
+    else                       mode = (flags & O_CREAT) ? "wb" : "rb";
+    return ExFile(fopen(sdPath(path).c_str(), mode));
+}
+
+bool SdExFat::remove(const char* path) {
+    return ::remove(sdPath(path).c_str()) == 0;
+}
+
+bool SdExFat::rename(const char* from, const char* to) {
+    return ::rename(sdPath(from).c_str(), sdPath(to).c_str()) == 0;
+}
+
+// --- Preferences ---
+static std::mutex nvsMutex;
+static std::map<std::string, std::string> nvs;  // "ns/key" -> value
+static uint32_t nvsWrites = 0;
+
+uint32_t fakeNvsWriteCount() { return nvsWrites; }
+
+bool Preferences::begin(const char* ns, bool readOnly) {
+    _ns = ns;
+    _readOnly = readOnly;
+    return true;
+}
+
+void Preferences::end() {}
+
+static bool nvsGet(const std::string& key, std::string& out) {
+    std::lock_guard<std::mutex> lock(nvsMutex);
+    auto it = nvs.find(key);
+    if (it == nvs.end()) return false;
+    out = it->second;
+    return true;
+}
+
+static size_t nvsPut(const std::string& key, const std::string& v, bool readOnly) {
+    if (readOnly) return 0;
+    std::lock_guard<std::mutex> lock(nvsMutex);
+    nvs[key] = v;
+    nvsWrites++;
+    return v.size();
+}
+
+bool Preferences::isKey(const char* key) {
+    std::string v;
+    return nvsGet(_ns + "/" + key, v);
+}
+
+bool Preferences::getBool(const char* key, bool def) {
+    std::string v;
+    return nvsGet(_ns + "/" + key, v) ? v == "1" : def;
+}
+
+String Preferences::getString(const char* key, const String& def) {
+    std::string v;
+    return nvsGet(_ns + "/" + key, v) ? String(v) : def;
+}
+
+uint16_t Preferences::getUShort(const char* key, uint16_t def) {
+    std::string v;
+    return nvsGet(_ns + "/" + key, v) ? (uint16_t)strtoul(v.c_str(), nullptr, 10) : def;
+}
+
+uint32_t Preferences::getULong(const char* key, uint32_t def) {
+    std::string v;
+    return nvsGet(_ns + "/" + key, v) ? (uint32_t)strtoul(v.c_str(), nullptr, 10) : def;
+}
+
+size_t Preferences::putBool(const char* key, bool v)         { return nvsPut(_ns + "/" + key, v ? "1" : "0", _readOnly); }
+size_t Preferences::putString(const char* key, const char* v) { return nvsPut(_ns + "/" + key, v, _readOnly); }
+size_t Preferences::putUShort(const char* key, uint16_t v)   { return nvsPut(_ns + "/" + key, std::to_string(v), _readOnly); }
+size_t Preferences::putULong(const char* key, uint32_t v)    { return nvsPut(_ns + "/" + key, std::to_string(v), _readOnly); }
+
+// --- FreeRTOS ---
+struct FakeQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+struct FakeMutex {
+    std::mutex mutex;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    FakeQueue* q = new FakeQueue;
+    q->length = length;
+    q->itemSize = itemSize;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    delete q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    auto hasRoom = [q] { return q->items.size() < q->length; };
+    if (!hasRoom()) {
+        if (wait == 0) return pdFALSE;
+        if (wait == portMAX_DELAY) q->cv.wait(lock, hasRoom);
+        else if (!q->cv.wait_for(lock, std::chrono::milliseconds(wait), hasRoom)) return pdFALSE;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(item);
+    q->items.emplace_back(p, p + q->itemSize);
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(q->mutex);
+    auto hasItem = [q] { return !q->items.empty(); };
+    if (!hasItem()) {
+        if (wait == 0) return pdFALSE;
+        if (wait == portMAX_DELAY) q->cv.wait(lock, hasItem);
+        else if (!q->cv.wait_for(lock, std::chrono::milliseconds(wait), hasItem)) return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->mutex);
+    return (UBaseType_t)q->items.size();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                       UBaseType_t, TaskHandle_t* handle) {
+    std::thread(fn, arg).detach();
+    if (handle) *handle = reinterpret_cast<TaskHandle_t>(1);
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new FakeMutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t) {
+    m->mutex.lock();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+    m->mutex.unlock();
+    return pdTRUE;
+}
@@ -0,0 +1,15 @@
+#ifndef FAKE_FREERTOS_QUEUE_H
+#define FAKE_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct FakeQueue* QueueHandle_t;
+
+// Timeouts are real time (ticks = ms); only millis() is virtual.
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void          vQueueDelete(QueueHandle_t q);
+BaseType_t    xQueueSend(QueueHandle_t q, const void* item, TickType_t wait);
+BaseType_t    xQueueReceive(QueueHandle_t q, void* item, TickType_t wait);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t q);
+
+#endif
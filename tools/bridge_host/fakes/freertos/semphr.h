@@ -0,0 +1,12 @@
+#ifndef FAKE_FREERTOS_SEMPHR_H
+#define FAKE_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct FakeMutex* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t m);
+
+#endif
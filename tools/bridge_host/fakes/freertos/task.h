@@ -0,0 +1,14 @@
+#ifndef FAKE_FREERTOS_TASK_H
+#define FAKE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct FakeTask* TaskHandle_t;
+
+// Runs the task on a detached std::thread; stack and priority are ignored.
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack,
+                       void* arg, UBaseType_t prio, TaskHandle_t* handle);
+void       vTaskDelay(TickType_t ticks);
+
+#endif
@@ -0,0 +1,415 @@
+// heap_soak — heap fragmentation caused by the Bridge BME sample path over
+// simulated days of uptime, next to the NimBLE and Wi-Fi heap traffic it
+// shares the heap with.
+//
+//   heap_soak [--days N] [--heap KB] [--interval MS] [--seed S]
+//
+// The heap is a first-fit, address-ordered free list with coalescing and an
+// 8-byte block header over a fixed arena (--heap: what is left to the sketch
+// on an ESP32-C3 running NimBLE and Wi-Fi). Background traffic is modelled
+// as Poisson arrivals with exponential lifetimes: Wi-Fi RX buffers, BLE
+// mbufs, lwIP pbufs, and long-lived allocations (connections, timers).
+//
+// Every --interval ms one sample runs, spread over SAMPLE_PATH_MS of
+// virtual time with background traffic in between, along one of two paths:
+//
+//   fixed   the current path: rtcGetDateTime(), rtcFormatTimestamp(), the
+//           LogRecord and its Serial line (Bridge/rtc_ds1307.cpp built here
+//           against tools/bridge_host/fakes). operator new during the sample
+//           is served from the arena and counted.
+//   String  the String-based path it replaced, modelled by the allocations
+//           of its Arduino Strings (inline up to 11 chars, exact-size
+//           regrowth on every concat): the RTCDateTime timestamp held for
+//           the whole sample, and "Logged: <date> <time>" built after the
+//           SD write.
+//
+// The SD write itself is left out: SdFat writes from its own sector cache.
+// Both paths see the same background traffic. For each simulated day the
+// tool prints free heap, the largest free block at the end of the day, its
+// minimum during the day, and the number of free blocks (holes).
+
+#include <Arduino.h>
+#include "rtc_ds1307.h"
+#include <hvac_log_record.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <new>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+static const uint32_t SAMPLE_PATH_MS = 20;   // RTC read .. Serial line, SD write included
+static const uint32_t SD_WRITE_MS    = 15;   // offset of the Serial line within the sample
+
+// --- Simulated heap ---
+class Arena {
+public:
+    static const size_t HEADER = 8;
+
+    explicit Arena(size_t size) : _mem(size) { _blocks[0] = { size, true }; }
+
+    void* alloc(size_t n) {
+        size_t need = blockSize(n);
+        for (auto& [off, b] : _blocks) {
+            if (b.free && b.size >= need) {
+                take(off, b, need);
+                return _mem.data() + off + HEADER;
+            }
+        }
+        _failures++;
+        return nullptr;
+    }
+
+    void* realloc(void* p, size_t n) {
+        if (!p) return alloc(n);
+        size_t off = offsetOf(p);
+        Block& b = _blocks[off];
+        size_t need = blockSize(n);
+        if (need <= b.size) return p;
+
+        // Grow in place into a free neighbour, as multi_heap does
+        auto next = _blocks.find(off + b.size);
+        if (next != _blocks.end() && next->second.free && b.size + next->second.size >= need) {
+            b.size += next->second.size;
+            _blocks.erase(next);
+            split(off, b, need);
+            return p;
+        }
+        void* q = alloc(n);
+        if (!q) return nullptr;
+        memcpy(q, p, b.size - HEADER);
+        free(p);
+        return q;
+    }
+
+    void free(void* p) {
+        if (!p) return;
+        auto it = _blocks.find(offsetOf(p));
+        it->second.free = true;
+        auto next = std::next(it);
+        if (next != _blocks.end() && next->second.free) {
+            it->second.size += next->second.size;
+            _blocks.erase(next);
+        }
+        if (it != _blocks.begin()) {
+            auto prev = std::prev(it);
+            if (prev->second.free) {
+                prev->second.size += it->second.size;
+                _blocks.erase(it);
+            }
+        }
+    }
+
+    bool owns(const void* p) const {
+        const uint8_t* b = static_cast<const uint8_t*>(p);
+        return b >= _mem.data() && b < _mem.data() + _mem.size();
+    }
+
+    size_t freeBytes() const {
+        size_t n = 0;
+        for (const auto& [off, b] : _blocks) if (b.free) n += b.size;
+        return n;
+    }
+
+    // Largest request that would succeed
+    size_t largestFree() const {
+        size_t n = 0;
+        for (const auto& [off, b] : _blocks) if (b.free) n = std::max(n, b.size);
+        return n > HEADER ? n - HEADER : 0;
+    }
+
+    size_t freeBlocks() const {
+        size_t n = 0;
+        for (const auto& [off, b] : _blocks) n += b.free;
+        return n;
+    }
+
+    uint64_t failures() const { return _failures; }
+
+private:
+    struct Block {
+        size_t size;   // header included
+        bool free;
+    };
+    std::vector<uint8_t> _mem;
+    std::map<size_t, Block> _blocks;   // by offset
+    uint64_t _failures = 0;
+
+    static size_t blockSize(size_t n) { return HEADER + ((std::max<size_t>(n, 1) + 7) & ~(size_t)7); }
+    size_t offsetOf(const void* p) const { return static_cast<const uint8_t*>(p) - _mem.data() - HEADER; }
+
+    void take(size_t off, Block& b, size_t need) {
+        b.free = false;
+        split(off, b, need);
+    }
+
+    void split(size_t off, Block& b, size_t need) {
+        if (b.size - need < 2 * HEADER) return;
+        Block rest = { b.size - need, true };
+        b.size = need;
+        auto next = _blocks.find(off + need + rest.size);
+        if (next != _blocks.end() && next->second.free) {
+            rest.size += next->second.size;
+            _blocks.erase(next);
+        }
+        _blocks[off + need] = rest;
+    }
+};
+
+// --- operator new during a sample goes to the arena ---
+static Arena* g_arena = nullptr;
+static bool g_inSample = false;
+static uint64_t g_sampleAllocs = 0;
+
+void* operator new(size_t n) {
+    if (g_inSample && g_arena) {
+        g_sampleAllocs++;
+        if (void* p = g_arena->alloc(n)) return p;
+        throw std::bad_alloc();
+    }
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept {
+    if (g_arena && p && g_arena->owns(p)) g_arena->free(p);
+    else free(p);
+}
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+// --- Background heap traffic (NimBLE, Wi-Fi, lwIP) ---
+struct Traffic {
+    const char* name;
+    double perSec;
+    size_t minSize, maxSize;
+    double meanLifeS;
+};
+
+static const Traffic TRAFFIC[] = {
+    { "wifi_rx", 2.0,    1600, 1600, 0.005 },
+    { "ble",     4.0,    24,   292,  0.05 },
+    { "pbuf",    2.0,    40,   200,  1.0 },
+    { "long",    1 / 600.0, 64, 512, 6 * 3600.0 },
+};
+static const size_t TRAFFIC_COUNT = sizeof(TRAFFIC) / sizeof(TRAFFIC[0]);
+
+struct Options {
+    uint32_t days = 14;
+    size_t heapKb = 96;
+    uint32_t intervalMs = 5000;   // BME_DEFAULT_INTERVAL_MS
+    uint32_t seed = 1;
+};
+
+struct DayRow {
+    size_t freeBytes;
+    size_t largest;
+    size_t minLargest;
+    size_t holes;   // free blocks
+};
+
+struct Result {
+    std::vector<DayRow> days;
+    uint64_t samples = 0;
+    uint64_t sampleAllocs = 0;
+    uint64_t failures = 0;
+};
+
+enum class SamplePath { Fixed, String };
+
+class Soak {
+public:
+    Soak(const Options& opt, SamplePath path) : _opt(opt), _path(path), _arena(opt.heapKb * 1024), _rng(opt.seed) {
+        for (size_t i = 0; i < TRAFFIC_COUNT; i++) _nextArrivalMs[i] = arrivalGap(TRAFFIC[i]);
+    }
+
+    Result run() {
+        Result r;
+        g_arena = &_arena;
+        const uint64_t dayMs = 24ull * 3600 * 1000;
+        for (uint32_t day = 0; day < _opt.days; day++) {
+            size_t minLargest = SIZE_MAX;
+            for (uint64_t t = day * dayMs; t < (day + 1) * dayMs; t += _opt.intervalMs) {
+                runSample(t, r);
+                minLargest = std::min(minLargest, _arena.largestFree());
+            }
+            r.days.push_back({ _arena.freeBytes(), _arena.largestFree(), minLargest, _arena.freeBlocks() });
+        }
+        r.failures = _arena.failures();
+        g_arena = nullptr;
+        return r;
+    }
+
+private:
+    struct Release {
+        uint64_t atMs;
+        void* p;
+        bool operator>(const Release& o) const { return atMs > o.atMs; }
+    };
+
+    Options _opt;
+    SamplePath _path;
+    Arena _arena;
+    std::mt19937 _rng;
+    uint64_t _nextArrivalMs[TRAFFIC_COUNT];
+    std::priority_queue<Release, std::vector<Release>, std::greater<Release>> _releases;
+
+    uint64_t arrivalGap(const Traffic& t) {
+        return (uint64_t)std::ceil(std::exponential_distribution<double>(t.perSec)(_rng) * 1000);
+    }
+
+    // Background allocations and frees due before tMs, in time order
+    void advance(uint64_t tMs) {
+        for (;;) {
+            size_t next = TRAFFIC_COUNT;
+            uint64_t at = tMs;
+            for (size_t i = 0; i < TRAFFIC_COUNT; i++) {
+                if (_nextArrivalMs[i] < at) {
+                    at = _nextArrivalMs[i];
+                    next = i;
+                }
+            }
+            if (!_releases.empty() && _releases.top().atMs <= at) {
+                _arena.free(_releases.top().p);
+                _releases.pop();
+                continue;
+            }
+            if (next == TRAFFIC_COUNT) break;
+
+            const Traffic& t = TRAFFIC[next];
+            size_t size = std::uniform_int_distribution<size_t>(t.minSize, t.maxSize)(_rng);
+            double life = std::exponential_distribution<double>(1 / t.meanLifeS)(_rng);
+            if (void* p = _arena.alloc(size)) _releases.push({ at + (uint64_t)(life * 1000), p });
+            _nextArrivalMs[next] = at + std::max<uint64_t>(1, arrivalGap(t));
+        }
+    }
+
+    void runSample(uint64_t tMs, Result& r) {
+        advance(tMs);
+        fakeClockSet(tMs * 1000);
+        uint64_t before = g_sampleAllocs;
+        if (_path == SamplePath::Fixed) {
+            sampleFixed(tMs);
+        } else {
+            sampleString(tMs);
+        }
+        r.sampleAllocs += g_sampleAllocs - before;
+        r.samples++;
+    }
+
+    // The sample block of Bridge.ino loop(), minus the BME and SD calls
+    void sampleFixed(uint64_t tMs) {
+        static uint16_t logSeq = 0;
+        g_inSample = true;
+        RTCDateTime dt = rtcGetDateTime();
+        char stamp[RTC_TIMESTAMP_LEN];
+        rtcFormatTimestamp(dt, stamp, sizeof(stamp));
+
+        LogRecord rec = {};
+        rec.epoch        = dt.valid ? dt.epoch : millis() / 1000;
+        rec.seq          = logSeq++;
+        rec.flags        = dt.valid ? 0 : LOG_FLAG_UPTIME;
+        rec.channelCount = 4;
+        rec.ch[0]        = log_quantize(21.5f, 100);
+        rec.ch[1]        = log_quantize(45.0f, 100);
+        rec.ch[2]        = log_quantize(1013.2f, 10);
+        rec.ch[3]        = log_quantize(120.0f, 10);
+        log_record_seal(&rec);
+        g_inSample = false;
+
+        advance(tMs + SD_WRITE_MS);
+        g_inSample = true;
+        Serial.printf("Logged: %s\n", stamp);
+        g_inSample = false;
+        advance(tMs + SAMPLE_PATH_MS);
+    }
+
+    // Arduino String: chars inline up to 11, otherwise a heap buffer of
+    // exactly length + 1, regrown on every concat
+    struct ModelString {
+        Arena& arena;
+        size_t len = 0;
+        void* buf = nullptr;
+
+        void append(size_t n) {
+            len += n;
+            if (len <= 11) return;
+            g_sampleAllocs++;
+            if (void* p = arena.realloc(buf, len + 1)) buf = p;
+        }
+        ~ModelString() { arena.free(buf); }
+    };
+
+    void sampleString(uint64_t tMs) {
+        RTCDateTime dt = rtcGetDateTime();
+        char date[16], time[16];
+        snprintf(date, sizeof(date), "%u-%u-%u", dt.day, dt.month, dt.year);
+        snprintf(time, sizeof(time), "%u:%u:%u", dt.hour, dt.minute, dt.second);
+
+        ModelString timestamp{ _arena };   // RTCDateTime::timestamp
+        timestamp.append(19);
+
+        advance(tMs + SD_WRITE_MS);
+        {
+            ModelString line{ _arena };    // "Logged: " + dateStr + " " + timeStr
+            line.append(8);
+            line.append(strlen(date));
+            line.append(1);
+            line.append(strlen(time));
+        }
+        advance(tMs + SAMPLE_PATH_MS);
+    }
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--days N] [--heap KB] [--interval MS] [--seed S]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (a == "--days") opt.days = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--heap") opt.heapKb = strtoul(argv[++i], nullptr, 10);
+        else if (a == "--interval") opt.intervalMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--seed") opt.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (opt.days == 0 || opt.heapKb == 0 || opt.intervalMs < SAMPLE_PATH_MS) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Serial.setQuiet(true);
+    rtcInit();
+
+    Result fixed = Soak(opt, SamplePath::Fixed).run();
+    Result legacy = Soak(opt, SamplePath::String).run();
+
+    printf("%u days, %zu KB heap, a sample every %u ms\n\n", opt.days, opt.heapKb, opt.intervalMs);
+    printf("%4s | %-35s | %-35s\n", "", "String path", "fixed path");
+    printf("%4s | %9s %9s %9s %5s | %9s %9s %9s %5s\n", "day", "free", "largest", "min", "holes", "free",
+           "largest", "min", "holes");
+    for (uint32_t d = 0; d < opt.days; d++) {
+        const DayRow& s = legacy.days[d];
+        const DayRow& f = fixed.days[d];
+        printf("%4u | %9zu %9zu %9zu %5zu | %9zu %9zu %9zu %5zu\n", d + 1, s.freeBytes, s.largest,
+               s.minLargest, s.holes, f.freeBytes, f.largest, f.minLargest, f.holes);
+    }
+    printf("\nallocations per sample: String %.2f (modelled), fixed %.2f (measured)\n",
+           (double)legacy.sampleAllocs / legacy.samples, (double)fixed.sampleAllocs / fixed.samples);
+    printf("failed allocations:     String %llu, fixed %llu\n", (unsigned long long)legacy.failures,
+           (unsigned long long)fixed.failures);
+    return fixed.sampleAllocs == 0 ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+// notify_check — ordering and throughput of the Bridge's BLE notification
+// queue (Bridge/ble_notify.cpp) against a fake characteristic.
+//
+//   notify_check [--seconds N] [--debug-rate LINES_PER_SEC] [--seed S]
+//
+// The fake characteristic behaves like the NimBLE TX path: notifications go
+// into a few stack buffers, and a buffer is freed when a connection event
+// drains it (NOTIFY_PER_EVENT per CONN_INTERVAL_MS). send() is refused
+// while the buffers are full, so the queue's retry path runs all the time.
+//
+// A commissioning session is simulated on the virtual millis() clock. The
+// Commissioner's ESP_LOG output arrives as debug lines at --debug-rate, and
+// ACK/STATUS lines arrive as protocol lines. loop() pumps the queue every
+// millisecond. The session runs once per MTU in MTUS and then drains.
+//
+// The received byte stream is split on '\n', and the run fails (exit 1) if:
+//   - a notification is larger than MTU - 3,
+//   - a protocol or debug line that the queue accepted is missing,
+//     duplicated, changed or out of order within its class,
+//   - a line arrives that was never accepted.
+// For each MTU the tool prints delivered lines/s and bytes/s, notifications
+// sent, lines coalesced, debug drops and the worst protocol line latency.
+// It also prints how many notifications the old one-notify-per-line path
+// would have needed and how many of those lines it would have truncated.
+//
+// Last, a second thread plays the BLE task reconnecting over and over:
+// bleNotifyReset(), then lines tagged with the new connection, while the
+// main thread pumps. Any notification carrying a line from before the
+// latest reset fails the run.
+
+#include <Arduino.h>
+#include "ble_notify.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint32_t CONN_INTERVAL_MS  = 15;
+static const uint32_t NOTIFY_PER_EVENT  = 4;
+static const size_t   STACK_BUFFERS     = 6;
+static const uint32_t PROTOCOL_EVERY_MS = 200;
+static const uint32_t DRAIN_MS          = 60000;
+static const uint16_t MTUS[] = { BLE_NOTIFY_DEFAULT_MTU, 185, 247 };
+static const uint32_t RACE_RESETS       = 20000;
+static const size_t   RACE_LINE_LEN     = 10;   // "G%08u\n": two per default-MTU notification
+
+// --- Fake characteristic ---
+struct FakeCharacteristic {
+    uint16_t mtu = BLE_NOTIFY_DEFAULT_MTU;
+    std::deque<std::string> buffers;   // notifications waiting for a connection event
+    std::string received;              // bytes delivered to the phone, in order
+    uint32_t nextEventMs = 0;
+    uint32_t oversized = 0;
+
+    bool notify(const uint8_t* data, size_t len) {
+        if (len > (size_t)(mtu - 3)) oversized++;
+        if (buffers.size() == STACK_BUFFERS) {
+            return false;
+        }
+        buffers.emplace_back((const char*)data, len);
+        return true;
+    }
+
+    void connectionEvent(uint32_t now) {
+        if (now < nextEventMs) return;
+        nextEventMs = now + CONN_INTERVAL_MS;
+        for (uint32_t i = 0; i < NOTIFY_PER_EVENT && !buffers.empty(); i++) {
+            received += buffers.front();
+            buffers.pop_front();
+        }
+    }
+};
+
+static FakeCharacteristic characteristic;
+
+static bool fakeSend(const uint8_t* data, size_t len) {
+    return characteristic.notify(data, len);
+}
+
+// --- Session ---
+struct Sent {
+    std::string line;
+    uint32_t atMs;
+};
+
+struct Result {
+    double linesPerSec;
+    double bytesPerSec;
+    uint32_t packets;
+    uint32_t coalesced;
+    uint32_t debugDrops;
+    uint32_t protocolDrops;
+    uint32_t worstProtocolMs;
+    uint32_t perLineNotifies;
+    uint32_t perLineTruncated;
+    uint32_t errors;
+};
+
+static std::string debugLine(std::mt19937& rng, uint32_t seq, uint32_t now) {
+    static const char* TEXT[] = {
+        "commissioner: Joiner session started",
+        "joiner_manager: PSKd accepted, waiting for DTLS handshake to finish",
+        "coap: tx 0.02 con mid=4217",
+        "openthread: [N] MeshForwarder-: Received IPv6 UDP msg, len:84, chksum:5a1c, ecn:no",
+    };
+    char buf[BLE_NOTIFY_LINE_MAX];
+    snprintf(buf, sizeof(buf), "D%u I (%u) %s", seq, now, TEXT[rng() % 4]);
+    return buf;
+}
+
+// Matches each complete line received so far against what was accepted
+class Receiver {
+public:
+    Receiver(const std::vector<Sent>& protocol, const std::vector<Sent>& debug, Result& r)
+        : _protocol(protocol), _debug(debug), _r(r) {}
+
+    void scan(const std::string& rx, uint32_t now) {
+        size_t nl;
+        while ((nl = rx.find('\n', _pos)) != std::string::npos) {
+            std::string line = rx.substr(_pos, nl - _pos);
+            _pos = nl + 1;
+            _bytes += line.size() + 1;
+            _lines++;
+            if (!line.empty() && line[0] == 'P' && _p < _protocol.size() && line == _protocol[_p].line) {
+                _r.worstProtocolMs = std::max(_r.worstProtocolMs, now - _protocol[_p].atMs);
+                _p++;
+            } else if (!line.empty() && line[0] == 'D' && _d < _debug.size() && line == _debug[_d].line) {
+                _d++;
+            } else {
+                _r.errors++;
+            }
+        }
+    }
+
+    bool complete() const { return _p == _protocol.size() && _d == _debug.size(); }
+    bool partial(const std::string& rx) const { return _pos != rx.size(); }
+    size_t lines() const { return _lines; }
+    size_t bytes() const { return _bytes; }
+
+private:
+    const std::vector<Sent>& _protocol;
+    const std::vector<Sent>& _debug;
+    Result& _r;
+    size_t _pos = 0, _p = 0, _d = 0, _lines = 0, _bytes = 0;
+};
+
+static Result runSession(uint16_t mtu, uint32_t seconds, uint32_t debugRate, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::exponential_distribution<double> debugGap(debugRate / 1000.0);
+
+    bleNotifyReset();
+    bleNotifySetMtu(mtu);
+    characteristic = FakeCharacteristic();
+    characteristic.mtu = mtu;
+    BleNotifyStats before = bleNotifyGetStats();
+
+    Result r = {};
+    std::vector<Sent> protocol, debug;
+    Receiver rx(protocol, debug, r);
+
+    uint32_t protoSeq = 0, debugSeq = 0;
+    uint32_t start = millis();
+    uint32_t sessionEnd = start + seconds * 1000;
+    double nextDebug = start + debugGap(rng);
+    uint32_t nextProtocol = start;
+    uint32_t now = start;
+
+    for (; now < sessionEnd + DRAIN_MS; now++) {
+        fakeClockSet((uint64_t)now * 1000);
+        if (now < sessionEnd) {
+            while (nextDebug <= now) {
+                std::string line = debugLine(rng, debugSeq++, now);
+                if (bleNotifyEnqueue(line.c_str(), BLE_NOTIFY_DEBUG)) debug.push_back({ line, now });
+                nextDebug += debugGap(rng);
+            }
+            if (now >= nextProtocol) {
+                char line[64];
+                snprintf(line, sizeof(line), "P%u ACK ADD SUCCESS %08X", protoSeq++, (unsigned)rng());
+                if (bleNotifyEnqueue(line, BLE_NOTIFY_PROTOCOL)) protocol.push_back({ line, now });
+                nextProtocol += PROTOCOL_EVERY_MS;
+            }
+        }
+        bleNotifyPump();
+        characteristic.connectionEvent(now);
+        rx.scan(characteristic.received, now);
+        if (now >= sessionEnd && rx.complete()) break;
+    }
+
+    if (!rx.complete() || rx.partial(characteristic.received) || characteristic.oversized) r.errors++;
+
+    uint32_t elapsedMs = now - start + 1;
+    BleNotifyStats s = bleNotifyGetStats();
+    r.linesPerSec = rx.lines() * 1000.0 / elapsedMs;
+    r.bytesPerSec = rx.bytes() * 1000.0 / elapsedMs;
+    r.packets = s.packets - before.packets;
+    r.coalesced = s.coalesced - before.coalesced;
+    r.debugDrops = s.debugDrops - before.debugDrops;
+    r.protocolDrops = s.protocolDrops - before.protocolDrops;
+    for (const auto* set : { &protocol, &debug }) {
+        for (const Sent& sent : *set) {
+            r.perLineNotifies++;
+            if (sent.line.size() > (size_t)(mtu - 3)) r.perLineTruncated++;
+        }
+    }
+    return r;
+}
+
+// --- Reset against pump ---
+static std::atomic<uint32_t> connectionGen{0};
+static std::atomic<uint32_t> staleSends{0};
+
+static bool raceSend(const uint8_t* data, size_t len) {
+    for (size_t off = 0; off + RACE_LINE_LEN <= len; off += RACE_LINE_LEN) {
+        uint32_t gen = (uint32_t)strtoul(std::string((const char*)data + off + 1, 8).c_str(), nullptr, 10);
+        if (gen != connectionGen.load()) staleSends++;
+    }
+    return true;
+}
+
+static uint32_t runResetRace() {
+    bleNotifyBegin(raceSend);
+    std::atomic<bool> done{false};
+    std::thread bleTask([&] {
+        for (uint32_t i = 1; i <= RACE_RESETS; i++) {
+            bleNotifyReset();
+            connectionGen = i;
+            char line[16];
+            for (int k = 0; k < 4; k++) {
+                snprintf(line, sizeof(line), "G%08u", i);
+                bleNotifyEnqueue(line, BLE_NOTIFY_PROTOCOL);
+            }
+        }
+        done = true;
+    });
+    while (!done) bleNotifyPump();
+    bleTask.join();
+    bleNotifyPump();
+    bleNotifyBegin(fakeSend);
+    return staleSends.load();
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--seconds N] [--debug-rate LINES_PER_SEC] [--seed S]\n", prog);
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 30;
+    uint32_t debugRate = 60;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (a == "--seconds") seconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--debug-rate") debugRate = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--seed") seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (seconds == 0 || debugRate == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Serial.setQuiet(true);
+    fakeClockSet(0);
+    bleNotifyBegin(fakeSend);
+
+    printf("%u s session, %u debug lines/s, a protocol line every %u ms\n", seconds, debugRate,
+           PROTOCOL_EVERY_MS);
+    printf("fake stack: %zu buffers, %u notifications per %u ms connection event\n\n", STACK_BUFFERS,
+           NOTIFY_PER_EVENT, CONN_INTERVAL_MS);
+    printf("%4s | %8s %8s %7s %9s %6s %6s %7s | %9s %9s | %s\n", "mtu", "lines/s", "bytes/s", "packets",
+           "coalesced", "drops", "pdrops", "ack ms", "1:1 notif", "truncated", "order");
+
+    bool ok = true;
+    for (uint16_t mtu : MTUS) {
+        Result r = runSession(mtu, seconds, debugRate, seed);
+        bool pass = r.errors == 0 && r.protocolDrops == 0;
+        ok = ok && pass;
+        printf("%4u | %8.1f %8.0f %7u %9u %6u %6u %7u | %9u %9u | %s\n", mtu, r.linesPerSec, r.bytesPerSec,
+               r.packets, r.coalesced, r.debugDrops, r.protocolDrops, r.worstProtocolMs, r.perLineNotifies,
+               r.perLineTruncated, pass ? "ok" : "FAIL");
+    }
+
+    uint32_t stale = runResetRace();
+    printf("\nreset race: %u resets, %u stale lines sent | %s\n", RACE_RESETS, stale, stale ? "FAIL" : "ok");
+    return ok && stale == 0 ? 0 : 1;
+}
@@ -0,0 +1,364 @@
+// Runs the Commissioner's FORM_NET channel and PAN selection
+// (common/hvac_channel_select.h) over a simulated 2.4 GHz environment.
+//
+//   channel_plan [--wifi CH:DBM[,...]] [--pan CH:PANID[:DBM][,...]]
+//                [--duty P] [--mask HEX] [--no-energy] [--runs N] [--seed S]
+//   channel_plan --check
+//
+// Wi-Fi APs (channels 1-13) are 22 MHz wide: an 802.15.4 channel within
+// 8 MHz of the AP's centre sees its full level, one within 12 MHz 20 dB
+// less. Each AP is on the air for a fraction --duty of the time, so a
+// channel's energy sample catches it with that probability. Networks given
+// with --pan answer the active scan and add their level to the energy of
+// their channel. The floor is -100 dBm +/- 2 dB. --no-energy simulates a
+// radio without energy scan.
+//
+// With --runs N the scan is repeated with N seeds and the chosen channels
+// are counted. --check runs the built-in scenarios and exits 1 if any
+// selection is wrong.
+
+#include <hvac_channel_select.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+struct WifiAp {
+    int channel;
+    int dbm;
+};
+
+struct Pan {
+    int channel;
+    uint16_t pan_id;
+    int dbm;
+    uint8_t ext_pan_id[8];
+};
+
+struct Environment {
+    std::vector<WifiAp> wifi;
+    std::vector<Pan> pans;
+    double duty = 1.0;
+    uint32_t mask = HVAC_CHAN_ALL_MASK;
+    bool energy_scan = true;
+};
+
+static std::mt19937 rng_state;
+
+static uint32_t rng(void)
+{
+    return rng_state();
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--wifi CH:DBM[,...]] [--pan CH:PANID[:DBM][,...]] [--duty P]\n"
+            "          [--mask HEX] [--no-energy] [--runs N] [--seed S]\n"
+            "       %s --check\n",
+            argv0, argv0);
+}
+
+// Level the AP puts on an 802.15.4 channel, -128 dBm if none
+static int wifi_leak(const WifiAp &ap, int channel)
+{
+    int df = std::abs((2407 + 5 * ap.channel) - (2405 + 5 * (channel - HVAC_CHAN_MIN)));
+    if (df <= 8) return ap.dbm;
+    if (df <= 12) return ap.dbm - 20;
+    return -128;
+}
+
+static void survey(const Environment &env, uint32_t seed, hvac_chan_survey_t &s)
+{
+    rng_state.seed(seed);
+    std::uniform_int_distribution<int> jitter(-2, 2);
+    std::bernoulli_distribution on_air(env.duty);
+
+    hvac_chan_survey_init(&s, env.mask);
+    for (int c = HVAC_CHAN_MIN; c <= HVAC_CHAN_MAX; c++) {
+        int dbm = -100 + jitter(rng_state);
+        for (const WifiAp &ap : env.wifi) {
+            if (on_air(rng_state) && wifi_leak(ap, c) > dbm) dbm = wifi_leak(ap, c);
+        }
+        for (const Pan &p : env.pans) {
+            if (p.channel == c && p.dbm > dbm) dbm = p.dbm;
+        }
+        if (env.energy_scan && (env.mask >> c & 1u)) hvac_chan_note_energy(&s, (uint8_t)c, (int8_t)dbm);
+    }
+    for (const Pan &p : env.pans) {
+        if (env.mask >> p.channel & 1u) {
+            // Two routers answering: the survey must count the network once
+            hvac_chan_note_network(&s, (uint8_t)p.channel, p.pan_id, p.ext_pan_id, (int8_t)p.dbm);
+            hvac_chan_note_network(&s, (uint8_t)p.channel, p.pan_id, p.ext_pan_id, (int8_t)(p.dbm - 6));
+        }
+    }
+}
+
+struct Choice {
+    uint8_t channel;
+    uint16_t pan_id;
+    uint8_t ext_pan_id[8];
+};
+
+static Choice choose(const hvac_chan_survey_t &s)
+{
+    Choice c;
+    c.channel = hvac_chan_select(&s);
+    c.pan_id = hvac_chan_pick_pan(&s, rng);
+    hvac_chan_pick_ext_pan(&s, rng, c.ext_pan_id);
+    return c;
+}
+
+static void print_survey(const hvac_chan_survey_t &s, const Choice &c)
+{
+    printf("%4s %8s %5s %6s %9s\n", "ch", "energy", "nets", "cost", "neighbour");
+    for (uint8_t ch = HVAC_CHAN_MIN; ch <= HVAC_CHAN_MAX; ch++) {
+        int8_t e = s.energy[ch - HVAC_CHAN_MIN];
+        int16_t cost = hvac_chan_cost(&s, ch);
+        char energy[8] = "-", cost_s[8] = "-";
+        if (e != HVAC_CHAN_UNMEASURED) snprintf(energy, sizeof(energy), "%d", e);
+        if (cost != HVAC_CHAN_NO_COST) snprintf(cost_s, sizeof(cost_s), "%d", cost);
+        printf("%4u %8s %5u %6s %9d%s\n", ch, energy, s.networks_on[ch - HVAC_CHAN_MIN], cost_s,
+               hvac_chan_neighbour_excess(&s, ch), ch == c.channel ? "  <-" : "");
+    }
+    printf("\nchannel %u, PAN 0x%04X, ext PAN ", c.channel, c.pan_id);
+    for (uint8_t b : c.ext_pan_id) printf("%02x", b);
+    printf("\n");
+}
+
+// --- Parsing ---
+
+static bool parse_list(const char *arg, std::vector<std::vector<long>> &out)
+{
+    std::string s = arg;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t comma = s.find(',', start);
+        std::string item = s.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        std::vector<long> fields;
+        const char *p = item.c_str();
+        for (;;) {
+            char *end;
+            long v = strtol(p, &end, 0);
+            if (end == p) return false;
+            fields.push_back(v);
+            if (*end == '\0') break;
+            if (*end != ':') return false;
+            p = end + 1;
+        }
+        out.push_back(fields);
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return true;
+}
+
+static bool add_wifi(Environment &env, const char *arg)
+{
+    std::vector<std::vector<long>> items;
+    if (!parse_list(arg, items)) return false;
+    for (const auto &f : items) {
+        if (f.size() != 2 || f[0] < 1 || f[0] > 13) return false;
+        env.wifi.push_back({ (int)f[0], (int)f[1] });
+    }
+    return true;
+}
+
+static void add_pan(Environment &env, int channel, uint16_t pan_id, int dbm)
+{
+    Pan p = { channel, pan_id, dbm, {} };
+    // Deterministic ext PAN per PAN ID, as two sites built alike would have
+    for (int i = 0; i < 8; i++) p.ext_pan_id[i] = (uint8_t)(pan_id >> (i % 2 ? 0 : 8)) ^ (uint8_t)(0x5A + i);
+    env.pans.push_back(p);
+}
+
+static bool add_pans(Environment &env, const char *arg)
+{
+    std::vector<std::vector<long>> items;
+    if (!parse_list(arg, items)) return false;
+    for (const auto &f : items) {
+        if (f.size() < 2 || f.size() > 3 || !hvac_chan_valid((uint8_t)f[0]) || f[1] < 0 || f[1] > 0xFFFE) {
+            return false;
+        }
+        add_pan(env, (int)f[0], (uint16_t)f[1], f.size() == 3 ? (int)f[2] : -70);
+    }
+    return true;
+}
+
+// --- Built-in scenarios ---
+
+struct Scenario {
+    const char *name;
+    Environment env;
+    std::vector<int> allowed;   // channels the selection may pick
+    int min_pass_pct;           // of 100 seeds
+};
+
+static bool collides(const Environment &env, const Choice &c)
+{
+    for (const Pan &p : env.pans) {
+        if (p.pan_id == c.pan_id || memcmp(p.ext_pan_id, c.ext_pan_id, 8) == 0) return true;
+    }
+    return false;
+}
+
+static std::vector<Scenario> scenarios()
+{
+    std::vector<Scenario> list;
+
+    Scenario quiet = { "quiet band: the default channel", {}, { 15 }, 100 };
+    list.push_back(quiet);
+
+    Scenario wifi3 = { "Wi-Fi 1/6/11: a channel between them", {}, { 15, 20, 25, 26 }, 100 };
+    add_wifi(wifi3.env, "1:-45,6:-50,11:-55");
+    list.push_back(wifi3);
+
+    // The site this was written for: Wi-Fi on 1 and 6, and the neighbouring
+    // site's identical gateway on the old fixed channel and PAN
+    Scenario site = { "Wi-Fi 1/6 + neighbour on 15/0x1234", {}, { 20, 21, 22, 23, 24, 25, 26 }, 100 };
+    add_wifi(site.env, "1:-45,6:-50");
+    add_pan(site.env, 15, 0x1234, -60);
+    list.push_back(site);
+
+    Scenario bursty = { "bursty Wi-Fi 6 (30% duty)", {}, { 11, 12, 13, 14, 15, 20, 21, 22, 23, 24, 25, 26 }, 95 };
+    add_wifi(bursty.env, "6:-40");
+    bursty.env.duty = 0.3;
+    list.push_back(bursty);
+
+    Scenario crowded = { "networks on every channel but 22", {}, { 22 }, 100 };
+    for (int c = HVAC_CHAN_MIN; c <= HVAC_CHAN_MAX; c++) {
+        if (c != 22) add_pan(crowded.env, c, (uint16_t)(0x1000 + c), -80);
+    }
+    list.push_back(crowded);
+
+    Scenario no_energy = { "no energy scan, neighbour on 15", {}, { 20 }, 100 };
+    no_energy.env.energy_scan = false;
+    add_pan(no_energy.env, 15, 0x1234, -60);
+    list.push_back(no_energy);
+
+    Scenario masked = { "mask 11-14 only, Wi-Fi 1", {}, { 11, 12, 13, 14 }, 100 };
+    masked.env.mask = 0x00007800u;
+    add_wifi(masked.env, "1:-45");
+    list.push_back(masked);
+
+    return list;
+}
+
+static uint32_t scripted[4];
+static size_t scripted_next;
+
+static uint32_t scripted_rng(void)
+{
+    return scripted[scripted_next++ % 4];
+}
+
+static int run_checks()
+{
+    int failures = 0;
+    for (const Scenario &sc : scenarios()) {
+        int pass = 0, collisions = 0;
+        int first_bad = -1;
+        for (uint32_t seed = 1; seed <= 100; seed++) {
+            hvac_chan_survey_t s;
+            survey(sc.env, seed, s);
+            Choice c = choose(s);
+            bool ok = false;
+            for (int ch : sc.allowed) ok |= ch == c.channel;
+            if (ok) pass++;
+            else if (first_bad < 0) first_bad = c.channel;
+            if (collides(sc.env, c)) collisions++;
+        }
+        bool ok = pass >= sc.min_pass_pct && collisions == 0;
+        printf("%-4s %-40s %3d%% on an allowed channel", ok ? "ok" : "FAIL", sc.name, pass);
+        if (first_bad >= 0) printf(" (e.g. %d)", first_bad);
+        if (collisions) printf(", %d PAN collisions", collisions);
+        printf("\n");
+        failures += !ok;
+    }
+
+    // Random PAN IDs already heard, and broadcast, are drawn again
+    Environment env;
+    add_pan(env, 15, 0x1234, -60);
+    hvac_chan_survey_t s;
+    survey(env, 1, s);
+    scripted[0] = 0x1234;
+    scripted[1] = 0xFFFF;
+    scripted[2] = 0x4321;
+    scripted_next = 0;
+    uint16_t pan = hvac_chan_pick_pan(&s, scripted_rng);
+    bool ok = pan == 0x4321;
+    printf("%-4s %-40s got 0x%04X\n", ok ? "ok" : "FAIL", "PAN redrawn past in-use and broadcast", pan);
+    failures += !ok;
+
+    // A network answering from several routers counts once
+    ok = s.networks_on[15 - HVAC_CHAN_MIN] == 1 && s.network_count == 1;
+    printf("%-4s %-40s %u\n", ok ? "ok" : "FAIL", "repeated beacons merged", s.networks_on[15 - HVAC_CHAN_MIN]);
+    failures += !ok;
+
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    Environment env;
+    unsigned runs = 0;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--check") return run_checks();
+        if (a == "--no-energy") {
+            env.energy_scan = false;
+            continue;
+        }
+        const char *v = i + 1 < argc ? argv[++i] : nullptr;
+        if (!v) {
+            usage(argv[0]);
+            return 2;
+        }
+        bool ok = true;
+        if (a == "--wifi") {
+            ok = add_wifi(env, v);
+        } else if (a == "--pan") {
+            ok = add_pans(env, v);
+        } else if (a == "--duty") {
+            env.duty = atof(v);
+            ok = env.duty >= 0 && env.duty <= 1;
+        } else if (a == "--mask") {
+            env.mask = (uint32_t)strtoul(v, nullptr, 16);
+        } else if (a == "--runs") {
+            runs = (unsigned)atoi(v);
+        } else if (a == "--seed") {
+            seed = (uint32_t)strtoul(v, nullptr, 10);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    hvac_chan_survey_t s;
+    survey(env, seed, s);
+    Choice c = choose(s);
+    print_survey(s, c);
+    if (collides(env, c)) printf("PAN collision!\n");
+
+    if (runs) {
+        unsigned picked[HVAC_CHAN_MAX + 1] = {};
+        for (unsigned r = 0; r < runs; r++) {
+            survey(env, seed + 1 + r, s);
+            picked[hvac_chan_select(&s)]++;
+        }
+        printf("\nover %u more scans:", runs);
+        for (int ch = HVAC_CHAN_MIN; ch <= HVAC_CHAN_MAX; ch++) {
+            if (picked[ch]) printf(" %d:%u", ch, picked[ch]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
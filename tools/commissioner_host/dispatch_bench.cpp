@@ -0,0 +1,188 @@
+// dispatch_bench — commands/sec and worst-case parse time of the
+// Commissioner's command dispatcher (Commissioner/main/cmd_dispatch.c)
+// against the strdup/strtok parser it replaced.
+//
+//   dispatch_bench [--iterations N]
+//
+// The table has the names, argument counts and signing of uart_rx.c's
+// s_commands, with handlers that only read their arguments. Signed lines
+// are split at '|' without checking the HMAC, so only parsing is timed;
+// hmac_bench covers verification.
+//
+// The old parser is reproduced without its logging: strdup the line, strtok
+// the command word, copy the line into raw_debug[256], then strtok the
+// signed part again. Each call is timed on its own; the tool prints
+// commands/sec, p99 and the maximum per command type. On a desktop the
+// maximum is mostly scheduler preemption, so compare p99 between parsers.
+
+extern "C" {
+#include "cmd_dispatch.h"
+}
+#include "config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static volatile size_t g_sink;
+
+static void touch_args(int argc, char **argv)
+{
+    size_t n = 0;
+    for (int i = 0; i < argc; i++) n += strlen(argv[i]);
+    g_sink = g_sink + n;
+}
+
+static const cmd_entry_t COMMANDS[] = {
+    // name                  args  signed  handler
+    { "commissioner_start",  0,    false,  touch_args },
+    { "commissioner_stop",   0,    false,  touch_args },
+    { "FORM_NET",            1,    false,  touch_args },
+    { "add",                 2,    true,   touch_args },
+    { "ADD_BATCH",           1,    true,   touch_args },
+    { "UDP_STATS",           0,    false,  touch_args },
+    { "TELEMETRY",           0,    false,  touch_args },
+    { "SENSOR_CFG",          0,    true,   touch_args },
+    { "factory_reset",       0,    true,   touch_args },
+};
+static const size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static bool split_signature(char *line, char **cmd_part)
+{
+    char *sep = strrchr(line, '|');
+    if (sep) *sep = '\0';
+    *cmd_part = line;
+    return true;
+}
+
+// process_command() before the dispatch table, minus ESP_LOG and handlers
+static void legacy_parse(char *raw_input, cmd_verify_t verify)
+{
+    size_t len = strlen(raw_input);
+    while (len > 0 && (raw_input[len - 1] == '\r' || raw_input[len - 1] == '\n' || raw_input[len - 1] == ' ')) {
+        raw_input[--len] = '\0';
+    }
+    if (strlen(raw_input) == 0) return;
+
+    char *cmd_copy = strdup(raw_input);
+    if (!cmd_copy) return;
+    char *token = strtok(cmd_copy, " ");
+    if (token && (strcmp(token, "commissioner_start") == 0 || strcmp(token, "commissioner_stop") == 0 ||
+                  strcmp(token, "UDP_STATS") == 0 || strcmp(token, "TELEMETRY") == 0)) {
+        g_sink = g_sink + strlen(token);
+        free(cmd_copy);
+        return;
+    }
+    if (token && strcmp(token, "FORM_NET") == 0) {
+        char *net_name = strtok(NULL, " ");
+        if (net_name) g_sink = g_sink + strlen(net_name);
+        free(cmd_copy);
+        return;
+    }
+    free(cmd_copy);
+
+    char raw_debug[256];
+    strncpy(raw_debug, raw_input, sizeof(raw_debug) - 1);
+    raw_debug[sizeof(raw_debug) - 1] = '\0';
+    g_sink = g_sink + raw_debug[0];
+
+    char *cmd_str = NULL;
+    if (!verify(raw_input, &cmd_str)) return;
+    token = strtok(cmd_str, " ");
+    size_t n = 0;
+    while (token) {
+        n += strlen(token);
+        token = strtok(NULL, " ");
+    }
+    g_sink = g_sink + n;
+}
+
+struct Stats {
+    double perSec;
+    double p99Ns;
+    double maxNs;
+};
+
+template <typename Fn>
+static Stats time_calls(const std::string &line, uint32_t iterations, Fn fn)
+{
+    std::vector<char> buf(line.size() + 1);
+    std::vector<double> ns;
+    ns.reserve(iterations);
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        memcpy(buf.data(), line.c_str(), buf.size());
+        auto t0 = Clock::now();
+        fn(buf.data());
+        ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+    }
+    double total = std::chrono::duration<double>(Clock::now() - start).count();
+    std::sort(ns.begin(), ns.end());
+    return { total > 0 ? iterations / total : 0, ns[ns.size() * 99 / 100], ns.back() };
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0) iterations = 1;
+
+    static const char SIG[] = "|5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843";
+    std::string batch = "ADD_BATCH ";
+    for (int i = 0; i < JOINER_BATCH_MAX; i++) {
+        char item[40];
+        snprintf(item, sizeof(item), "%s00112233%08X:J01NME", i ? "," : "", i);
+        batch += item;
+    }
+    batch += std::string(" 120") + SIG;
+
+    struct Case {
+        const char *label;
+        std::string line;
+    };
+    const Case cases[] = {
+        { "FORM_NET", "FORM_NET HVAC-Site-01\r" },
+        { "TELEMETRY", "TELEMETRY" },
+        { "add", std::string("add 0011223344556677 J01NME 120") + SIG },
+        { "ADD_BATCH", batch },
+        { "unknown", "reboot now" },
+    };
+
+    // Every case must dispatch as uart_rx.c would
+    const cmd_result_t expected[] = { CMD_OK, CMD_OK, CMD_OK, CMD_OK, CMD_UNKNOWN };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        std::vector<char> buf(cases[i].line.begin(), cases[i].line.end());
+        buf.push_back('\0');
+        cmd_result_t res = cmd_dispatch(COMMANDS, COMMAND_COUNT, buf.data(), split_signature);
+        if (res != expected[i]) {
+            fprintf(stderr, "%s: dispatch returned %d, expected %d\n", cases[i].label, res, expected[i]);
+            return 1;
+        }
+    }
+
+    printf("%u calls per command\n\n", iterations);
+    printf("%-10s %6s | %12s %8s %8s | %12s %8s %8s\n", "command", "bytes", "table cmd/s", "p99 ns",
+           "max ns", "strtok cmd/s", "p99 ns", "max ns");
+    for (const Case &c : cases) {
+        Stats table = time_calls(c.line, iterations, [&](char *line) {
+            cmd_dispatch(COMMANDS, COMMAND_COUNT, line, split_signature);
+        });
+        Stats legacy = time_calls(c.line, iterations, [&](char *line) { legacy_parse(line, split_signature); });
+        printf("%-10s %6zu | %12.0f %8.0f %8.0f | %12.0f %8.0f %8.0f\n", c.label, c.line.size(), table.perSec,
+               table.p99Ns, table.maxNs, legacy.perSec, legacy.p99Ns, legacy.maxNs);
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+// Host fake of the ESP-IDF logger: to stderr when fake_log_enabled is set.
+// ESP_LOGE also counts into fake_log_errors, so a host check can tell that a
+// module reported a failure it does not return.
+#pragma once
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern int fake_log_enabled;
+extern unsigned long fake_log_errors;
+#ifdef __cplusplus
+}
+#endif
+
+#define FAKE_LOG(level, tag, fmt, ...) do {                                  \
+        if (fake_log_enabled) fprintf(stderr, level " (%s) " fmt "\n", tag, ##__VA_ARGS__); \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) do {                                          \
+        fake_log_errors++;                                                   \
+        FAKE_LOG("E", tag, fmt, ##__VA_ARGS__);                              \
+    } while (0)
+#define ESP_LOGW(tag, fmt, ...) FAKE_LOG("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) FAKE_LOG("I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do { } while (0)
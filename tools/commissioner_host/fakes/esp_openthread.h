@@ -0,0 +1,12 @@
+#pragma once
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+otInstance *esp_openthread_get_instance(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,14 @@
+// The host programs are single-threaded: the lock always succeeds.
+#pragma once
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool esp_openthread_lock_acquire(TickType_t block_ticks);
+void esp_openthread_lock_release(void);
+#ifdef __cplusplus
+}
+#endif
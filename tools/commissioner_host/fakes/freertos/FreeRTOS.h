@@ -0,0 +1,10 @@
+// Host fake of the FreeRTOS types used by the Commissioner; one tick = 1 ms.
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY      0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
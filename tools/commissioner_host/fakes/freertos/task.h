@@ -0,0 +1,14 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Virtual clock, driven by the host program
+TickType_t xTaskGetTickCount(void);
+void       fake_clock_set_ms(uint32_t ms);
+void       fake_clock_advance_ms(uint32_t ms);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+// Host stand-in for the mbedtls SHA-256 API (portable implementation in
+// fakes.c), so Joiner IDs and HMACs are computed for real.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t total;       // bytes absorbed
+    uint8_t  block[64];
+    size_t   used;        // bytes in block
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst, const mbedtls_sha256_context *src);
+int  mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224);
+int  mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen);
+int  mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32]);
+int  mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char output[32], int is224);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+// Host fake of the OpenThread commissioner API used by joiner_manager.c;
+// otCommissionerAddJoiner() is provided by the host program.
+#pragma once
+
+#include <stdint.h>
+#include "instance.h"
+
+typedef struct {
+    uint8_t m8[8];
+} otExtAddress;
+
+typedef enum {
+    OT_JOINER_INFO_TYPE_ANY       = 0,
+    OT_JOINER_INFO_TYPE_EUI64     = 1,
+    OT_JOINER_INFO_TYPE_DISCERNER = 2,
+} otJoinerInfoType;
+
+typedef struct {
+    otJoinerInfoType mType;
+    union {
+        otExtAddress mEui64;
+    } mSharedId;
+    uint32_t mExpirationTime;
+} otJoinerInfo;
+
+typedef enum {
+    OT_COMMISSIONER_JOINER_START     = 0,
+    OT_COMMISSIONER_JOINER_CONNECTED = 1,
+    OT_COMMISSIONER_JOINER_FINALIZE  = 2,
+    OT_COMMISSIONER_JOINER_END       = 3,
+    OT_COMMISSIONER_JOINER_REMOVED   = 4,
+} otCommissionerJoinerEvent;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+otError otCommissionerAddJoiner(otInstance *instance, const otExtAddress *eui64, const char *pskd,
+                                uint32_t timeout);
+#ifdef __cplusplus
+}
+#endif
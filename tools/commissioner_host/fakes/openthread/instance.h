@@ -0,0 +1,5 @@
+#pragma once
+
+#include "error.h"
+
+typedef struct otInstance otInstance;
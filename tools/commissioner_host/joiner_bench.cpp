@@ -0,0 +1,283 @@
+// joiner_bench — ADD_BATCH throughput of the Commissioner's joiner manager
+// (Commissioner/main/joiner_manager.c, built against
+// tools/commissioner_host/fakes) against a simulated set of joiners.
+//
+//   joiner_bench [-v] [--devices N] [--ot-slots N[,N...]] [--join-ms MIN-MAX]
+//                [--fail P] [--timeout S] [--remove-delay S] [--no-wildcard]
+//                [--seed S]
+//
+// The OpenThread commissioner is modelled by its joiner table: --ot-slots
+// entries (OPENTHREAD_CONFIG_COMMISSIONER_MAX_JOINER_ENTRIES), one of them
+// held by the wildcard joiner the Commissioner adds when it becomes active.
+// A device joins MIN-MAX ms after it is registered (FINALIZE, END); its
+// entry is removed --remove-delay seconds later, as OpenThread does after
+// a successful join (REMOVED). A fraction --fail of the devices never
+// shows up and is removed when its window of --timeout seconds closes.
+//
+// Devices go out in ADD_BATCH commands of up to JOINER_BATCH_MAX, each sent
+// as soon as the previous one reported BATCH DONE, and time is virtual. For
+// each table size the tool prints the wall time, devices per minute and
+// the rate the Commissioner itself reported in BATCH DONE.
+
+extern "C" {
+#include "joiner_manager.h"
+}
+#include "config.h"
+#include "freertos/task.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int fake_log_enabled;
+
+struct Options {
+    unsigned devices = 48;
+    std::vector<unsigned> ot_slots = { 2, 4, JOINER_TABLE_SIZE + 1, 16 };
+    uint32_t join_min_ms = 3000;
+    uint32_t join_max_ms = 12000;
+    double fail = 0.05;
+    uint32_t timeout_s = 120;
+    uint32_t remove_delay_s = 20;
+    bool wildcard = true;
+    uint32_t seed = 1;
+};
+
+// --- Simulated OpenThread joiner table ---
+struct OtJoiner {
+    bool wildcard;
+    otExtAddress eui64;
+    uint32_t deadline_ms;
+    uint32_t join_at_ms;    // 0: never joins
+    uint32_t remove_at_ms;  // set once joined
+};
+
+static Options opt;
+static std::mt19937 rng;
+static std::vector<OtJoiner> ot_table;
+static unsigned ot_capacity;
+
+// Outcome of the running batch, from the events the Commissioner emits
+static bool batch_done;
+static unsigned done_joined, done_failed;
+static unsigned long reported_rate_sum;
+static unsigned batches;
+
+static uint32_t now_ms()
+{
+    return xTaskGetTickCount();
+}
+
+extern "C" otError otCommissionerAddJoiner(otInstance *, const otExtAddress *eui64, const char *,
+                                           uint32_t timeout)
+{
+    if (ot_table.size() >= ot_capacity) return OT_ERROR_NO_BUFS;
+
+    OtJoiner j = {};
+    j.wildcard = eui64 == nullptr;
+    if (eui64) j.eui64 = *eui64;
+    j.deadline_ms = now_ms() + timeout * 1000;
+    if (!j.wildcard && !std::bernoulli_distribution(opt.fail)(rng)) {
+        j.join_at_ms = now_ms() + std::uniform_int_distribution<uint32_t>(opt.join_min_ms, opt.join_max_ms)(rng);
+    }
+    ot_table.push_back(j);
+    return OT_ERROR_NONE;
+}
+
+extern "C" void uart_link_event(const char *fmt, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (fake_log_enabled) fprintf(stderr, "%8.1f EVENT %s\n", now_ms() / 1000.0, line);
+
+    unsigned joined, failed;
+    unsigned long ms, rate;
+    if (sscanf(line, "BATCH DONE joined=%u failed=%u ms=%lu rate=%lu/min", &joined, &failed, &ms, &rate) == 4) {
+        batch_done = true;
+        done_joined += joined;
+        done_failed += failed;
+        reported_rate_sum += rate;
+        batches++;
+    }
+}
+
+static void deliver(otCommissionerJoinerEvent event, const otExtAddress &eui64)
+{
+    otJoinerInfo info = {};
+    info.mType = OT_JOINER_INFO_TYPE_EUI64;
+    info.mSharedId.mEui64 = eui64;
+    char eui[JOINER_EUI64_STR_LEN];
+    joiner_manager_on_event(event, &info, nullptr, eui);
+}
+
+// One step of the simulated joiners. Events are collected first, as
+// delivering them registers the next wave into ot_table.
+static void step()
+{
+    struct Pending {
+        otCommissionerJoinerEvent event;
+        otExtAddress eui64;
+    };
+    std::vector<Pending> events;
+    uint32_t now = now_ms();
+
+    for (size_t i = 0; i < ot_table.size();) {
+        OtJoiner &j = ot_table[i];
+        if (!j.wildcard && j.join_at_ms && !j.remove_at_ms && (int32_t)(now - j.join_at_ms) >= 0) {
+            events.push_back({ OT_COMMISSIONER_JOINER_FINALIZE, j.eui64 });
+            events.push_back({ OT_COMMISSIONER_JOINER_END, j.eui64 });
+            j.remove_at_ms = now + opt.remove_delay_s * 1000;
+        }
+        bool expired = !j.wildcard && !j.remove_at_ms && (int32_t)(now - j.deadline_ms) >= 0;
+        bool removed = j.remove_at_ms && (int32_t)(now - j.remove_at_ms) >= 0;
+        if (expired || removed) {
+            events.push_back({ OT_COMMISSIONER_JOINER_REMOVED, j.eui64 });
+            ot_table.erase(ot_table.begin() + i);
+        } else {
+            i++;
+        }
+    }
+    for (const Pending &p : events) deliver(p.event, p.eui64);
+    joiner_manager_poll();
+}
+
+struct Result {
+    uint32_t elapsed_ms;
+    unsigned joined, failed;
+    unsigned long reported_rate;
+};
+
+static Result run(unsigned slots)
+{
+    rng.seed(opt.seed);
+    ot_table.clear();
+    ot_capacity = slots;
+    batch_done = false;
+    done_joined = done_failed = 0;
+    reported_rate_sum = 0;
+    batches = 0;
+
+    // Start well clear of 0 so the manager's deadlines never sit on it
+    uint32_t start_ms = 1000000;
+    fake_clock_set_ms(start_ms);
+    if (opt.wildcard) otCommissionerAddJoiner(nullptr, nullptr, "J01NME", 0x7FFFFFFF / 1000);
+
+    unsigned next = 0;
+    const uint32_t limit_ms = start_ms + 24u * 3600 * 1000;
+    while (next < opt.devices && now_ms() < limit_ms) {
+        std::string pairs;
+        unsigned n = 0;
+        for (; n < JOINER_BATCH_MAX && next < opt.devices; n++, next++) {
+            char item[40];
+            snprintf(item, sizeof(item), "%s00112233%08X:J01NME", n ? "," : "", next);
+            pairs += item;
+        }
+
+        std::vector<char> buf(pairs.begin(), pairs.end());
+        buf.push_back('\0');
+        uint32_t count = 0;
+        batch_done = false;
+        otError err = joiner_batch_start(buf.data(), opt.timeout_s, &count);
+        if (err != OT_ERROR_NONE) {
+            fprintf(stderr, "ADD_BATCH rejected: %d\n", err);
+            break;
+        }
+        while (!batch_done && now_ms() < limit_ms) {
+            fake_clock_advance_ms(100);
+            step();
+        }
+    }
+
+    Result r;
+    r.elapsed_ms = now_ms() - start_ms;
+    r.joined = done_joined;
+    r.failed = done_failed;
+    r.reported_rate = batches ? reported_rate_sum / batches : 0;
+    return r;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-v] [--devices N] [--ot-slots N[,N...]] [--join-ms MIN-MAX] [--fail P]\n"
+            "          [--timeout S] [--remove-delay S] [--no-wildcard] [--seed S]\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-v") {
+            fake_log_enabled = 1;
+            continue;
+        }
+        if (a == "--no-wildcard") {
+            opt.wildcard = false;
+            continue;
+        }
+        const char *v = i + 1 < argc ? argv[++i] : nullptr;
+        if (!v) {
+            usage(argv[0]);
+            return 2;
+        }
+        bool ok = true;
+        if (a == "--devices") {
+            opt.devices = (unsigned)atoi(v);
+        } else if (a == "--ot-slots") {
+            opt.ot_slots.clear();
+            for (const char *p = v; *p;) {
+                char *end;
+                unsigned long n = strtoul(p, &end, 10);
+                if (end == p || n == 0) break;
+                opt.ot_slots.push_back((unsigned)n);
+                p = *end == ',' ? end + 1 : end;
+            }
+            ok = !opt.ot_slots.empty();
+        } else if (a == "--join-ms") {
+            ok = sscanf(v, "%u-%u", &opt.join_min_ms, &opt.join_max_ms) == 2 &&
+                 opt.join_min_ms <= opt.join_max_ms;
+        } else if (a == "--fail") {
+            opt.fail = atof(v);
+            ok = opt.fail >= 0 && opt.fail <= 1;
+        } else if (a == "--timeout") {
+            opt.timeout_s = (uint32_t)atoi(v);
+            ok = opt.timeout_s > 0 && opt.timeout_s <= JOINER_MAX_TIMEOUT_SEC;
+        } else if (a == "--remove-delay") {
+            opt.remove_delay_s = (uint32_t)atoi(v);
+        } else if (a == "--seed") {
+            opt.seed = (uint32_t)strtoul(v, nullptr, 10);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%u devices, join %u-%u ms, %.0f%% no-show, window %us, removal after %us, "
+           "JOINER_TABLE_SIZE %d%s\n\n",
+           opt.devices, opt.join_min_ms, opt.join_max_ms, opt.fail * 100, opt.timeout_s,
+           opt.remove_delay_s, JOINER_TABLE_SIZE, opt.wildcard ? ", wildcard joiner" : "");
+    printf("%8s %8s %8s %10s %12s %12s\n", "ot_slots", "joined", "failed", "time_s", "devices/min",
+           "reported/min");
+
+    for (unsigned slots : opt.ot_slots) {
+        Result r = run(slots);
+        double per_min = r.elapsed_ms ? r.joined * 60000.0 / r.elapsed_ms : 0;
+        printf("%8u %8u %8u %10.1f %12.1f %12lu\n", slots, r.joined, r.failed, r.elapsed_ms / 1000.0,
+               per_min, r.reported_rate);
+        if (r.joined + r.failed != opt.devices) {
+            printf("         %u devices never settled\n", opt.devices - r.joined - r.failed);
+        }
+    }
+    return 0;
+}
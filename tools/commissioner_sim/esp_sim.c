@@ -0,0 +1,534 @@
+// ESP-IDF stand-ins for running Commissioner/main on OpenThread's
+// simulation platform. One process is one Thread node.
+
+#define _GNU_SOURCE
+#include "esp_sim.h"
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_openthread_netif_glue.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_vfs_eventfd.h"
+#include "driver/uart.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "openthread/instance.h"
+#include "openthread/tasklet.h"
+#include "openthread/thread.h"
+#include "openthread-system.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOCK_WAKE_INTERVAL_MS  10     // re-kick the OT thread while waiting
+#define EVENT_QUEUE_LEN        16
+#define EVENT_MAX_HANDLERS     8
+#define EVENT_MAX_DATA         32
+
+static int    s_argc;
+static char **s_argv;
+
+void esp_sim_set_args(int argc, char *argv[])
+{
+    s_argc = argc;
+    s_argv = argv;
+}
+
+// --- Time ---
+
+static uint64_t monotonic_us(void)
+{
+    static uint64_t start_us;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+    if (!start_us) start_us = now;
+    return now - start_us;
+}
+
+uint32_t esp_sim_millis(void)       { return (uint32_t)(monotonic_us() / 1000u); }
+int64_t esp_timer_get_time(void)    { return (int64_t)monotonic_us(); }
+TickType_t xTaskGetTickCount(void)  { return (TickType_t)esp_sim_millis(); }
+
+static struct timespec deadline_after_ms(uint32_t ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += ms / 1000u;
+    ts.tv_nsec += (long)(ms % 1000u) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// --- Logging / errors / system ---
+
+static pthread_mutex_t s_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void esp_sim_log(char level, const char *tag, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    pthread_mutex_lock(&s_log_mutex);
+    fprintf(stderr, "%c (%lu) %s: ", level, (unsigned long)esp_sim_millis(), tag);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    pthread_mutex_unlock(&s_log_mutex);
+    va_end(args);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "ESP_ERR_UNKNOWN";
+    }
+}
+
+void esp_restart(void)
+{
+    ESP_LOGW("SIM", "esp_restart() requested, exiting");
+    fflush(stdout);
+    exit(0);
+}
+
+uint32_t esp_random(void)
+{
+    return ((uint32_t)random() << 16) ^ (uint32_t)random();
+}
+
+esp_err_t esp_netif_init(void)                                        { return ESP_OK; }
+esp_err_t esp_netif_attach(esp_netif_t *netif, void *driver_handle)   { (void)netif; (void)driver_handle; return ESP_OK; }
+esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t *c) { (void)c; return ESP_OK; }
+
+esp_netif_t *esp_netif_new(const esp_netif_config_t *config)
+{
+    static int s_netif;
+    (void)config;
+    return (esp_netif_t *)&s_netif;
+}
+
+void *esp_openthread_netif_glue_init(const esp_openthread_platform_config_t *config)
+{
+    (void)config;
+    return &s_argc;   // any non-NULL handle
+}
+
+// --- Tasks ---
+
+typedef struct {
+    TaskFunction_t  fn;
+    void           *arg;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    uint32_t        notify_count;
+} sim_task_t;
+
+static __thread sim_task_t *t_self;
+
+static sim_task_t *sim_task_new(TaskFunction_t fn, void *arg)
+{
+    sim_task_t *task = calloc(1, sizeof(*task));
+    if (!task) return NULL;
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_init(&task->mutex, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    return task;
+}
+
+// Threads not started by xTaskCreate (main, OpenThread platform) get a
+// task record the first time they need one.
+static sim_task_t *sim_task_self(void)
+{
+    if (!t_self) t_self = sim_task_new(NULL, NULL);
+    return t_self;
+}
+
+static void *task_trampoline(void *p)
+{
+    t_self = p;
+    t_self->fn(t_self->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)stack_depth;
+    (void)priority;
+
+    // Task records are never freed, like a static FreeRTOS TCB
+    sim_task_t *task = sim_task_new(fn, arg);
+    if (!task) return pdFAIL;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, task_trampoline, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_setname_np(thread, name);
+    pthread_detach(thread);
+    if (handle) *handle = task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) pthread_exit(NULL);
+    // Deleting other tasks is not used by the firmware
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep((useconds_t)ticks * 1000u);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    sim_task_t *task = handle;
+    pthread_mutex_lock(&task->mutex);
+    task->notify_count++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    sim_task_t *task = sim_task_self();
+    struct timespec until = deadline_after_ms(ticks_to_wait);
+
+    pthread_mutex_lock(&task->mutex);
+    while (task->notify_count == 0 && ticks_to_wait > 0) {
+        if (ticks_to_wait == portMAX_DELAY) {
+            pthread_cond_wait(&task->cond, &task->mutex);
+        } else if (pthread_cond_timedwait(&task->cond, &task->mutex, &until) != 0) {
+            break;
+        }
+    }
+    uint32_t count = task->notify_count;
+    if (count) task->notify_count = clear_on_exit ? 0 : count - 1;
+    pthread_mutex_unlock(&task->mutex);
+    return count;
+}
+
+// --- Mutexes ---
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    pthread_mutex_t *m = malloc(sizeof(*m));
+    if (m) pthread_mutex_init(m, NULL);
+    return m;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    if (ticks_to_wait == portMAX_DELAY) return pthread_mutex_lock(sem) == 0;
+    struct timespec until = deadline_after_ms(ticks_to_wait);
+    return pthread_mutex_timedlock(sem, &until) == 0;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return pthread_mutex_unlock(sem) == 0;
+}
+
+// --- UART0 over stdin/stdout ---
+
+static bool s_uart_installed;
+static pthread_mutex_t s_uart_tx_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+bool uart_is_driver_installed(uart_port_t uart_num) { return uart_num == UART_NUM_0 && s_uart_installed; }
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *cfg) { (void)uart_num; (void)cfg; return ESP_OK; }
+esp_err_t uart_set_pin(uart_port_t n, int tx, int rx, int rts, int cts) { (void)n; (void)tx; (void)rx; (void)rts; (void)cts; return ESP_OK; }
+esp_err_t uart_set_baudrate(uart_port_t uart_num, uint32_t baudrate) { (void)uart_num; (void)baudrate; return ESP_OK; }
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    (void)rx_buffer_size; (void)tx_buffer_size; (void)queue_size; (void)intr_alloc_flags;
+    if (uart_num != UART_NUM_0) return ESP_ERR_INVALID_ARG;
+    if (uart_queue) *uart_queue = NULL;
+    s_uart_installed = true;
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    if (uart_num != UART_NUM_0) return -1;
+
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    int timeout = ticks_to_wait == portMAX_DELAY ? -1 : (int)ticks_to_wait;
+    int rc = poll(&pfd, 1, timeout);
+    if (rc <= 0) return 0;
+
+    ssize_t n = read(STDIN_FILENO, buf, length);
+    if (n == 0) {
+        // Link closed: behave like an idle line rather than spinning
+        usleep((useconds_t)(timeout < 0 ? 1000 : timeout) * 1000u);
+        return 0;
+    }
+    return n < 0 ? 0 : (int)n;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    if (uart_num != UART_NUM_0) return -1;
+
+    pthread_mutex_lock(&s_uart_tx_mutex);
+    fflush(stdout);
+    const uint8_t *p = src;
+    size_t left = size;
+    while (left > 0) {
+        ssize_t n = write(STDOUT_FILENO, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        p += n;
+        left -= (size_t)n;
+    }
+    pthread_mutex_unlock(&s_uart_tx_mutex);
+    return (int)(size - left);
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    (void)uart_num;
+    (void)ticks_to_wait;
+    fflush(stdout);
+    return ESP_OK;
+}
+
+// --- Default event loop ---
+
+ESP_EVENT_DEFINE_BASE(OPENTHREAD_EVENT);
+
+typedef struct {
+    esp_event_base_t    base;
+    int32_t             id;
+    esp_event_handler_t handler;
+    void               *arg;
+} event_handler_entry_t;
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t          id;
+    uint8_t          data[EVENT_MAX_DATA];
+    bool             has_data;
+} event_item_t;
+
+static event_handler_entry_t s_handlers[EVENT_MAX_HANDLERS];
+static size_t                s_handler_count;
+static event_item_t          s_events[EVENT_QUEUE_LEN];
+static size_t                s_event_head, s_event_count;
+static bool                  s_event_loop_running;
+static pthread_mutex_t       s_event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t        s_event_cond = PTHREAD_COND_INITIALIZER;
+
+static void event_loop_task(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&s_event_mutex);
+        while (s_event_count == 0) pthread_cond_wait(&s_event_cond, &s_event_mutex);
+        event_item_t ev = s_events[s_event_head];
+        s_event_head = (s_event_head + 1) % EVENT_QUEUE_LEN;
+        s_event_count--;
+        size_t count = s_handler_count;
+        event_handler_entry_t handlers[EVENT_MAX_HANDLERS];
+        memcpy(handlers, s_handlers, sizeof(handlers));
+        pthread_mutex_unlock(&s_event_mutex);
+
+        for (size_t i = 0; i < count; i++) {
+            if (handlers[i].base != ev.base) continue;
+            if (handlers[i].id != ESP_EVENT_ANY_ID && handlers[i].id != ev.id) continue;
+            handlers[i].handler(handlers[i].arg, ev.base, ev.id, ev.has_data ? ev.data : NULL);
+        }
+    }
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    if (s_event_loop_running) return ESP_ERR_INVALID_STATE;
+    if (xTaskCreate(event_loop_task, "sys_evt", 4096, NULL, 20, NULL) != pdPASS) return ESP_FAIL;
+    s_event_loop_running = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    pthread_mutex_lock(&s_event_mutex);
+    if (s_handler_count >= EVENT_MAX_HANDLERS) {
+        pthread_mutex_unlock(&s_event_mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    s_handlers[s_handler_count++] = (event_handler_entry_t){ event_base, event_id, event_handler, event_handler_arg };
+    pthread_mutex_unlock(&s_event_mutex);
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+                         const void *event_data, size_t event_data_size, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (event_data_size > EVENT_MAX_DATA) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&s_event_mutex);
+    if (s_event_count == EVENT_QUEUE_LEN) {
+        pthread_mutex_unlock(&s_event_mutex);
+        return ESP_ERR_TIMEOUT;
+    }
+    event_item_t *ev = &s_events[(s_event_head + s_event_count) % EVENT_QUEUE_LEN];
+    ev->base = event_base;
+    ev->id = event_id;
+    ev->has_data = event_data != NULL;
+    if (event_data) memcpy(ev->data, event_data, event_data_size);
+    s_event_count++;
+    pthread_cond_signal(&s_event_cond);
+    pthread_mutex_unlock(&s_event_mutex);
+    return ESP_OK;
+}
+
+// --- OpenThread instance, lock and main loop ---
+//
+// The OpenThread thread holds s_ot_mutex except while other threads are
+// waiting for it. Waiters interrupt its select() inside otSysProcessDrivers()
+// with SIGUSR1 (installed without SA_RESTART, so select returns EINTR).
+
+static otInstance     *s_instance;
+static pthread_mutex_t s_ot_mutex;
+static pthread_t       s_ot_thread;
+static atomic_bool     s_ot_thread_valid;
+static atomic_int      s_lock_waiters;
+
+static void wake_signal_handler(int sig)
+{
+    (void)sig;
+}
+
+static void ot_state_changed(otChangedFlags flags, void *context)
+{
+    (void)context;
+    if (flags & OT_CHANGED_THREAD_ROLE) {
+        esp_event_post(OPENTHREAD_EVENT, OPENTHREAD_EVENT_ROLE_CHANGED, NULL, 0, 0);
+    }
+}
+
+__attribute__((constructor)) static void esp_sim_init_lock(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_ot_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = wake_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+}
+
+bool esp_openthread_lock_acquire(TickType_t block_ticks)
+{
+    if (atomic_load(&s_ot_thread_valid) && pthread_equal(pthread_self(), s_ot_thread)) {
+        pthread_mutex_lock(&s_ot_mutex);
+        return true;
+    }
+
+    uint32_t start = esp_sim_millis();
+    atomic_fetch_add(&s_lock_waiters, 1);
+    for (;;) {
+        if (atomic_load(&s_ot_thread_valid)) pthread_kill(s_ot_thread, SIGUSR1);
+
+        uint32_t waited = esp_sim_millis() - start;
+        uint32_t slice = LOCK_WAKE_INTERVAL_MS;
+        if (block_ticks != portMAX_DELAY && block_ticks - waited < slice) slice = block_ticks - waited;
+        struct timespec until = deadline_after_ms(slice);
+
+        if (pthread_mutex_timedlock(&s_ot_mutex, &until) == 0) {
+            if (s_instance) break;
+            pthread_mutex_unlock(&s_ot_mutex);   // not initialised yet
+            usleep(LOCK_WAKE_INTERVAL_MS * 1000u);
+        }
+        if (block_ticks != portMAX_DELAY && esp_sim_millis() - start >= block_ticks) {
+            atomic_fetch_sub(&s_lock_waiters, 1);
+            return false;
+        }
+    }
+    atomic_fetch_sub(&s_lock_waiters, 1);
+    return true;
+}
+
+void esp_openthread_lock_release(void)
+{
+    pthread_mutex_unlock(&s_ot_mutex);
+}
+
+otInstance *esp_openthread_get_instance(void)
+{
+    return s_instance;
+}
+
+esp_err_t esp_openthread_init(const esp_openthread_platform_config_t *init_config)
+{
+    (void)init_config;
+
+    pthread_mutex_lock(&s_ot_mutex);
+    s_ot_thread = pthread_self();
+    atomic_store(&s_ot_thread_valid, true);
+
+    otSysInit(s_argc, s_argv);
+    otInstance *instance = otInstanceInitSingle();
+    if (!instance) {
+        pthread_mutex_unlock(&s_ot_mutex);
+        return ESP_FAIL;
+    }
+    otSetStateChangedCallback(instance, ot_state_changed, NULL);
+    s_instance = instance;
+    ESP_LOGI("SIM", "OpenThread %s", otGetVersionString());
+    return ESP_OK;
+}
+
+esp_err_t esp_openthread_launch_mainloop(void)
+{
+    for (;;) {
+        otTaskletsProcess(s_instance);
+        otSysProcessDrivers(s_instance);
+
+        if (atomic_load(&s_lock_waiters) > 0) {
+            pthread_mutex_unlock(&s_ot_mutex);
+            while (atomic_load(&s_lock_waiters) > 0) usleep(100);
+            pthread_mutex_lock(&s_ot_mutex);
+        }
+    }
+    return ESP_OK;
+}
+
+// Tasklets are run every loop iteration; nothing to wake here.
+void otTaskletsSignalPending(otInstance *instance)
+{
+    (void)instance;
+}
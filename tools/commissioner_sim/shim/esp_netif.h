@@ -0,0 +1,14 @@
+#pragma once
+
+#include <assert.h>
+#include "esp_err.h"
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct {
+    int unused;
+} esp_netif_config_t;
+
+esp_err_t esp_netif_init(void);
+esp_netif_t *esp_netif_new(const esp_netif_config_t *config);
+esp_err_t esp_netif_attach(esp_netif_t *esp_netif, void *driver_handle);
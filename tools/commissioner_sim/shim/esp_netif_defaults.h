@@ -0,0 +1,5 @@
+#pragma once
+
+#include "esp_netif.h"
+
+#define ESP_NETIF_DEFAULT_OPENTHREAD() { 0 }
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_system.h"
+#include "esp_openthread_types.h"
+#include "openthread/instance.h"
+
+/**
+ * @brief Runs otSysInit() (simulation platform, node id from the command
+ *        line) and creates the single OpenThread instance.
+ *
+ * The calling thread becomes the OpenThread thread and holds the API lock.
+ */
+esp_err_t esp_openthread_init(const esp_openthread_platform_config_t *init_config);
+
+/**
+ * @brief Processes tasklets and simulated radio/alarms forever, handing the
+ *        lock to other threads between iterations.
+ */
+esp_err_t esp_openthread_launch_mainloop(void);
+
+otInstance *esp_openthread_get_instance(void);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief Take the OpenThread API lock (recursive), waking the OpenThread
+ *        thread out of its select() so it lets go promptly.
+ *
+ * Fails until esp_openthread_init() has created the instance.
+ */
+bool esp_openthread_lock_acquire(TickType_t block_ticks);
+
+void esp_openthread_lock_release(void);
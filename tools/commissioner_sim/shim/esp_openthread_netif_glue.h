@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_openthread_types.h"
+
+// No lwIP on the host: the Commissioner only uses OpenThread's own UDP API.
+void *esp_openthread_netif_glue_init(const esp_openthread_platform_config_t *config);
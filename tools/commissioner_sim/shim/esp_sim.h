@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+ * @brief Host (OpenThread simulation) stand-ins for the ESP-IDF APIs used by
+ *        Commissioner/main. Implemented in ../esp_sim.c.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int esp_err_t;
+
+#define ESP_OK                          0
+#define ESP_FAIL                        -1
+#define ESP_ERR_NO_MEM                  0x101
+#define ESP_ERR_INVALID_ARG             0x102
+#define ESP_ERR_INVALID_STATE           0x103
+#define ESP_ERR_TIMEOUT                 0x107
+#define ESP_ERR_NVS_NO_FREE_PAGES       0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND   0x1110
+
+/** Milliseconds since the process started (the FreeRTOS tick is 1 ms here). */
+uint32_t esp_sim_millis(void);
+
+/** argc/argv handed to otSysInit() by esp_openthread_init(). */
+void esp_sim_set_args(int argc, char *argv[]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_err.h"
+
+/** Exits the process; the simulated node does not reboot itself. */
+void esp_restart(void) __attribute__((noreturn));
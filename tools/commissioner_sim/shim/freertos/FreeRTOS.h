@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_sim.h"
+
+// 1 kHz tick, like the firmware's CONFIG_FREERTOS_HZ
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void    *TaskHandle_t;
+typedef void    *QueueHandle_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
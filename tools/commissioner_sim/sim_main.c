@@ -0,0 +1,27 @@
+// Entry point for one simulated Commissioner node:
+//
+//   commissioner_sim [simulation options] <node-id>
+//
+// stdin/stdout are the Bridge link (UART0), logs go to stderr. The
+// arguments are passed straight to the simulation platform's otSysInit().
+//
+// Nodes find each other over the simulation platform's localhost radio, so
+// a mesh is just more processes with distinct node ids, e.g.:
+//
+//   commissioner_sim 1                      # leader, FORM_NET on stdin
+//   ot-cli-ftd 2  -> ifconfig up / joiner start <PSKD> / thread start
+//   ot-cli-mtd 3  -> same, as a sleepy end device (mode -)
+
+#include "esp_sim.h"
+#include <unistd.h>
+
+void app_main(void);
+
+int main(int argc, char *argv[])
+{
+    esp_sim_set_args(argc, argv);
+    app_main();
+
+    // app_main() returns once its tasks are running, as on the board
+    for (;;) pause();
+}
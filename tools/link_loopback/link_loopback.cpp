@@ -0,0 +1,390 @@
+// link_loopback — request throughput and round-trip latency of the framed
+// Bridge <-> Commissioner link (common/hvac_link_frame.h) over a pty pair.
+//
+//   link_loopback [--requests N] [--baud B[,B...]] [--window W[,W...]]
+//                 [--service-us US] [--noise LINES_PER_S]
+//
+// The Bridge end sends signed "add" commands with up to W requests in
+// flight, after negotiating B with SET_BAUD as uartLinkNegotiateBaud() does.
+// The Commissioner end answers each with RSP_OK carrying the same id after
+// --service-us, and writes ESP_LOG-style console lines in between at
+// --noise lines per second.
+//
+// A pty has no line rate, so each end paces its writes to B: a write of n
+// bytes completes 10*n/B seconds after the previous one. Every answer must
+// match an outstanding request id and no frame may fail its CRC; console
+// text is counted but never taken for an answer. The exit status is
+// non-zero if anything was lost or mismatched.
+
+#include <hvac_link_frame.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    uint32_t requests = 200;
+    std::vector<uint32_t> bauds = { LINK_DEFAULT_BAUD, 921600 };
+    std::vector<uint32_t> windows = { 1, 4, 8 };
+    uint32_t serviceUs = 200;
+    uint32_t noisePerS = 20;
+};
+
+// Supported rates, as baud_supported() in Commissioner/main/uart_rx.c
+static bool baudSupported(uint32_t baud)
+{
+    return baud == 115200 || baud == 230400 || baud == 460800 || baud == 921600;
+}
+
+// One direction of the emulated UART
+class PacedWriter {
+public:
+    PacedWriter(int fd, uint32_t baud) : _fd(fd), _baud(baud), _free(Clock::now()) {}
+
+    void setBaud(uint32_t baud) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _baud = baud;
+    }
+
+    // Like uart_write_bytes(): one call goes out whole
+    bool write(const void* data, size_t len) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto start = std::max(Clock::now(), _free);
+        _free = start + std::chrono::microseconds((uint64_t)len * 10 * 1000000 / _baud);
+        std::this_thread::sleep_until(_free);
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        while (len > 0) {
+            ssize_t n = ::write(_fd, p, len);
+            if (n < 0) return false;
+            p += n;
+            len -= (size_t)n;
+        }
+        return true;
+    }
+
+    bool writeFrame(uint8_t type, uint8_t id, const void* payload, uint16_t len) {
+        uint8_t buf[LINK_MAX_FRAME];
+        size_t n = link_frame_encode(buf, sizeof(buf), type, id, payload, len);
+        return n > 0 && write(buf, n);
+    }
+
+private:
+    int _fd;
+    uint32_t _baud;
+    Clock::time_point _free;
+    std::mutex _mutex;
+};
+
+// --- Commissioner end ---
+struct CommissionerEnd {
+    int fd;
+    uint32_t serviceUs;
+    uint32_t noisePerS;
+    PacedWriter out;
+    std::atomic<bool> stop{ false };
+
+    CommissionerEnd(int fd_, const Options& opt)
+        : fd(fd_), serviceUs(opt.serviceUs), noisePerS(opt.noisePerS), out(fd_, LINK_DEFAULT_BAUD) {}
+
+    void run() {
+        std::thread noise([this] { logNoise(); });
+        link_decoder_t dec;
+        link_decoder_reset(&dec);
+        uint8_t buf[256];
+        while (!stop) {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 20) <= 0) continue;
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) break;
+            for (ssize_t i = 0; i < n; i++) {
+                if (link_decoder_feed(&dec, buf[i]) == LINK_DEC_FRAME) handle(dec.frame);
+            }
+        }
+        stop = true;
+        noise.join();
+    }
+
+    void handle(const link_frame_t& f) {
+        if (serviceUs) std::this_thread::sleep_for(std::chrono::microseconds(serviceUs));
+        char reply[64];
+        switch (f.type) {
+        case LINK_MSG_SET_BAUD: {
+            uint32_t baud = 0;
+            if (f.len == sizeof(baud)) memcpy(&baud, f.payload, sizeof(baud));
+            if (!baudSupported(baud)) {
+                int n = snprintf(reply, sizeof(reply), "ERROR BAUD %lu", (unsigned long)baud);
+                out.writeFrame(LINK_MSG_RSP_ERR, f.id, reply, (uint16_t)n);
+                return;
+            }
+            int n = snprintf(reply, sizeof(reply), "BAUD %lu", (unsigned long)baud);
+            out.writeFrame(LINK_MSG_RSP_OK, f.id, reply, (uint16_t)n);
+            out.setBaud(baud);
+            return;
+        }
+        case LINK_MSG_PING:
+            out.writeFrame(LINK_MSG_RSP_OK, f.id, nullptr, 0);
+            return;
+        case LINK_MSG_CMD: {
+            // "add <eui> <pskd>|<sig>" -> "JOINER_ADDED <eui>"
+            const char* eui = strchr((const char*)f.payload, ' ');
+            int n = snprintf(reply, sizeof(reply), "JOINER_ADDED %.16s", eui ? eui + 1 : "");
+            out.writeFrame(LINK_MSG_RSP_OK, f.id, reply, (uint16_t)n);
+            return;
+        }
+        default:
+            out.writeFrame(LINK_MSG_RSP_ERR, f.id, "ERROR UNKNOWN", 13);
+        }
+    }
+
+    void logNoise() {
+        if (noisePerS == 0) return;
+        auto period = std::chrono::microseconds(1000000 / noisePerS);
+        auto next = Clock::now();
+        uint32_t n = 0;
+        while (!stop) {
+            next += period;
+            std::this_thread::sleep_until(next);
+            char line[96];
+            int len = snprintf(line, sizeof(line),
+                               "I (%u) TELEMETRY: fd00::%x rssi=-61 lqi=255 temp=21.50 hum=45.0\r\n",
+                               n * 50, n & 0xFFFF);
+            out.write(line, (size_t)len);
+            n++;
+        }
+    }
+};
+
+// --- Bridge end ---
+struct Result {
+    uint32_t baud = 0;
+    uint32_t completed = 0;
+    double seconds = 0;
+    std::vector<double> rttUs;
+    uint64_t textBytes = 0;
+    uint32_t mismatched = 0;
+    uint32_t errors = 0;
+    uint32_t crcErrors = 0;
+};
+
+struct BridgeEnd {
+    int fd;
+    PacedWriter out;
+    link_decoder_t dec;
+    uint8_t nextId = 0;
+    Result& r;
+
+    BridgeEnd(int fd_, Result& r_) : fd(fd_), out(fd_, LINK_DEFAULT_BAUD), r(r_) { link_decoder_reset(&dec); }
+
+    uint8_t allocId() {
+        if (++nextId == 0) nextId = 1;
+        return nextId;
+    }
+
+    // Next frame from the Commissioner within timeoutMs; console text is counted
+    bool readFrame(link_frame_t& f, int timeoutMs) {
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;) {
+            int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left < 0) return false;
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, left) <= 0) return false;
+            uint8_t b;
+            if (read(fd, &b, 1) != 1) return false;
+            link_dec_result_t res = link_decoder_feed(&dec, b);
+            if (res == LINK_DEC_TEXT) r.textBytes++;
+            if (res == LINK_DEC_FRAME) {
+                f = dec.frame;
+                return true;
+            }
+        }
+    }
+
+    bool negotiate(uint32_t baud) {
+        if (baud == LINK_DEFAULT_BAUD) return true;
+        uint8_t id = allocId();
+        out.writeFrame(LINK_MSG_SET_BAUD, id, &baud, sizeof(baud));
+        link_frame_t f;
+        while (readFrame(f, 1000)) {
+            if (f.id != id) continue;
+            if (f.type != LINK_MSG_RSP_OK) return false;
+            out.setBaud(baud);
+            return true;
+        }
+        return false;
+    }
+
+    void run(uint32_t requests, uint32_t window) {
+        struct Pending {
+            uint8_t id;
+            Clock::time_point sent;
+        };
+        std::vector<Pending> inFlight;
+        static const char SIG[] = "|5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843";
+
+        uint32_t sent = 0;
+        auto start = Clock::now();
+        while (r.completed + r.errors < requests) {
+            while (inFlight.size() < window && sent < requests) {
+                char cmd[128];
+                int n = snprintf(cmd, sizeof(cmd), "add 00112233%08X J01NME%s", sent, SIG);
+                uint8_t id = allocId();
+                inFlight.push_back({ id, Clock::now() });
+                out.writeFrame(LINK_MSG_CMD, id, cmd, (uint16_t)n);
+                sent++;
+            }
+
+            link_frame_t f;
+            if (!readFrame(f, 2000)) break;
+            auto it = std::find_if(inFlight.begin(), inFlight.end(), [&](const Pending& p) { return p.id == f.id; });
+            if (it == inFlight.end()) {
+                r.mismatched++;
+                continue;
+            }
+            if (f.type == LINK_MSG_RSP_OK) {
+                r.rttUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - it->sent).count());
+                r.completed++;
+            } else {
+                r.errors++;
+            }
+            inFlight.erase(it);
+        }
+        r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        r.crcErrors = dec.crc_errors;
+    }
+};
+
+static bool openPair(int& bridgeFd, int& commissionerFd)
+{
+    if (openpty(&bridgeFd, &commissionerFd, nullptr, nullptr, nullptr) != 0) {
+        perror("openpty");
+        return false;
+    }
+    for (int fd : { bridgeFd, commissionerFd }) {
+        struct termios t;
+        tcgetattr(fd, &t);
+        cfmakeraw(&t);
+        tcsetattr(fd, TCSANOW, &t);
+    }
+    return true;
+}
+
+static bool runOne(const Options& opt, uint32_t baud, uint32_t window, Result& r)
+{
+    int bridgeFd, commissionerFd;
+    if (!openPair(bridgeFd, commissionerFd)) return false;
+
+    CommissionerEnd commissioner(commissionerFd, opt);
+    std::thread peer([&] { commissioner.run(); });
+
+    r.baud = baud;
+    BridgeEnd bridge(bridgeFd, r);
+    bool ok = bridge.negotiate(baud);
+    if (ok) bridge.run(opt.requests, window);
+
+    commissioner.stop = true;
+    peer.join();
+    close(bridgeFd);
+    close(commissionerFd);
+    return ok;
+}
+
+static bool parseList(const char* s, std::vector<uint32_t>& out)
+{
+    out.clear();
+    while (*s) {
+        char* end;
+        unsigned long v = strtoul(s, &end, 10);
+        if (end == s || v == 0) return false;
+        out.push_back((uint32_t)v);
+        s = *end == ',' ? end + 1 : end;
+    }
+    return !out.empty();
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--requests N] [--baud B[,B...]] [--window W[,W...]] [--service-us US]\n"
+            "          [--noise LINES_PER_S]\n",
+            argv0);
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[++i] : nullptr;
+        if (!v) {
+            usage(argv[0]);
+            return 2;
+        }
+        bool ok = true;
+        if (a == "--requests") {
+            opt.requests = (uint32_t)strtoul(v, nullptr, 10);
+            ok = opt.requests > 0;
+        } else if (a == "--baud") {
+            ok = parseList(v, opt.bauds);
+        } else if (a == "--window") {
+            ok = parseList(v, opt.windows) &&
+                 std::all_of(opt.windows.begin(), opt.windows.end(), [](uint32_t w) { return w < 255; });
+        } else if (a == "--service-us") {
+            opt.serviceUs = (uint32_t)strtoul(v, nullptr, 10);
+        } else if (a == "--noise") {
+            opt.noisePerS = (uint32_t)strtoul(v, nullptr, 10);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%u signed add requests per run, %u us service time, %u log lines/s\n\n", opt.requests,
+           opt.serviceUs, opt.noisePerS);
+    printf("%7s %6s %9s %10s %10s %10s %9s %6s\n", "baud", "window", "done", "req/s", "rtt_ms", "p99_ms",
+           "text_B", "bad");
+
+    bool allOk = true;
+    for (uint32_t baud : opt.bauds) {
+        for (uint32_t window : opt.windows) {
+            Result r;
+            if (!runOne(opt, baud, window, r)) {
+                printf("%7u %6u   SET_BAUD refused or unanswered\n", baud, window);
+                allOk = false;
+                continue;
+            }
+            std::sort(r.rttUs.begin(), r.rttUs.end());
+            double avg = 0;
+            for (double v : r.rttUs) avg += v;
+            avg = r.rttUs.empty() ? 0 : avg / r.rttUs.size();
+            double p99 = r.rttUs.empty() ? 0 : r.rttUs[std::min(r.rttUs.size() - 1, r.rttUs.size() * 99 / 100)];
+            uint32_t bad = r.mismatched + r.crcErrors + (opt.requests - r.completed);
+            printf("%7u %6u %9u %10.1f %10.2f %10.2f %9llu %6u\n", baud, window, r.completed,
+                   r.seconds > 0 ? r.completed / r.seconds : 0, avg / 1000, p99 / 1000,
+                   (unsigned long long)r.textBytes, bad);
+            if (bad) allOk = false;
+        }
+    }
+    return allOk ? 0 : 1;
+}
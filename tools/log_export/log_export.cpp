@@ -0,0 +1,254 @@
+// Host-side exporter for the binary SD logs written by the Bridge and the
+// sensor probes (format: common/hvac_log_record.h).
+//
+//   log_export <file.bin> [--from EPOCH] [--to EPOCH] [--slice OUT.bin]
+//
+// Default output is CSV on stdout, one column per channel. A channel whose
+// name ends in "_C" is followed by a derived "_F" column, so the probe logs
+// keep the Fahrenheit columns of the old CSV. Channels without a reading
+// (LOG_CH_MISSING) and records flagged LOG_FLAG_INVALID export as empty
+// fields. --slice writes the selected time range as
+// a new, self-contained binary log instead. The file is memory-mapped and the
+// range is located by binary search, so slicing a multi-GB card image costs
+// one pass over the epochs plus the size of the output.
+//
+// The range is in RTC time, so records on uptime (LOG_FLAG_UPTIME, written
+// while the RTC was unset) are never selected by it. Binary search needs the
+// RTC epochs in append order; the pass checks that, and a file with uptime
+// records or a clock that stepped back is filtered record by record instead.
+
+#include <hvac_log_record.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+struct MappedLog {
+    const uint8_t *base = nullptr;
+    size_t size = 0;
+    const LogFileHeader *header = nullptr;
+    const LogRecord *records = nullptr;
+    uint32_t count = 0;  // complete records; a torn tail is ignored
+};
+
+static bool map_log(const char *path, MappedLog &log)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(LogFileHeader)) {
+        fprintf(stderr, "%s: too small to be a log\n", path);
+        close(fd);
+        return false;
+    }
+
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+
+    log.base = static_cast<const uint8_t *>(p);
+    log.size = st.st_size;
+    log.header = reinterpret_cast<const LogFileHeader *>(log.base);
+    if (!log_header_valid(log.header)) {
+        fprintf(stderr, "%s: bad header (magic/version/CRC)\n", path);
+        return false;
+    }
+
+    log.records = reinterpret_cast<const LogRecord *>(log.base + log.header->headerSize);
+    log.count = (uint32_t)((log.size - log.header->headerSize) / sizeof(LogRecord));
+    return true;
+}
+
+// A record --from/--to can select: RTC time within [from, to]
+static bool in_range(const LogRecord &r, uint32_t from, uint32_t to)
+{
+    return !(r.flags & LOG_FLAG_UPTIME) && r.epoch >= from && r.epoch <= to;
+}
+
+// True if every record is on RTC time and epochs never decrease, i.e. the
+// file can be binary-searched; otherwise counts what breaks the order.
+static bool time_ordered(const MappedLog &log, uint32_t &uptime, uint32_t &backwards)
+{
+    uptime = backwards = 0;
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < log.count; i++) {
+        const LogRecord &r = log.records[i];
+        if (r.flags & LOG_FLAG_UPTIME) {
+            uptime++;
+            continue;
+        }
+        if (r.epoch < prev) backwards++;
+        prev = r.epoch;
+    }
+    return uptime == 0 && backwards == 0;
+}
+
+// First record with epoch >= t (only on a time_ordered() file).
+static uint32_t lower_bound(const MappedLog &log, uint32_t t)
+{
+    uint32_t lo = 0, hi = log.count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (log.records[mid].epoch < t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Records [first, last); with filter set, only those in_range(from, to).
+struct Selection {
+    uint32_t first, last;
+    bool filter;
+    uint32_t from, to;
+
+    bool selects(const LogRecord &r) const { return !filter || in_range(r, from, to); }
+};
+
+// Celsius channel ("DS1_C"): the CSV gets a derived Fahrenheit column after it
+static bool is_celsius(const LogChannelDesc &c)
+{
+    size_t n = strnlen(c.name, sizeof(c.name));
+    return n > 2 && c.name[n - 2] == '_' && c.name[n - 1] == 'C';
+}
+
+static void write_csv(const MappedLog &log, const Selection &sel)
+{
+    const LogFileHeader *h = log.header;
+
+    printf("Epoch,DateTime,Sensor,Seq");
+    for (int c = 0; c < h->channelCount; c++) {
+        const LogChannelDesc &d = h->channels[c];
+        int n = (int)strnlen(d.name, sizeof(d.name));
+        printf(",%.*s", n, d.name);
+        if (is_celsius(d)) printf(",%.*sF", n - 1, d.name);
+    }
+    printf("\n");
+
+    uint32_t badCrc = 0;
+    for (uint32_t i = sel.first; i < sel.last; i++) {
+        const LogRecord &r = log.records[i];
+        if (!sel.selects(r)) continue;
+        if (!log_record_valid(&r)) {
+            badCrc++;
+            continue;
+        }
+
+        char when[32];
+        if (r.flags & LOG_FLAG_UPTIME) {
+            snprintf(when, sizeof(when), "BOOT+%" PRIu32 "s", r.epoch);
+        } else {
+            time_t t = (time_t)r.epoch;
+            struct tm tm;
+            gmtime_r(&t, &tm);
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+        }
+
+        printf("%" PRIu32 ",%s,%u,%u", r.epoch, when, r.sensorId, r.seq);
+        for (int c = 0; c < h->channelCount; c++) {
+            const LogChannelDesc &d = h->channels[c];
+            bool have = c < r.channelCount && !(r.flags & LOG_FLAG_INVALID) &&
+                        r.ch[c] != LOG_CH_MISSING;
+            double v = have ? (double)r.ch[c] / d.scale : 0.0;
+            if (have) printf(",%.2f", v);
+            else printf(",");
+            if (!is_celsius(d)) continue;
+            if (have) printf(",%.2f", v * 9.0 / 5.0 + 32.0);
+            else printf(",");
+        }
+        printf("\n");
+    }
+
+    if (badCrc) fprintf(stderr, "skipped %" PRIu32 " records with bad CRC\n", badCrc);
+}
+
+static bool write_slice(const MappedLog &log, const Selection &sel, const char *out)
+{
+    FILE *f = fopen(out, "wb");
+    if (!f) {
+        perror(out);
+        return false;
+    }
+
+    bool ok = fwrite(log.header, log.header->headerSize, 1, f) == 1;
+    uint32_t written = 0;
+    if (!sel.filter) {
+        written = sel.last - sel.first;
+        if (ok && written > 0) {
+            ok = fwrite(&log.records[sel.first], sizeof(LogRecord), written, f) == written;
+        }
+    } else {
+        for (uint32_t i = sel.first; ok && i < sel.last; i++) {
+            if (!sel.selects(log.records[i])) continue;
+            ok = fwrite(&log.records[i], sizeof(LogRecord), 1, f) == 1;
+            written++;
+        }
+    }
+    ok = (fclose(f) == 0) && ok;
+
+    if (ok) fprintf(stderr, "wrote %" PRIu32 " records to %s\n", written, out);
+    return ok;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s <file.bin> [--from EPOCH] [--to EPOCH] [--slice OUT.bin]\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *path = argv[1];
+    const char *sliceOut = nullptr;
+    uint32_t from = 0, to = UINT32_MAX;
+
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--from") && i + 1 < argc) from = strtoul(argv[++i], nullptr, 0);
+        else if (!strcmp(argv[i], "--to") && i + 1 < argc) to = strtoul(argv[++i], nullptr, 0);
+        else if (!strcmp(argv[i], "--slice") && i + 1 < argc) sliceOut = argv[++i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    MappedLog log;
+    if (!map_log(path, log)) return 1;
+
+    Selection sel = { 0, log.count, false, from, to };
+    bool ranged = from != 0 || to != UINT32_MAX;
+    uint32_t uptime, backwards;
+    if (ranged && time_ordered(log, uptime, backwards)) {
+        sel.first = lower_bound(log, from);
+        sel.last = (to == UINT32_MAX) ? log.count : lower_bound(log, to + 1);
+        if (sel.last < sel.first) sel.last = sel.first;
+    } else if (ranged) {
+        fprintf(stderr,
+                "%s: not in time order (%" PRIu32 " uptime records, %" PRIu32 " clock steps back); "
+                "filtering every record, uptime records excluded\n",
+                path, uptime, backwards);
+        sel.filter = true;
+    }
+
+    if (sliceOut) return write_slice(log, sel, sliceOut) ? 0 : 1;
+
+    write_csv(log, sel);
+    return 0;
+}
@@ -0,0 +1,726 @@
+// Telemetry load generator for the Commissioner's UDP listener on a
+// simulated Thread mesh (see tools/commissioner_sim).
+//
+//   mesh_bench --commissioner PATH --ftd PATH --mtd PATH [options]
+//
+// Starts commissioner_sim as node 1, forms a network over its UART link
+// (stdin/stdout), commissions R router nodes (ot-cli-ftd) and N sleepy end
+// devices (ot-cli-mtd) through ADD_BATCH, then has every SED send UDP
+// datagrams to ff03::2:1234 - the same path SED_SENSOR_BARE uses - at the
+// configured rate and size. Each payload carries its sender, sequence
+// number and send time, so the [UDP_RX] lines the listener prints give
+// per-packet end-to-end latency (CLI send request -> listener output).
+//
+// Reported: sent / send errors / received / lost / duplicates, latency
+// percentiles, the listener's UDP_STATS (message pool high-water mark),
+// Commissioner CPU time per received packet and the SEDs' radio duty cycle
+// from OpenThread's radio time statistics ("radio stats"). --poll-ms auto
+// polls once per report interval, as SED_SENSOR_BARE's scheduler does.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+static const char *PSKD = "J01NME";
+static const int LEADER_NODE_ID = 1;
+
+struct Options {
+    std::string commissioner;
+    std::string ftd;
+    std::string mtd;
+    std::string workdir;
+    std::string dest = "ff03::2";
+    int seds = 10;
+    int routers = -1;             // -1: one per 8 SEDs
+    double rate = 1.0;            // datagrams per second per SED
+    int size = 32;                // payload bytes
+    int duration = 30;            // seconds of load
+    int batch = 8;                // devices per ADD_BATCH
+    int poll_ms = 1000;           // SED poll period, 0 = once per report interval
+};
+
+// SED_SENSOR_BARE keeps its poll period within a quarter of the child timeout
+static const int CHILD_TIMEOUT_S = 240;
+
+struct Child {
+    std::string name;
+    pid_t pid = -1;
+    int in = -1;                  // our end of its stdin
+    int out = -1;                 // our end of its stdout
+    std::string partial;
+    std::deque<std::string> lines;
+    bool dead = false;
+
+    // Node state (CLI nodes only)
+    int node_id = 0;
+    bool is_sed = false;
+    std::string eui64;
+    bool joined = false;
+    bool attached = false;
+    uint32_t seq = 0;
+    uint64_t next_send_us = 0;
+    uint32_t sent_ok = 0;
+    uint32_t send_errors = 0;
+    uint32_t pending_acks = 0;
+    std::vector<uint32_t> rx_seen; // bitmap of received sequence numbers
+};
+
+static std::vector<Child> g_children;   // [0] is the Commissioner
+
+// --- Receive-side accounting ---
+static uint32_t g_rx_total = 0;
+static uint32_t g_rx_dup = 0;
+static uint32_t g_rx_foreign = 0;      // not a bench payload
+static std::vector<double> g_latency_ms;
+static bool g_measuring = false;
+
+static uint64_t now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static bool spawn(Child &c, const std::vector<std::string> &args, const std::string &log_path)
+{
+    int to_child[2], from_child[2];
+    if (pipe(to_child) != 0 || pipe(from_child) != 0) {
+        perror("pipe");
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        int log_fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log_fd >= 0) dup2(log_fd, STDERR_FILENO);
+        close(to_child[0]);
+        close(to_child[1]);
+        close(from_child[0]);
+        close(from_child[1]);
+
+        std::vector<char *> argv;
+        for (const std::string &a : args) argv.push_back(const_cast<char *>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        perror(argv[0]);
+        _exit(127);
+    }
+
+    close(to_child[0]);
+    close(from_child[1]);
+    c.pid = pid;
+    c.in = to_child[1];
+    c.out = from_child[0];
+    fcntl(c.out, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+static void send_line(Child &c, const std::string &line)
+{
+    std::string data = line + "\n";
+    const char *p = data.data();
+    size_t left = data.size();
+    while (left > 0 && !c.dead) {
+        ssize_t n = write(c.in, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            c.dead = true;
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+}
+
+// "[UDP_RX] From [addr]:port -> s=<node>;q=<seq>;t=<us>;xxxx"
+static void on_udp_rx(const std::string &line, uint64_t rx_us)
+{
+    if (!g_measuring) return;
+    g_rx_total++;
+
+    size_t arrow = line.find("-> ");
+    unsigned node = 0, seq = 0;
+    unsigned long long sent_us = 0;
+    if (arrow == std::string::npos ||
+        sscanf(line.c_str() + arrow + 3, "s=%u;q=%u;t=%llu;", &node, &seq, &sent_us) != 3) {
+        g_rx_foreign++;
+        return;
+    }
+
+    for (Child &c : g_children) {
+        if (c.node_id != (int)node) continue;
+        if (c.rx_seen.size() <= seq / 32) c.rx_seen.resize(seq / 32 + 1, 0);
+        uint32_t bit = 1u << (seq % 32);
+        if (c.rx_seen[seq / 32] & bit) {
+            g_rx_dup++;
+            return;
+        }
+        c.rx_seen[seq / 32] |= bit;
+        break;
+    }
+    if (rx_us >= sent_us) g_latency_ms.push_back((double)(rx_us - sent_us) / 1000.0);
+}
+
+static void on_line(Child &c, std::string line, uint64_t rx_us)
+{
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    while (line.compare(0, 2, "> ") == 0) line.erase(0, 2);   // OT CLI prompt
+    if (line.empty()) return;
+
+    if (&c == &g_children[0] && line.compare(0, 8, "[UDP_RX]") == 0) {
+        on_udp_rx(line, rx_us);
+        return;
+    }
+
+    // Answers to pipelined "udp send" commands
+    if (c.pending_acks > 0 && (line == "Done" || line.compare(0, 6, "Error ") == 0)) {
+        c.pending_acks--;
+        if (line == "Done") c.sent_ok++;
+        else c.send_errors++;
+        return;
+    }
+    c.lines.push_back(line);
+}
+
+// Read whatever the children printed, waiting at most timeout_ms
+static void pump(int timeout_ms)
+{
+    std::vector<struct pollfd> fds;
+    for (Child &c : g_children) fds.push_back({ c.dead ? -1 : c.out, POLLIN, 0 });
+
+    if (poll(fds.data(), fds.size(), timeout_ms) <= 0) return;
+    uint64_t rx_us = now_us();
+
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (!(fds[i].revents & (POLLIN | POLLHUP))) continue;
+        Child &c = g_children[i];
+        char buf[4096];
+        for (;;) {
+            ssize_t n = read(c.out, buf, sizeof(buf));
+            if (n > 0) {
+                c.partial.append(buf, (size_t)n);
+                continue;
+            }
+            if (n == 0) {
+                c.dead = true;
+                fprintf(stderr, "%s exited (see %s.log)\n", c.name.c_str(), c.name.c_str());
+            }
+            break;
+        }
+        size_t nl;
+        while ((nl = c.partial.find('\n')) != std::string::npos) {
+            on_line(c, c.partial.substr(0, nl), rx_us);
+            c.partial.erase(0, nl + 1);
+        }
+    }
+}
+
+// Pump until a queued line of c satisfies match (consumed), or timeout
+static bool wait_for(Child &c, const std::function<bool(const std::string &)> &match,
+                     int timeout_ms, std::string *found = nullptr)
+{
+    uint64_t deadline = now_us() + (uint64_t)timeout_ms * 1000u;
+    for (;;) {
+        for (auto it = c.lines.begin(); it != c.lines.end(); ++it) {
+            if (match(*it)) {
+                if (found) *found = *it;
+                c.lines.erase(c.lines.begin(), it + 1);
+                return true;
+            }
+        }
+        uint64_t now = now_us();
+        if (c.dead || now >= deadline) return false;
+        pump((int)std::min<uint64_t>((deadline - now) / 1000u + 1, 100));
+    }
+}
+
+static bool starts_with(const std::string &s, const char *prefix)
+{
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+static int poll_period_ms(const Options &opt)
+{
+    if (opt.poll_ms > 0) return opt.poll_ms;
+    return std::min((int)(1000.0 / opt.rate), CHILD_TIMEOUT_S * 1000 / 4);
+}
+
+// Run an OT CLI command and wait for Done / Error; output lines go to *out
+static bool cli(Child &c, const std::string &cmd, std::vector<std::string> *out = nullptr,
+                int timeout_ms = 5000)
+{
+    c.lines.clear();
+    send_line(c, cmd);
+    std::string last;
+    bool ok = wait_for(c, [&](const std::string &l) {
+        if (l == cmd) return false;                        // echo
+        if (l == "Done" || starts_with(l, "Error ")) return true;
+        if (out) out->push_back(l);
+        return false;
+    }, timeout_ms, &last);
+    return ok && last == "Done";
+}
+
+static uint64_t proc_cpu_ticks(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    char buf[1024];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    // Fields after the ")" closing the command name; utime and stime are 14/15
+    const char *p = strrchr(buf, ')');
+    if (!p) return 0;
+    unsigned long long utime = 0, stime = 0;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) {
+        return 0;
+    }
+    return utime + stime;
+}
+
+static double percentile(std::vector<double> &sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)std::lround(p * (double)(sorted.size() - 1));
+    return sorted[i];
+}
+
+static void shutdown_children()
+{
+    for (Child &c : g_children) {
+        if (c.pid > 0) kill(c.pid, SIGTERM);
+    }
+    for (Child &c : g_children) {
+        if (c.pid > 0) waitpid(c.pid, nullptr, 0);
+    }
+}
+
+// --- Phases ---
+
+static bool form_network(Child &leader)
+{
+    // The Commissioner answers FORM_NET immediately, then reports
+    // NETWORK_FORMED once the dataset is committed.
+    for (int attempt = 0; attempt < 10; attempt++) {
+        send_line(leader, "FORM_NET mesh_bench");
+        if (wait_for(leader, [](const std::string &l) { return l == "NETWORK_FORMED"; }, 10000)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool start_nodes(const Options &opt, int first, int count, bool sed)
+{
+    for (int i = 0; i < count; i++) {
+        Child c;
+        c.node_id = first + i;
+        c.is_sed = sed;
+        c.name = (sed ? "sed-" : "router-") + std::to_string(c.node_id);
+        if (!spawn(c, { sed ? opt.mtd : opt.ftd, std::to_string(c.node_id) }, c.name + ".log")) return false;
+        g_children.push_back(c);
+    }
+    return true;
+}
+
+// Commission devices [first, last) of g_children; returns the number joined
+static int commission(const Options &opt, size_t first, size_t last)
+{
+    Child &leader = g_children[0];
+    int joined = 0;
+
+    for (size_t i = first; i < last; i++) {
+        std::vector<std::string> out;
+        if (!cli(g_children[i], "eui64", &out) || out.empty()) {
+            fprintf(stderr, "%s: no EUI64\n", g_children[i].name.c_str());
+            continue;
+        }
+        g_children[i].eui64 = out.back();
+        cli(g_children[i], "ifconfig up");
+    }
+
+    for (size_t start = first; start < last; start += (size_t)opt.batch) {
+        size_t end = std::min(last, start + (size_t)opt.batch);
+
+        std::string cmd = "ADD_BATCH ";
+        size_t added = 0;
+        for (size_t i = start; i < end; i++) {
+            if (g_children[i].eui64.empty()) continue;
+            if (added++) cmd += ",";
+            cmd += g_children[i].eui64 + ":" + PSKD;
+        }
+        if (!added) continue;
+
+        // The Commissioner petitions a few seconds after becoming leader
+        std::string rsp;
+        bool accepted = false;
+        for (int attempt = 0; attempt < 30 && !accepted; attempt++) {
+            leader.lines.clear();
+            send_line(leader, cmd);
+            if (!wait_for(leader, [](const std::string &l) {
+                    return starts_with(l, "BATCH_ACCEPTED") || starts_with(l, "ERROR");
+                }, 5000, &rsp)) {
+                continue;
+            }
+            accepted = starts_with(rsp, "BATCH_ACCEPTED");
+            if (!accepted) sleep(1);
+        }
+        if (!accepted) {
+            fprintf(stderr, "ADD_BATCH rejected: %s\n", rsp.c_str());
+            return joined;
+        }
+
+        for (size_t i = start; i < end; i++) {
+            Child &c = g_children[i];
+            if (c.eui64.empty()) continue;
+            c.lines.clear();
+            send_line(c, std::string("joiner start ") + PSKD);
+        }
+        for (size_t i = start; i < end; i++) {
+            Child &c = g_children[i];
+            if (c.eui64.empty()) continue;
+            std::string result;
+            wait_for(c, [](const std::string &l) { return starts_with(l, "Join "); }, 60000, &result);
+            c.joined = result == "Join success";
+            if (!c.joined) fprintf(stderr, "%s: %s\n", c.name.c_str(), result.empty() ? "join timeout" : result.c_str());
+        }
+
+        std::string done;
+        if (wait_for(leader, [](const std::string &l) { return starts_with(l, "BATCH DONE"); }, 30000, &done)) {
+            printf("  %s\n", done.c_str());
+        }
+
+        for (size_t i = start; i < end; i++) {
+            Child &c = g_children[i];
+            if (!c.joined) continue;
+            joined++;
+            if (c.is_sed) {
+                cli(c, "mode -");
+                cli(c, "pollperiod " + std::to_string(poll_period_ms(opt)));
+            }
+            cli(c, "thread start");
+        }
+    }
+    return joined;
+}
+
+static int wait_attached(size_t first, size_t last, int timeout_ms)
+{
+    uint64_t deadline = now_us() + (uint64_t)timeout_ms * 1000u;
+    int attached = 0;
+    while (now_us() < deadline) {
+        attached = 0;
+        for (size_t i = first; i < last; i++) {
+            Child &c = g_children[i];
+            if (!c.joined || c.dead) continue;
+            if (!c.attached) {
+                std::vector<std::string> out;
+                if (cli(c, "state", &out) && !out.empty()) {
+                    c.attached = out.back() == "child" || out.back() == "router" || out.back() == "leader";
+                }
+            }
+            if (c.attached) attached++;
+        }
+        int expected = 0;
+        for (size_t i = first; i < last; i++) expected += g_children[i].joined && !g_children[i].dead;
+        if (attached == expected) break;
+        pump(500);
+    }
+    return attached;
+}
+
+static std::string udp_stats(Child &leader, bool reset)
+{
+    std::string rsp;
+    leader.lines.clear();
+    send_line(leader, reset ? "UDP_STATS reset" : "UDP_STATS");
+    wait_for(leader, [](const std::string &l) { return starts_with(l, "UDP_STATS") || starts_with(l, "ERROR"); },
+             5000, &rsp);
+    return rsp;
+}
+
+// Radio time split of one node since its last "radio stats clear"
+struct RadioTime {
+    double total_s = 0, tx_s = 0, rx_s = 0, sleep_s = 0;
+};
+
+static bool radio_stats(Child &c, RadioTime &rt)
+{
+    std::vector<std::string> out;
+    if (!cli(c, "radio stats", &out)) return false;
+    for (const std::string &l : out) {
+        double v;
+        if (sscanf(l.c_str(), "Total Time: %lfs", &v) == 1) rt.total_s = v;
+        else if (sscanf(l.c_str(), "Tx Time: %lfs", &v) == 1) rt.tx_s = v;
+        else if (sscanf(l.c_str(), "Rx Time: %lfs", &v) == 1) rt.rx_s = v;
+        else if (sscanf(l.c_str(), "Sleep Time: %lfs", &v) == 1) rt.sleep_s = v;
+    }
+    return rt.total_s > 0;
+}
+
+static std::string make_payload(const Child &c, uint64_t t_us, int size)
+{
+    char head[64];
+    int n = snprintf(head, sizeof(head), "s=%d;q=%u;t=%" PRIu64 ";", c.node_id, c.seq, t_us);
+    std::string p(head, (size_t)n);
+    if ((int)p.size() < size) p.append((size_t)(size - (int)p.size()), 'x');
+    return p;
+}
+
+static void run_load(const Options &opt)
+{
+    std::vector<Child *> senders;
+    for (Child &c : g_children) {
+        if (c.is_sed && c.attached) senders.push_back(&c);
+    }
+
+    double period_us = 1e6 / opt.rate;
+    uint64_t start = now_us();
+    for (size_t i = 0; i < senders.size(); i++) {
+        Child &c = *senders[i];
+        cli(c, "udp open");
+        // Spread the first sends over one period so nodes don't fire in lockstep
+        c.next_send_us = start + (uint64_t)(period_us * (double)i / (double)senders.size());
+    }
+
+    g_measuring = true;
+    uint64_t end = start + (uint64_t)opt.duration * 1000000u;
+    uint64_t now;
+    while ((now = now_us()) < end) {
+        uint64_t next = end;
+        for (Child *c : senders) {
+            if (c->dead) continue;
+            if (c->next_send_us <= now) {
+                std::string payload = make_payload(*c, now_us(), opt.size);
+                send_line(*c, "udp send " + opt.dest + " 1234 " + payload);
+                c->pending_acks++;
+                c->seq++;
+                c->next_send_us += (uint64_t)period_us;
+            }
+            next = std::min(next, c->next_send_us);
+        }
+        now = now_us();
+        pump(next > now ? (int)std::min<uint64_t>((next - now) / 1000u, 50) : 0);
+    }
+
+    // Let in-flight datagrams (parents hold nothing for uplink, but the
+    // mesh may retry) and the listener's output drain.
+    uint64_t drain_end = now_us() + 3000000u;
+    while (now_us() < drain_end) pump(100);
+    g_measuring = false;
+}
+
+static void report(const Options &opt, uint64_t cpu_ticks, const std::string &stats_line,
+                   const RadioTime &radio, int radio_nodes)
+{
+    uint32_t sent = 0, errors = 0, attempted = 0;
+    uint32_t received_unique = 0;
+    for (Child &c : g_children) {
+        if (!c.is_sed) continue;
+        sent += c.sent_ok;
+        errors += c.send_errors;
+        attempted += c.seq;
+        for (uint32_t w : c.rx_seen) received_unique += (uint32_t)__builtin_popcount(w);
+    }
+    uint32_t lost = sent > received_unique ? sent - received_unique : 0;
+
+    std::sort(g_latency_ms.begin(), g_latency_ms.end());
+    double mean = 0;
+    for (double v : g_latency_ms) mean += v;
+    if (!g_latency_ms.empty()) mean /= (double)g_latency_ms.size();
+
+    double cpu_ms = (double)cpu_ticks * 1000.0 / (double)sysconf(_SC_CLK_TCK);
+
+    printf("\n--- mesh_bench: %d SEDs x %.2f/s, %d B payload, %d s ---\n",
+           (int)std::count_if(g_children.begin(), g_children.end(), [](const Child &c) { return c.is_sed && c.attached; }),
+           opt.rate, opt.size, opt.duration);
+    printf("sent        %u (attempted %u, send errors %u)\n", sent, attempted, errors);
+    printf("received    %u unique, %u duplicate, %u foreign\n", received_unique, g_rx_dup, g_rx_foreign);
+    printf("lost        %u (%.2f%%)\n", lost, sent ? 100.0 * lost / sent : 0.0);
+    printf("throughput  %.1f pkt/s at the listener\n", (double)received_unique / opt.duration);
+    printf("latency ms  mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", mean,
+           percentile(g_latency_ms, 0.50), percentile(g_latency_ms, 0.90),
+           percentile(g_latency_ms, 0.99), percentile(g_latency_ms, 1.0));
+    printf("listener    %s\n", stats_line.empty() ? "(no UDP_STATS reply)" : stats_line.c_str());
+    printf("cpu         %.1f ms Commissioner total, %.3f ms per received packet\n",
+           cpu_ms, g_rx_total ? cpu_ms / g_rx_total : 0.0);
+    if (radio_nodes > 0 && radio.total_s > 0) {
+        printf("sed radio   poll %d ms: rx %.2f%%  tx %.2f%%  sleep %.2f%%  (%.1f ms on per SED-second, %d SEDs)\n",
+               poll_period_ms(opt), 100.0 * radio.rx_s / radio.total_s,
+               100.0 * radio.tx_s / radio.total_s, 100.0 * radio.sleep_s / radio.total_s,
+               1000.0 * (radio.rx_s + radio.tx_s) / radio.total_s, radio_nodes);
+    } else {
+        printf("sed radio   (no \"radio stats\" from the SEDs: OpenThread built without radio stats)\n");
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s --commissioner PATH --ftd PATH --mtd PATH [options]\n"
+            "  --seds N        sleepy end devices sending telemetry (default 10)\n"
+            "  --routers N     extra FTD routers to parent the SEDs (default N/8)\n"
+            "  --rate HZ       datagrams per second per SED (default 1)\n"
+            "  --size BYTES    payload size (default 32, min ~30 for the header)\n"
+            "  --duration S    load phase length (default 30)\n"
+            "  --batch N       devices per ADD_BATCH (default 8)\n"
+            "  --poll-ms MS    SED poll period, or \"auto\" for one poll per report (default 1000)\n"
+            "  --dest ADDR     destination address (default ff03::2)\n"
+            "  --workdir DIR   node logs and simulated flash (default: new dir in /tmp)\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (a == "--commissioner") opt.commissioner = v;
+        else if (a == "--ftd") opt.ftd = v;
+        else if (a == "--mtd") opt.mtd = v;
+        else if (a == "--seds") opt.seds = atoi(v);
+        else if (a == "--routers") opt.routers = atoi(v);
+        else if (a == "--rate") opt.rate = atof(v);
+        else if (a == "--size") opt.size = atoi(v);
+        else if (a == "--duration") opt.duration = atoi(v);
+        else if (a == "--batch") opt.batch = std::max(1, std::min(16, atoi(v)));
+        else if (a == "--poll-ms") opt.poll_ms = strcmp(v, "auto") == 0 ? 0 : atoi(v);
+        else if (a == "--dest") opt.dest = v;
+        else if (a == "--workdir") opt.workdir = v;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (opt.commissioner.empty() || opt.ftd.empty() || opt.mtd.empty() || opt.rate <= 0 || opt.seds <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (opt.routers < 0) opt.routers = opt.seds / 8;
+
+    // Binaries are exec'd after the chdir below
+    char resolved[PATH_MAX];
+    for (std::string *p : { &opt.commissioner, &opt.ftd, &opt.mtd }) {
+        if (!realpath(p->c_str(), resolved)) {
+            perror(p->c_str());
+            return 1;
+        }
+        *p = resolved;
+    }
+
+    if (opt.workdir.empty()) {
+        char tmpl[] = "/tmp/mesh_bench.XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        opt.workdir = tmpl;
+    } else {
+        mkdir(opt.workdir.c_str(), 0755);
+    }
+    if (chdir(opt.workdir.c_str()) != 0) {
+        perror(opt.workdir.c_str());
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    printf("work dir %s\n", opt.workdir.c_str());
+
+    Child leader;
+    leader.name = "commissioner";
+    leader.node_id = LEADER_NODE_ID;
+    if (!spawn(leader, { opt.commissioner, std::to_string(LEADER_NODE_ID) }, "commissioner.log")) return 1;
+    g_children.push_back(leader);
+
+    int rc = 1;
+    do {
+        uint64_t t0 = now_us();
+        if (!form_network(g_children[0])) {
+            fprintf(stderr, "network not formed\n");
+            break;
+        }
+        printf("network formed in %.1f s\n", (double)(now_us() - t0) / 1e6);
+
+        int first_router = LEADER_NODE_ID + 1;
+        int first_sed = first_router + opt.routers;
+        if (!start_nodes(opt, first_router, opt.routers, false) ||
+            !start_nodes(opt, first_sed, opt.seds, true)) {
+            break;
+        }
+        sleep(1);
+
+        // Routers first so the SEDs find parents with room
+        t0 = now_us();
+        size_t routers_end = 1 + (size_t)opt.routers;
+        int joined_routers = commission(opt, 1, routers_end);
+        wait_attached(1, routers_end, 60000);
+        int joined_seds = commission(opt, routers_end, g_children.size());
+        int attached = wait_attached(routers_end, g_children.size(), 60000);
+        printf("commissioned %d routers, %d SEDs (%d attached) in %.1f s\n",
+               joined_routers, joined_seds, attached, (double)(now_us() - t0) / 1e6);
+        if (attached == 0) {
+            fprintf(stderr, "no SED attached\n");
+            break;
+        }
+
+        udp_stats(g_children[0], true);
+        for (Child &c : g_children) {
+            if (c.is_sed && c.attached) cli(c, "radio stats clear");
+        }
+        uint64_t cpu0 = proc_cpu_ticks(g_children[0].pid);
+        run_load(opt);
+        uint64_t cpu1 = proc_cpu_ticks(g_children[0].pid);
+        std::string stats = udp_stats(g_children[0], false);
+
+        // Summed over the SEDs, so the percentages are the mean duty cycle
+        RadioTime radio;
+        int radio_nodes = 0;
+        for (Child &c : g_children) {
+            RadioTime rt;
+            if (!c.is_sed || !c.attached || c.dead || !radio_stats(c, rt)) continue;
+            radio.total_s += rt.total_s;
+            radio.tx_s += rt.tx_s;
+            radio.rx_s += rt.rx_s;
+            radio.sleep_s += rt.sleep_s;
+            radio_nodes++;
+        }
+
+        report(opt, cpu1 - cpu0, stats, radio, radio_nodes);
+        rc = 0;
+    } while (false);
+
+    shutdown_children();
+    return rc;
+}
@@ -0,0 +1,361 @@
+// Replays recorded sensor data through the SED report-on-change policy
+// (common/hvac_report_policy.h) and reports how many packets it saves and
+// how far a receiver holding the last report strays from the real value.
+//
+//   onchange_replay <file.csv> [--deadband V[,V...]] [--slope V[,V...]]
+//                   [--heartbeat S] [--sensor ID]
+//
+// Reads the Bridge's old env_log.csv ("Date,Time,TempC,Humidity,...") or
+// the CSV written by log_export ("Epoch,DateTime,Sensor,Seq,..."); with the
+// latter, --sensor picks the sensor (default: the first one in the file).
+// The "_F" columns log_export derives from "_C" channels are not replayed.
+// Thresholds are physical units per channel, slope per minute; the last
+// value given applies to the remaining channels. Defaults match the SED:
+// 0.2 deadband, 1/min slope, 600 s heartbeat; --heartbeat 0 reports every
+// sample.
+//
+// Each channel is quantized with the largest scale of 100, 10 or 1 that
+// fits its range in int16, as the binary report would carry it; channels
+// that do not fit even unscaled (e.g. gas resistance) are left out. The
+// reconstruction error of a sample is |logged value - value last reported|,
+// so it includes that quantization.
+
+#include <hvac_report_policy.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+struct Options {
+    const char *path = nullptr;
+    std::vector<double> deadband = { 0.2 };
+    std::vector<double> slope = { 1.0 };
+    unsigned heartbeat = HVAC_REPORT_DEFAULT_HEARTBEAT_S;
+    long sensor = -1;
+};
+
+struct Row {
+    uint32_t t;
+    double value[HVAC_PAYLOAD_MAX_CHANNELS];
+};
+
+struct Series {
+    std::vector<std::string> names;
+    std::vector<Row> rows;
+    long sensor = -1;
+};
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s <file.csv> [--deadband V[,V...]] [--slope V[,V...]] [--heartbeat S]"
+            " [--sensor ID]\n",
+            argv0);
+}
+
+static std::vector<std::string> split(const std::string &line)
+{
+    std::vector<std::string> out;
+    size_t start = 0;
+    for (;;) {
+        size_t comma = line.find(',', start);
+        out.push_back(line.substr(start, comma == std::string::npos ? std::string::npos
+                                                                    : comma - start));
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    if (!out.empty() && !out.back().empty() && out.back().back() == '\r') out.back().pop_back();
+    return out;
+}
+
+static bool parse_values(const char *arg, std::vector<double> &out)
+{
+    out.clear();
+    const char *p = arg;
+    for (;;) {
+        char *end;
+        double v = strtod(p, &end);
+        if (end == p || v < 0 || (*end != ',' && *end != '\0')) return false;
+        out.push_back(v);
+        if (*end == '\0') return true;
+        p = end + 1;
+    }
+}
+
+// "D-M-YYYY","H:M:S" as the Bridge's RTC wrote them, or "N/A","<uptime>s"
+static bool parse_legacy_time(const std::string &date, const std::string &time, uint32_t &t)
+{
+    unsigned long up;
+    char unit;
+    if (sscanf(time.c_str(), "%lu%c", &up, &unit) == 2 && unit == 's') {
+        t = (uint32_t)up;
+        return true;
+    }
+    struct tm tm = {};
+    if (sscanf(date.c_str(), "%d-%d-%d", &tm.tm_mday, &tm.tm_mon, &tm.tm_year) != 3 ||
+        sscanf(time.c_str(), "%d:%d:%d", &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 3) {
+        return false;
+    }
+    tm.tm_mon -= 1;
+    tm.tm_year -= 1900;
+    t = (uint32_t)timegm(&tm);
+    return true;
+}
+
+static bool load(const Options &opt, Series &s)
+{
+    FILE *f = fopen(opt.path, "r");
+    if (!f) {
+        perror(opt.path);
+        return false;
+    }
+
+    std::string line;
+    std::vector<std::string> header;
+    bool exported = false;
+    std::vector<size_t> channel_col;  // CSV column of each replayed channel
+    uint32_t skipped = 0;
+    char buf[512];
+
+    while (fgets(buf, sizeof(buf), f)) {
+        line = buf;
+        if (!line.empty() && line.back() == '\n') line.pop_back();
+        if (line.empty()) continue;
+        std::vector<std::string> col = split(line);
+
+        if (header.empty()) {
+            header = col;
+            exported = header[0] == "Epoch";
+            if (!exported && header[0] != "Date") {
+                fprintf(stderr, "%s: expected an env_log.csv or log_export header\n", opt.path);
+                fclose(f);
+                return false;
+            }
+            for (size_t c = exported ? 4 : 2; c < header.size(); c++) {
+                const std::string &name = header[c];
+                if (exported && c > 4 && name.size() > 2 &&
+                    name.compare(name.size() - 2, 2, "_F") == 0 &&
+                    header[c - 1] == name.substr(0, name.size() - 1) + "C") {
+                    continue;
+                }
+                if (s.names.size() == HVAC_PAYLOAD_MAX_CHANNELS) {
+                    fprintf(stderr, "%s: only the first %d channels are replayed\n", opt.path,
+                            HVAC_PAYLOAD_MAX_CHANNELS);
+                    break;
+                }
+                s.names.push_back(name);
+                channel_col.push_back(c);
+            }
+            s.sensor = opt.sensor;
+            continue;
+        }
+
+        if (!channel_col.empty() && col.size() <= channel_col.back()) {
+            skipped++;
+            continue;
+        }
+
+        Row r;
+        char *end;
+        if (exported) {
+            long sensor = strtol(col[2].c_str(), &end, 10);
+            if (s.sensor < 0) s.sensor = sensor;
+            if (sensor != s.sensor) continue;
+            r.t = (uint32_t)strtoul(col[0].c_str(), &end, 10);
+        } else if (!parse_legacy_time(col[0], col[1], r.t)) {
+            skipped++;
+            continue;
+        }
+
+        // Invalid and missing readings are exported as empty fields (NAN here)
+        bool ok = true;
+        for (size_t c = 0; c < s.names.size() && ok; c++) {
+            const std::string &v = col[channel_col[c]];
+            r.value[c] = v.empty() ? NAN : strtod(v.c_str(), &end);
+            ok = v.empty() || *end == '\0';
+        }
+        if (ok) {
+            s.rows.push_back(r);
+        } else {
+            skipped++;
+        }
+    }
+    fclose(f);
+
+    // A channel with no reading at all (probe not fitted) is left out rather
+    // than costing every row; then rows missing any remaining channel go.
+    std::vector<std::string> names;
+    for (size_t c = 0; c < s.names.size(); c++) {
+        bool seen = std::any_of(s.rows.begin(), s.rows.end(),
+                                [c](const Row &r) { return !std::isnan(r.value[c]); });
+        if (!seen) {
+            fprintf(stderr, "%s: %s has no readings, left out\n", opt.path, s.names[c].c_str());
+            continue;
+        }
+        for (Row &r : s.rows) r.value[names.size()] = r.value[c];
+        names.push_back(s.names[c]);
+    }
+    s.names = names;
+    size_t kept = 0;
+    for (const Row &r : s.rows) {
+        bool full = std::none_of(r.value, r.value + s.names.size(),
+                                 [](double v) { return std::isnan(v); });
+        if (full) s.rows[kept++] = r;
+        else skipped++;
+    }
+    s.rows.resize(kept);
+
+    if (skipped) fprintf(stderr, "%s: skipped %u unreadable rows\n", opt.path, skipped);
+    return true;
+}
+
+// 0 if the channel does not fit int16 at all
+static uint16_t pick_scale(const Series &s, size_t c)
+{
+    double peak = 0;
+    for (const Row &r : s.rows) peak = std::max(peak, std::fabs(r.value[c]));
+    for (uint16_t scale : { 100, 10, 1 }) {
+        if (peak * scale <= 32767.0) return scale;
+    }
+    return 0;
+}
+
+// Drop the channels pick_scale() rejects; returns the scales of the rest
+static std::vector<uint16_t> fit_channels(const char *path, Series &s)
+{
+    std::vector<uint16_t> scales;
+    std::vector<std::string> names;
+    for (size_t c = 0; c < s.names.size(); c++) {
+        uint16_t scale = pick_scale(s, c);
+        if (!scale) {
+            fprintf(stderr, "%s: %s exceeds int16, left out\n", path, s.names[c].c_str());
+            continue;
+        }
+        for (Row &r : s.rows) r.value[names.size()] = r.value[c];
+        names.push_back(s.names[c]);
+        scales.push_back(scale);
+    }
+    s.names = names;
+    return scales;
+}
+
+static double at(const std::vector<double> &v, size_t c)
+{
+    return v[std::min(c, v.size() - 1)];
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a[0] != '-' && !opt.path) {
+            opt.path = argv[i];
+            continue;
+        }
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) {
+            usage(argv[0]);
+            return 2;
+        }
+        bool ok = true;
+        if (a == "--deadband") ok = parse_values(v, opt.deadband);
+        else if (a == "--slope") ok = parse_values(v, opt.slope);
+        else if (a == "--heartbeat") opt.heartbeat = (unsigned)atoi(v);
+        else if (a == "--sensor") opt.sensor = atol(v);
+        else ok = false;
+        if (!ok || opt.heartbeat > 0xFFFF) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (!opt.path) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Series s;
+    if (!load(opt, s)) return 1;
+    std::vector<uint16_t> scale = fit_channels(opt.path, s);
+    if (s.rows.empty() || s.names.empty()) {
+        fprintf(stderr, "%s: no samples\n", opt.path);
+        return 1;
+    }
+    const uint8_t channels = (uint8_t)s.names.size();
+
+    hvac_report_config_t cfg = {};
+    cfg.heartbeat_s = (uint16_t)opt.heartbeat;
+    cfg.channel_count = channels;
+    for (uint8_t c = 0; c < channels; c++) {
+        cfg.deadband[c] = (uint16_t)hvac_payload_quantize((float)at(opt.deadband, c), scale[c]);
+        cfg.slope[c] = (uint16_t)hvac_payload_quantize((float)at(opt.slope, c), scale[c]);
+    }
+
+    // Replay: the receiver holds the last reported value of each channel
+    hvac_report_state_t state = {};
+    uint32_t by_reason[HVAC_REPORT_HEARTBEAT + 1] = {};
+    uint32_t reports = 0, longest_gap = 0, last_report_t = 0;
+    double held[HVAC_PAYLOAD_MAX_CHANNELS] = {};
+    double max_err[HVAC_PAYLOAD_MAX_CHANNELS] = {};
+    double sq_err[HVAC_PAYLOAD_MAX_CHANNELS] = {};
+    std::vector<uint32_t> intervals;
+
+    for (size_t i = 0; i < s.rows.size(); i++) {
+        const Row &r = s.rows[i];
+        int16_t q[HVAC_PAYLOAD_MAX_CHANNELS];
+        for (uint8_t c = 0; c < channels; c++) q[c] = hvac_payload_quantize((float)r.value[c], scale[c]);
+
+        hvac_report_reason_t why = hvac_report_decide(&cfg, &state, q, channels, r.t);
+        if (why != HVAC_REPORT_SKIP) {
+            by_reason[why]++;
+            if (reports++) longest_gap = std::max(longest_gap, r.t - last_report_t);
+            last_report_t = r.t;
+            for (uint8_t c = 0; c < channels; c++) held[c] = (double)q[c] / scale[c];
+        }
+        for (uint8_t c = 0; c < channels; c++) {
+            double err = std::fabs(r.value[c] - held[c]);
+            max_err[c] = std::max(max_err[c], err);
+            sq_err[c] += err * err;
+        }
+        if (i) intervals.push_back(r.t - s.rows[i - 1].t);
+    }
+
+    const size_t n = s.rows.size();
+    uint32_t median = 0;
+    if (!intervals.empty()) {
+        std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+        median = intervals[intervals.size() / 2];
+    }
+
+    printf("%s: %zu samples", opt.path, n);
+    if (s.sensor >= 0) printf(" from sensor %ld", s.sensor);
+    printf(", %u channels, median interval %us\n", channels, median);
+    printf("policy: heartbeat %us, deadband", cfg.heartbeat_s);
+    for (uint8_t c = 0; c < channels; c++) printf("%s%g", c ? "," : " ", at(opt.deadband, c));
+    printf(", slope");
+    for (uint8_t c = 0; c < channels; c++) printf("%s%g", c ? "," : " ", at(opt.slope, c));
+    printf("/min\n\n");
+
+    printf("reports %u of %zu samples: %.1f%% fewer packets, longest gap %us\n", reports, n,
+           100.0 * (double)(n - reports) / n, longest_gap);
+    printf(" ");
+    for (int why = HVAC_REPORT_ALWAYS; why <= HVAC_REPORT_HEARTBEAT; why++) {
+        if (by_reason[why]) {
+            printf(" %s=%u", hvac_report_reason_name((hvac_report_reason_t)why), by_reason[why]);
+        }
+    }
+    printf("\n\n");
+
+    printf("%-12s %6s %10s %10s %10s\n", "channel", "scale", "deadband", "max_err", "rms_err");
+    for (uint8_t c = 0; c < channels; c++) {
+        printf("%-12s %6u %10g %10.3f %10.3f\n", s.names[c].c_str(), scale[c],
+               (double)cfg.deadband[c] / scale[c], max_err[c], std::sqrt(sq_err[c] / n));
+    }
+    return 0;
+}
@@ -0,0 +1,313 @@
+// Host decoder and benchmark for the binary sensor report
+// (common/hvac_sensor_payload.h).
+//
+//   payload_bench --decode HEX [HEX ...]
+//   payload_bench [--type T] [--reports N] [--key N] [--noise X]
+//
+// --decode prints the reports in each datagram given as a hex string (as
+// captured off the air); a batched datagram yields one line per sample.
+// Datagrams are decoded in order as one sender, so delta reports resolve
+// against the ones before them.
+//
+// The benchmark generates N reports of a slowly drifting sensor of type T
+// and times encoding and decoding them as "name=value" text (the format
+// SED_SENSOR_BARE sent so far, parsed the way telemetry_parse_text() does)
+// and as binary with absolute values only and with delta coding. Sizes are
+// UDP payload bytes; UDP/6LoWPAN/MAC headers are the same for all formats.
+
+#include <hvac_sensor_payload.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Options {
+    uint8_t type = HVAC_SENSOR_ENV;
+    int reports = 200000;
+    int key = HVAC_PAYLOAD_KEY_INTERVAL;
+    double noise = 0.02;  // random-walk step, in units of each channel's resolution x 100
+};
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s --decode HEX [HEX ...]\n"
+            "       %s [--type T] [--reports N] [--key N] [--noise X]\n",
+            argv0, argv0);
+}
+
+static bool parse_hex(const char *s, std::vector<uint8_t> &out)
+{
+    out.clear();
+    size_t n = strlen(s);
+    if (n % 2) return false;
+    for (size_t i = 0; i < n; i += 2) {
+        char byte[3] = { s[i], s[i + 1], 0 };
+        char *end;
+        unsigned long v = strtoul(byte, &end, 16);
+        if (*end) return false;
+        out.push_back((uint8_t)v);
+    }
+    return true;
+}
+
+static int decode_main(int count, char **hex)
+{
+    static const char *status_names[] = { "ok", "format", "version", "no_ref" };
+    hvac_payload_ref_t ref = {};
+    int failures = 0;
+
+    for (int i = 0; i < count; i++) {
+        std::vector<uint8_t> data;
+        if (!parse_hex(hex[i], data)) {
+            printf("%s: not a hex string\n", hex[i]);
+            failures++;
+            continue;
+        }
+
+        for (size_t off = 0; off < data.size();) {
+            size_t len = hvac_payload_length(&data[off], data.size() - off);
+            hvac_payload_t p;
+            hvac_payload_status_t st =
+                len ? hvac_payload_decode(&data[off], len, &ref, &p) : HVAC_PAYLOAD_ERR_FORMAT;
+            if (st != HVAC_PAYLOAD_OK) {
+                printf("%s+%zu: error %s\n", hex[i], off, status_names[st]);
+                failures++;
+                if (!len) break;
+                off += len;
+                continue;
+            }
+
+            uint8_t n;
+            const hvac_channel_desc_t *desc = hvac_sensor_channels(p.type, &n);
+            printf("type=%u seq=%u%s", p.type, p.seq, (p.flags & HVAC_PAYLOAD_F_DELTA) ? " delta" : "");
+            if (p.flags & HVAC_PAYLOAD_F_TIME) printf(" age=%us", p.age_s);
+            for (uint8_t c = 0; c < p.channel_count && c < n; c++) {
+                printf(" %s=%g", desc[c].name, (double)hvac_payload_value(&p, c));
+            }
+            printf("  (%zu bytes)\n", len);
+            off += len;
+        }
+    }
+    return failures ? 1 : 0;
+}
+
+// --- benchmark ---
+
+struct Sample {
+    uint16_t seq;
+    float value[HVAC_PAYLOAD_MAX_CHANNELS];
+};
+
+static std::vector<Sample> make_samples(const Options &opt, uint8_t channels,
+                                        const hvac_channel_desc_t *desc)
+{
+    static const float start[] = { 22.5f, 41.0f, 1013.2f, 19.0f, 20.0f, 21.0f };
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> step(0.0f, (float)opt.noise);
+
+    std::vector<Sample> out(opt.reports);
+    float v[HVAC_PAYLOAD_MAX_CHANNELS];
+    for (uint8_t c = 0; c < channels; c++) v[c] = start[c];
+    for (int i = 0; i < opt.reports; i++) {
+        out[i].seq = (uint16_t)i;
+        for (uint8_t c = 0; c < channels; c++) {
+            v[c] += step(rng) * 100.0f / desc[c].scale;
+            // Keep values on the quantization grid so text and binary agree
+            out[i].value[c] = std::round(v[c] * desc[c].scale) / desc[c].scale;
+        }
+    }
+    return out;
+}
+
+static size_t encode_text(const Sample &s, uint8_t channels, const hvac_channel_desc_t *desc,
+                          char *out, size_t len)
+{
+    int n = snprintf(out, len, "seq=%u", s.seq);
+    for (uint8_t c = 0; c < channels; c++) {
+        n += snprintf(out + n, len - n, ";%s=%g", desc[c].name, (double)s.value[c]);
+    }
+    return (size_t)n;
+}
+
+// Same rules as telemetry_parse_text() on the Commissioner
+static int decode_text(const char *text, uint32_t *seq, float *values)
+{
+    int count = 0;
+    const char *p = text;
+    while (*p) {
+        size_t tok = strcspn(p, ";,& ");
+        const char *eq = (const char *)memchr(p, '=', tok);
+        if (eq && eq > p) {
+            char value[24];
+            size_t key_len = (size_t)(eq - p);
+            size_t val_len = tok - key_len - 1;
+            if (val_len > 0 && val_len < sizeof(value)) {
+                memcpy(value, eq + 1, val_len);
+                value[val_len] = '\0';
+                char *end;
+                if (key_len == 3 && strncmp(p, "seq", 3) == 0) {
+                    *seq = (uint32_t)strtoul(value, &end, 10);
+                } else if (count < HVAC_PAYLOAD_MAX_CHANNELS) {
+                    float v = strtof(value, &end);
+                    if (*end == '\0') values[count++] = v;
+                }
+            }
+        }
+        p += tok;
+        if (*p) p++;
+    }
+    return count;
+}
+
+struct Result {
+    const char *name;
+    double bytes_per_report;
+    double encode_ns;
+    double decode_ns;
+    int mismatches;
+};
+
+template <typename Fn>
+static double time_ns_per(int n, Fn fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+}
+
+static Result bench_text(const std::vector<Sample> &samples, uint8_t channels,
+                         const hvac_channel_desc_t *desc)
+{
+    const int n = (int)samples.size();
+    std::vector<char> buf((size_t)n * 96);
+    std::vector<uint16_t> len(n);
+    size_t total = 0;
+
+    Result r = { "text", 0, 0, 0, 0 };
+    r.encode_ns = time_ns_per(n, [&] {
+        for (int i = 0; i < n; i++) {
+            len[i] = (uint16_t)encode_text(samples[i], channels, desc, &buf[(size_t)i * 96], 96);
+        }
+    });
+    for (int i = 0; i < n; i++) total += len[i];
+
+    volatile float sink = 0;
+    r.decode_ns = time_ns_per(n, [&] {
+        for (int i = 0; i < n; i++) {
+            uint32_t seq = 0;
+            float v[HVAC_PAYLOAD_MAX_CHANNELS];
+            int got = decode_text(&buf[(size_t)i * 96], &seq, v);
+            sink = sink + v[0];
+            if (got != channels || seq != samples[i].seq) r.mismatches++;
+        }
+    });
+    r.bytes_per_report = (double)total / n;
+    return r;
+}
+
+static Result bench_binary(const char *name, const std::vector<Sample> &samples, uint8_t type,
+                           uint8_t channels, uint16_t key)
+{
+    const int n = (int)samples.size();
+    std::vector<uint8_t> buf((size_t)n * HVAC_PAYLOAD_MAX_LEN);
+    std::vector<uint8_t> len(n);
+    size_t total = 0;
+
+    // Quantize outside the timed loop, as the firmware reads raw values anyway
+    std::vector<hvac_payload_t> reports(n);
+    for (int i = 0; i < n; i++) {
+        hvac_payload_t &p = reports[i];
+        memset(&p, 0, sizeof(p));
+        p.type = type;
+        p.seq = samples[i].seq;
+        for (uint8_t c = 0; c < channels; c++) hvac_payload_set(&p, c, samples[i].value[c]);
+    }
+
+    Result r = { name, 0, 0, 0, 0 };
+    hvac_payload_ref_t tx = {};
+    r.encode_ns = time_ns_per(n, [&] {
+        for (int i = 0; i < n; i++) {
+            len[i] = (uint8_t)hvac_payload_encode(&reports[i], &tx, key,
+                                                  &buf[(size_t)i * HVAC_PAYLOAD_MAX_LEN],
+                                                  HVAC_PAYLOAD_MAX_LEN);
+        }
+    });
+    for (int i = 0; i < n; i++) total += len[i];
+
+    hvac_payload_ref_t rx = {};
+    r.decode_ns = time_ns_per(n, [&] {
+        for (int i = 0; i < n; i++) {
+            hvac_payload_t p;
+            if (hvac_payload_decode(&buf[(size_t)i * HVAC_PAYLOAD_MAX_LEN], len[i], &rx, &p) !=
+                    HVAC_PAYLOAD_OK ||
+                p.seq != reports[i].seq || memcmp(p.ch, reports[i].ch, channels * sizeof(int16_t))) {
+                r.mismatches++;
+            }
+        }
+    });
+    r.bytes_per_report = (double)total / n;
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "--decode") == 0) {
+        if (argc < 3) {
+            usage(argv[0]);
+            return 2;
+        }
+        return decode_main(argc - 2, argv + 2);
+    }
+
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (a == "--type") opt.type = (uint8_t)atoi(v);
+        else if (a == "--reports") opt.reports = atoi(v);
+        else if (a == "--key") opt.key = atoi(v);
+        else if (a == "--noise") opt.noise = atof(v);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (opt.reports <= 0 || opt.key < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    uint8_t channels;
+    const hvac_channel_desc_t *desc = hvac_sensor_channels(opt.type, &channels);
+    std::vector<Sample> samples = make_samples(opt, channels, desc);
+
+    Result results[] = {
+        bench_text(samples, channels, desc),
+        bench_binary("binary", samples, opt.type, channels, 0),
+        bench_binary("binary+delta", samples, opt.type, channels, (uint16_t)opt.key),
+    };
+
+    printf("sensor type %u, %u channels, %d reports, key interval %d\n\n",
+           opt.type, channels, opt.reports, opt.key);
+    printf("%-14s %12s %12s %12s %14s %14s %6s\n", "format", "bytes/report", "encode_ns",
+           "decode_ns", "encode/s", "decode/s", "bad");
+    int bad = 0;
+    for (const Result &r : results) {
+        printf("%-14s %12.2f %12.1f %12.1f %14.0f %14.0f %6d\n", r.name, r.bytes_per_report,
+               r.encode_ns, r.decode_ns, 1e9 / r.encode_ns, 1e9 / r.decode_ns, r.mismatches);
+        bad += r.mismatches;
+    }
+    return bad ? 1 : 0;
+}